@@ -0,0 +1,359 @@
+#include "ai.h"
+#include "sim.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+// A decision costs this many units on top of one per occupied cell and
+// shell checked.
+static const uint32_t kDecisionCost = 16;
+// The shell grid spans the helicopters' flight area in this many cells.
+static const int kShellGridCols = 8;
+static const int kShellGridRows = 6;
+// Shells are checked this many seconds ahead, and count as a hit when they
+// pass within the margin of the helicopter's box.
+static const float kThreatSeconds = 0.6f;
+static const float kThreatMargin = 16.f;
+// A dodging helicopter decides again after this many steps, to keep its
+// dodge on target as the shell closes.
+static const uint32_t kDodgeRecheckSteps = 4;
+// Extra clearance a dodge aims for, and the highest and lowest a helicopter
+// goes (top edge; lowest is counted up from the tank's top).
+static const float kDodgeClearance = 12.f;
+static const float kCeiling = 10.f;
+static const float kFloorAboveTank = 100.f;
+// Steering: climb in proportion to the altitude error, up to the climb
+// rate; change speed at a fixed acceleration.
+static const float kAltitudeGain = 5.f;
+static const float kClimbRate = 220.f;
+static const float kAcceleration = 120.f;
+// Formation: wingmen sit this many helicopter widths back per rank and this
+// many pixels apart in altitude, and close the gap to their slot at this
+// much speed per pixel, within the limit.
+static const float kFormationSpacing = 1.3f;
+static const float kFormationRise = 34.f;
+static const float kFormationGain = 1.5f;
+static const float kFormationMaxCorrection = 50.f;
+
+void InitAiScheduler(AiScheduler& ai, const SimConfig& cfg) {
+    ai.step = 0;
+    ai.cursor = 0;
+    ai.urgent.clear();
+    ai.urgent.reserve(static_cast<size_t>(std::max(cfg.helicopterCount, 0)));
+    // Where helicopters fly, as for World::heliGrid.
+    const float minX = -2.f * cfg.helicopterWidth;
+    const float maxX = cfg.screenWidth + 2.f * cfg.helicopterWidth;
+    ConfigureGrid(ai.shellGrid, minX, 0.f, maxX, cfg.screenHeight, (maxX - minX) / kShellGridCols,
+                  cfg.screenHeight / kShellGridRows);
+    ai.shellGrid.items.reserve(static_cast<size_t>(std::max(cfg.maxShells, 0)));
+    ai.shellCells.reserve(static_cast<size_t>(std::max(cfg.maxShells, 0)));
+    ai.cellReach.assign(ai.shellGrid.cursor.size(), AABB{});
+    ai.busyCells.clear();
+    ai.busyCells.reserve(ai.cellReach.size());
+    ai.decisions = ai.urgentDecisions = ai.cutShort = ai.units = ai.maxWait = 0;
+    ai.stepNs = 0;
+}
+
+void ResetPilot(Helicopter& h, uint32_t step) {
+    h.pilot.cruiseAlt = h.pos.y;
+    h.pilot.cruiseSpeed = h.speed;
+    h.pilot.targetAlt = h.pos.y;
+    h.pilot.targetSpeed = h.speed;
+    h.pilot.threatSeconds = 0.f;
+    h.pilot.decidedStep = step;
+}
+
+Vec2 FormationSlot(const SimConfig& cfg, const Helicopter& leader, int slot) {
+    const int rank = (slot + 1) / 2;
+    const float side = (slot & 1) ? 1.f : -1.f;
+    return { leader.pos.x - static_cast<float>(leader.dir * rank) * kFormationSpacing * cfg.helicopterWidth,
+             leader.pilot.cruiseAlt + side * static_cast<float>(rank) * kFormationRise };
+}
+
+static float Floor(const SimConfig& cfg, const Pilot& p) {
+    // Spawns stacked lower than the floor keep their own altitude.
+    const float floor = TankHome(cfg, 0).y - cfg.tankHeight - kFloorAboveTank - cfg.helicopterHeight;
+    return std::max(floor, p.cruiseAlt);
+}
+
+// How far a shell closes in over the look-ahead: when shell i, falling
+// under gravity, passes through the helicopter's box (grown by the margin)
+// moving at `vel`. On a hit, `seconds` is when it enters the box and
+// [lo, hi] is the span of its height relative to the box's centre while
+// inside (y down).
+static bool ShellThreat(const SimConfig& cfg, const ProjectileSoA& shells, size_t i, Vec2 center, Vec2 vel,
+                        float& seconds, float& lo, float& hi) {
+    const float halfW = cfg.helicopterWidth * 0.5f + kThreatMargin;
+    const float halfH = cfg.helicopterHeight * 0.5f + kThreatMargin;
+    const float rx = shells.x[i] - center.x;
+    const float rvx = shells.vx[i] - vel.x;
+    const float ry = shells.y[i] - center.y;
+    const float rvy = shells.vy[i] - vel.y;
+    const float g = cfg.gravity;
+    // Most shells are nowhere near; reject those before any division.
+    if (std::abs(rx) > halfW + std::abs(rvx) * kThreatSeconds ||
+        std::abs(ry) > halfH + std::abs(rvy) * kThreatSeconds + 0.5f * std::abs(g) * kThreatSeconds * kThreatSeconds) {
+        return false;
+    }
+    float t0 = 0.f;
+    float t1 = kThreatSeconds;
+    if (std::abs(rvx) > 1e-3f) {
+        const float a = (-halfW - rx) / rvx;
+        const float b = (halfW - rx) / rvx;
+        t0 = std::max(t0, std::min(a, b));
+        t1 = std::min(t1, std::max(a, b));
+    } else if (std::abs(rx) > halfW) {
+        return false;
+    }
+    if (t0 > t1) {
+        return false;
+    }
+    // Relative height is a parabola in t; its extremes over [t0, t1] are at
+    // the ends or the vertex.
+    auto height = [&](float t) { return ry + rvy * t + 0.5f * g * t * t; };
+    lo = std::min(height(t0), height(t1));
+    hi = std::max(height(t0), height(t1));
+    const float vertex = g != 0.f ? -rvy / g : -1.f;
+    if (vertex > t0 && vertex < t1) {
+        lo = std::min(lo, height(vertex));
+        hi = std::max(hi, height(vertex));
+    }
+    if (lo > halfH || hi < -halfH) {
+        return false;
+    }
+    seconds = t0;
+    return true;
+}
+
+static bool Overlaps(const AABB& a, const AABB& b) {
+    return a.minX <= b.maxX && b.minX <= a.maxX && a.minY <= b.maxY && b.minY <= a.maxY;
+}
+
+// Bins the shells by where they will be halfway through the look-ahead,
+// which spreads out shells fired from the same place, and grows each cell's
+// reach by where its live shells can be over the look-ahead. The reach is a
+// little generous in height (all of the fall either way) to keep this one
+// pass over the shells without branches or divisions.
+static void BinShells(AiScheduler& ai, const SimConfig& cfg, const ProjectileSoA& shells) {
+    const float inf = std::numeric_limits<float>::infinity();
+    std::fill(ai.cellReach.begin(), ai.cellReach.end(), AABB{ inf, inf, -inf, -inf });
+    ai.shellCells.resize(shells.count);
+    const float t = kThreatSeconds;
+    const float fall = 0.5f * cfg.gravity * t * t;
+    const float fallLo = std::min(fall, 0.f);
+    const float fallHi = std::max(fall, 0.f);
+    // Locals, so the stores below do not make the compiler reload them.
+    const UniformGrid& grid = ai.shellGrid;
+    const float minX = grid.minX;
+    const float minY = grid.minY;
+    const float invCellW = grid.invCellW;
+    const float invCellH = grid.invCellH;
+    const int cols = grid.cols;
+    const int rows = grid.rows;
+    uint32_t* cells = ai.shellCells.data();
+    AABB* reach = ai.cellReach.data();
+    for (size_t i = 0; i < shells.count; ++i) {
+        const float x = shells.x[i];
+        const float y = shells.y[i];
+        const float dx = shells.vx[i] * t;
+        const float dy = shells.vy[i] * t;
+        const int col = std::min(std::max(static_cast<int>((x + 0.5f * dx - minX) * invCellW), 0), cols - 1);
+        const int row = std::min(std::max(static_cast<int>((y + 0.5f * dy - minY) * invCellH), 0), rows - 1);
+        const int cell = row * cols + col;
+        cells[i] = static_cast<uint32_t>(cell);
+        if (!IsLive(shells, i)) {
+            continue;
+        }
+        // Ends of the move as x + (dx -/+ |dx|) / 2 (exact); min and max
+        // compile to branches here, which shells going every which way keep
+        // mispredicting.
+        const float ax = std::abs(dx);
+        const float ay = std::abs(dy);
+        AABB& r = reach[cell];
+        r.minX = std::min(r.minX, x + 0.5f * (dx - ax));
+        r.maxX = std::max(r.maxX, x + 0.5f * (dx + ax));
+        r.minY = std::min(r.minY, y + 0.5f * (dy - ay) + fallLo);
+        r.maxY = std::max(r.maxY, y + 0.5f * (dy + ay) + fallHi);
+    }
+    BuildGridCells(ai.shellGrid, cells, shells.count);
+    ai.busyCells.clear();
+    for (size_t c = 0; c < ai.cellReach.size(); ++c) {
+        if (grid.cellStart[c + 1] > grid.cellStart[c]) {
+            ai.busyCells.push_back(static_cast<uint32_t>(c));
+        }
+    }
+}
+
+// Decides for helicopter k and returns the work units it took: the fixed
+// cost (kDecisionCost and one per occupied cell), plus one per shell
+// checked up to `maxUnits` in all.
+static uint32_t Decide(World& world, size_t k, uint32_t maxUnits) {
+    const SimConfig& cfg = world.cfg;
+    EntityStore& es = world.entities;
+    const Entity e = world.helicopters[k];
+    const Position& pos = GetComponent(es.positions, e);
+    const Vec2 vel = GetComponent(es.velocities, e).vel;
+    Pilot& p = GetComponent(es.pilots, e);
+    p.decidedStep = world.ai.step;
+
+    const Vec2 center{ pos.pos.x + cfg.helicopterWidth * 0.5f, pos.pos.y + cfg.helicopterHeight * 0.5f };
+    const ProjectileSoA& shells = world.shells;
+    AiScheduler& ai = world.ai;
+    float soonest = kThreatSeconds;
+    float lo = 0.f;
+    float hi = 0.f;
+    bool threatened = false;
+    uint32_t units = kDecisionCost;
+    if (!ai.busyCells.empty()) {
+        // The helicopter's box, grown by the margin, over the look-ahead.
+        const float halfW = cfg.helicopterWidth * 0.5f + kThreatMargin;
+        const float halfH = cfg.helicopterHeight * 0.5f + kThreatMargin;
+        const Vec2 ahead{ vel.x * kThreatSeconds, vel.y * kThreatSeconds };
+        const AABB path{ center.x - halfW + std::min(ahead.x, 0.f), center.y - halfH + std::min(ahead.y, 0.f),
+                         center.x + halfW + std::max(ahead.x, 0.f), center.y + halfH + std::max(ahead.y, 0.f) };
+        const UniformGrid& grid = ai.shellGrid;
+        size_t soonestShell = 0;
+        bool cut = false;
+        units += static_cast<uint32_t>(ai.busyCells.size());
+        for (size_t b = 0; b < ai.busyCells.size() && !cut; ++b) {
+            const uint32_t c = ai.busyCells[b];
+            if (!Overlaps(ai.cellReach[c], path)) {
+                continue;
+            }
+            for (uint32_t j = grid.cellStart[c]; j < grid.cellStart[c + 1]; ++j) {
+                if (units >= maxUnits) {
+                    cut = true;
+                    break;
+                }
+                ++units;
+                // The cells are not in shell order; the index breaks ties as
+                // a scan in shell order would, the later shell winning.
+                const size_t i = grid.items[j];
+                float seconds = 0.f;
+                float shellLo = 0.f;
+                float shellHi = 0.f;
+                if (IsLive(shells, i) && ShellThreat(cfg, shells, i, center, vel, seconds, shellLo, shellHi) &&
+                    (!threatened || seconds < soonest || (seconds == soonest && i > soonestShell))) {
+                    soonest = seconds;
+                    soonestShell = i;
+                    lo = shellLo;
+                    hi = shellHi;
+                    threatened = true;
+                }
+            }
+        }
+        ai.cutShort += cut ? 1 : 0;
+    }
+
+    const float ceiling = kCeiling;
+    const float floor = Floor(cfg, p);
+    if (threatened) {
+        // Whichever way is shorter: up until the shell's path stays below
+        // the box, or down until it stays above.
+        const float halfH = cfg.helicopterHeight * 0.5f + kThreatMargin + kDodgeClearance;
+        const float up = pos.pos.y - (halfH - lo);
+        const float down = pos.pos.y + (hi + halfH);
+        const bool canUp = up >= ceiling;
+        const bool canDown = down <= floor;
+        if (canUp && (!canDown || pos.pos.y - up <= down - pos.pos.y)) {
+            p.targetAlt = up;
+        } else if (canDown) {
+            p.targetAlt = down;
+        } else {
+            p.targetAlt = pos.pos.y - up < down - pos.pos.y ? ceiling : floor;
+        }
+        p.threatSeconds = std::max(soonest, 1.f / cfg.tickRateHz);
+        return units;
+    }
+    p.threatSeconds = 0.f;
+    p.targetAlt = p.cruiseAlt;
+    p.targetSpeed = p.cruiseSpeed;
+
+    const size_t flight = static_cast<size_t>(std::max(cfg.helicopterFlightSize, 1));
+    const size_t slot = k % flight;
+    if (slot != 0) {
+        const Helicopter leader = HelicopterAt(world, k - slot);
+        const float dir = vel.x < 0.f ? -1.f : 1.f;
+        const Vec2 target = FormationSlot(cfg, leader, static_cast<int>(slot));
+        const float gap = (target.x - pos.pos.x) * dir;
+        // Only a leader ahead on the same pass; after a respawn the two may
+        // be on opposite sides of the screen.
+        if (static_cast<float>(leader.dir) == dir && std::abs(gap) < cfg.screenWidth * 0.5f) {
+            p.targetAlt = ClampValue(target.y, ceiling, floor);
+            p.targetSpeed = ClampValue(leader.speed + ClampValue(gap * kFormationGain, -kFormationMaxCorrection, kFormationMaxCorrection),
+                                       cfg.helicopterMinSpeed * 0.7f, cfg.helicopterMaxSpeed * 1.3f);
+        }
+    }
+    return units;
+}
+
+void RunHelicopterAi(World& world, float dt) {
+    const auto t0 = std::chrono::steady_clock::now();
+    AiScheduler& ai = world.ai;
+    EntityStore& es = world.entities;
+    const size_t count = world.helicopters.size();
+    ++ai.step;
+    ai.decisions = ai.urgentDecisions = ai.cutShort = ai.units = ai.maxWait = 0;
+
+    // Dodging helicopters first, the soonest hit first; index breaks ties
+    // so the order never depends on the sort.
+    ai.urgent.clear();
+    for (size_t k = 0; k < count; ++k) {
+        const Pilot& p = GetComponent(es.pilots, world.helicopters[k]);
+        if (p.threatSeconds > 0.f && ai.step - p.decidedStep >= kDodgeRecheckSteps) {
+            ai.urgent.push_back(static_cast<uint32_t>(k));
+        }
+    }
+    auto threat = [&](uint32_t k) { return GetComponent(es.pilots, world.helicopters[k]).threatSeconds; };
+    std::sort(ai.urgent.begin(), ai.urgent.end(), [&](uint32_t a, uint32_t b) {
+        return threat(a) < threat(b) || (threat(a) == threat(b) && a < b);
+    });
+
+    // A decision starts while the budget left covers its fixed cost, and
+    // checks shells until the budget runs out. The budget is at least one
+    // fixed cost, so every step makes at least one decision.
+    ai.busyCells.clear();
+    if (count && world.shells.count) {
+        BinShells(ai, world.cfg, world.shells);
+    }
+    const uint32_t fixed = kDecisionCost + static_cast<uint32_t>(ai.busyCells.size());
+    const uint32_t budget = std::max(static_cast<uint32_t>(std::max(world.cfg.aiBudget, 0)), fixed);
+    for (uint32_t k : ai.urgent) {
+        if (budget - ai.units < fixed) {
+            break;
+        }
+        ai.units += Decide(world, k, budget - ai.units);
+        ++ai.urgentDecisions;
+    }
+    ai.decisions = ai.urgentDecisions;
+    if (count) {
+        ai.cursor %= static_cast<uint32_t>(count);
+    }
+    for (size_t visited = 0; visited < count && budget - ai.units >= fixed; ++visited) {
+        const uint32_t k = ai.cursor;
+        ai.cursor = static_cast<uint32_t>((k + 1) % count);
+        if (GetComponent(es.pilots, world.helicopters[k]).decidedStep == ai.step) {
+            continue;
+        }
+        ai.units += Decide(world, k, budget - ai.units);
+        ++ai.decisions;
+    }
+
+    // Steer everyone towards what they last decided.
+    for (size_t k = 0; k < count; ++k) {
+        const Entity e = world.helicopters[k];
+        Pilot& p = GetComponent(es.pilots, e);
+        Velocity& v = GetComponent(es.velocities, e);
+        const float y = GetComponent(es.positions, e).pos.y;
+        v.vel.y = ClampValue((p.targetAlt - y) * kAltitudeGain, -kClimbRate, kClimbRate);
+        const float speed = std::abs(v.vel.x);
+        const float step = kAcceleration * dt;
+        const float newSpeed = speed + ClampValue(p.targetSpeed - speed, -step, step);
+        v.vel.x = v.vel.x < 0.f ? -newSpeed : newSpeed;
+        p.threatSeconds = std::max(0.f, p.threatSeconds - dt);
+        ai.maxWait = std::max(ai.maxWait, ai.step - p.decidedStep);
+    }
+    ai.stepNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count());
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+// Helicopter AI. Every helicopter has a Pilot (ecs.h) holding what it last
+// decided: the altitude and speed to fly at. Deciding is the expensive part,
+// since it checks the shells that can reach the helicopter's path, so a
+// scheduler spreads decisions over steps under a fixed budget. Helicopters
+// dodging a shell decide first, the soonest hit first, and the rest take
+// turns in round-robin order. Steering towards the decisions is cheap and
+// runs for every helicopter every step.
+//
+// A decision is, in order of priority:
+// - dodge: climb or dive clear of the earliest shell that would hit within
+//   the look-ahead;
+// - formation: helicopters fly in flights of cfg.helicopterFlightSize, and
+//   wingmen hold a V behind their leader when it flies their way;
+// - cruise at the altitude and speed the helicopter spawned with.
+// Bomb drops are led for the fall time in UpdateEntities.
+//
+// The budget is counted in work units rather than microseconds, so which
+// helicopter decides on which step depends only on the world, and replays,
+// rewinds and the co-op server stay deterministic. Once a step, shells are
+// binned into a coarse grid that keeps, per cell, the box its shells can
+// reach over the look-ahead; a decision only checks the shells of cells
+// whose box meets the helicopter's path. A unit is one shell or one
+// occupied cell checked against one helicopter, and a decision costs a few
+// units on top. A decision stops checking shells when the step's budget
+// runs out, so no step spends more than the budget (or than one decision's
+// fixed cost, if the budget is set below that). AiScheduler::stepNs reports
+// what a step took in wall time, binning included.
+
+#include "grid.h"
+#include "vec2.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct World;
+struct SimConfig;
+struct Helicopter;
+
+struct AiScheduler {
+    // Steps run so far, and the next helicopter in round-robin order.
+    uint32_t step = 0;
+    uint32_t cursor = 0;
+    // Scratch: dodging helicopters due to decide again this step, the
+    // shells binned by position (and each shell's cell), what each cell's
+    // shells can reach, and the cells holding any.
+    std::vector<uint32_t> urgent;
+    UniformGrid shellGrid;
+    std::vector<uint32_t> shellCells;
+    std::vector<AABB> cellReach;
+    std::vector<uint32_t> busyCells;
+
+    // The last step: decisions made, how many were by dodging helicopters,
+    // work units spent, how many decisions ran out of budget before
+    // checking every nearby shell, the most steps any helicopter has gone
+    // without deciding, and the wall time the AI took.
+    uint32_t decisions = 0;
+    uint32_t urgentDecisions = 0;
+    uint32_t cutShort = 0;
+    uint32_t units = 0;
+    uint32_t maxWait = 0;
+    uint64_t stepNs = 0;
+};
+
+// Sizes the scratch for cfg's helicopters and shell pool so steps do not
+// allocate.
+void InitAiScheduler(AiScheduler& ai, const SimConfig& cfg);
+// Decides for as many helicopters as cfg.aiBudget allows, then steers all
+// of them; the motion itself is integrated by UpdateEntities.
+void RunHelicopterAi(World& world, float dt);
+
+// A pilot cruising at the helicopter's current altitude and speed.
+void ResetPilot(Helicopter& h, uint32_t step);
+// Where wingman `slot` (1 to the flight size - 1) of a flight belongs,
+// relative to its leader: alternately below and above, one more
+// helicopter length back for every pair.
+Vec2 FormationSlot(const SimConfig& cfg, const Helicopter& leader, int slot);
@@ -0,0 +1,27 @@
+#include "alloc_count.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> gAllocCount{ 0 };
+
+uint64_t HeapAllocations() {
+    return gAllocCount.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t size) {
+    gAllocCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+// Counts global heap allocations, so the game and the headless driver can
+// check that steady-state frames and steps do none. Linking
+// alloc_count.cpp replaces the global operator new and delete with
+// malloc/free plus a counter.
+
+#include <cstdint>
+
+// Global operator new calls so far, on every thread.
+uint64_t HeapAllocations();
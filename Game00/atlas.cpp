@@ -0,0 +1,200 @@
+#include "atlas.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+static const char kAtlasMagic[4] = { 'C', 'G', 'A', 'T' };
+
+// Checks the header and that every sprite lies inside the file; the pixels
+// themselves are trusted.
+static bool ValidateAtlas(SpriteAtlas& atlas) {
+    if (atlas.size < sizeof(AtlasHeader)) {
+        return false;
+    }
+    AtlasHeader header;
+    std::memcpy(&header, atlas.data, sizeof(header));
+    if (std::memcmp(header.magic, kAtlasMagic, sizeof(kAtlasMagic)) != 0 || header.version != kAtlasVersion) {
+        return false;
+    }
+    const size_t indexSize = static_cast<size_t>(header.spriteCount) * sizeof(AtlasEntry);
+    if (header.spriteCount > (atlas.size - sizeof(AtlasHeader)) / sizeof(AtlasEntry)) {
+        return false;
+    }
+    const AtlasEntry* entries = reinterpret_cast<const AtlasEntry*>(atlas.data + sizeof(AtlasHeader));
+    for (uint32_t i = 0; i < header.spriteCount; ++i) {
+        const AtlasEntry& e = entries[i];
+        const uint64_t bytes = static_cast<uint64_t>(e.width) * e.height * 4u;
+        if (e.name[kAtlasNameSize - 1] != '\0' || e.offset % kAtlasAlign != 0 ||
+            e.offset < sizeof(AtlasHeader) + indexSize || e.offset > atlas.size || bytes > atlas.size - e.offset) {
+            return false;
+        }
+    }
+    atlas.entries = entries;
+    atlas.count = header.spriteCount;
+    return true;
+}
+
+#ifdef _WIN32
+bool OpenSpriteAtlas(SpriteAtlas& atlas, const wchar_t* path) {
+    atlas = SpriteAtlas{};
+    HANDLE file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size{};
+    HANDLE mapping = nullptr;
+    const void* view = nullptr;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    if (mapping) {
+        view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+    atlas.file = file;
+    atlas.mapping = mapping;
+    atlas.data = static_cast<const uint8_t*>(view);
+    atlas.size = static_cast<size_t>(size.QuadPart);
+    if (!view || !ValidateAtlas(atlas)) {
+        CloseSpriteAtlas(atlas);
+        return false;
+    }
+    return true;
+}
+
+bool OpenSpriteAtlas(SpriteAtlas& atlas, const char* path) {
+    wchar_t wide[MAX_PATH];
+    if (!MultiByteToWideChar(CP_UTF8, 0, path, -1, wide, MAX_PATH)) {
+        atlas = SpriteAtlas{};
+        return false;
+    }
+    return OpenSpriteAtlas(atlas, wide);
+}
+
+void CloseSpriteAtlas(SpriteAtlas& atlas) {
+    if (atlas.data) {
+        UnmapViewOfFile(atlas.data);
+    }
+    if (atlas.mapping) {
+        CloseHandle(static_cast<HANDLE>(atlas.mapping));
+    }
+    if (atlas.file) {
+        CloseHandle(static_cast<HANDLE>(atlas.file));
+    }
+    atlas = SpriteAtlas{};
+}
+#else
+bool OpenSpriteAtlas(SpriteAtlas& atlas, const char* path) {
+    atlas = SpriteAtlas{};
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st{};
+    void* view = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    // The mapping keeps the file alive.
+    close(fd);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    atlas.data = static_cast<const uint8_t*>(view);
+    atlas.size = static_cast<size_t>(st.st_size);
+    if (!ValidateAtlas(atlas)) {
+        CloseSpriteAtlas(atlas);
+        return false;
+    }
+    return true;
+}
+
+void CloseSpriteAtlas(SpriteAtlas& atlas) {
+    if (atlas.data) {
+        munmap(const_cast<uint8_t*>(atlas.data), atlas.size);
+    }
+    atlas = SpriteAtlas{};
+}
+#endif
+
+const AtlasEntry* FindAtlasSprite(const SpriteAtlas& atlas, const char* name) {
+    for (uint32_t i = 0; i < atlas.count; ++i) {
+        if (std::strncmp(atlas.entries[i].name, name, kAtlasNameSize) == 0) {
+            return &atlas.entries[i];
+        }
+    }
+    return nullptr;
+}
+
+const uint32_t* AtlasPixels(const SpriteAtlas& atlas, const AtlasEntry& entry) {
+    return reinterpret_cast<const uint32_t*>(atlas.data + entry.offset);
+}
+
+bool LoadAtlasImage(const SpriteAtlas& atlas, const char* name, Image& out) {
+    const AtlasEntry* entry = FindAtlasSprite(atlas, name);
+    if (!entry) {
+        return false;
+    }
+    const uint32_t* pixels = AtlasPixels(atlas, *entry);
+    out.width = static_cast<int>(entry->width);
+    out.height = static_cast<int>(entry->height);
+    out.pixels.assign(pixels, pixels + static_cast<size_t>(entry->width) * entry->height);
+    return true;
+}
+
+static size_t AlignUp(size_t n) {
+    return (n + kAtlasAlign - 1) / kAtlasAlign * kAtlasAlign;
+}
+
+bool WriteSpriteAtlas(const char* path, const std::vector<const char*>& names, const std::vector<Image>& images) {
+    if (names.size() != images.size()) {
+        return false;
+    }
+    AtlasHeader header{};
+    std::memcpy(header.magic, kAtlasMagic, sizeof(kAtlasMagic));
+    header.version = kAtlasVersion;
+    header.spriteCount = static_cast<uint32_t>(images.size());
+
+    std::vector<AtlasEntry> entries(images.size());
+    size_t offset = AlignUp(sizeof(AtlasHeader) + entries.size() * sizeof(AtlasEntry));
+    for (size_t i = 0; i < images.size(); ++i) {
+        if (std::strlen(names[i]) >= kAtlasNameSize) {
+            return false;
+        }
+        AtlasEntry& e = entries[i];
+        std::memset(&e, 0, sizeof(e));
+        std::strncpy(e.name, names[i], kAtlasNameSize - 1);
+        e.width = static_cast<uint32_t>(images[i].width);
+        e.height = static_cast<uint32_t>(images[i].height);
+        e.offset = offset;
+        offset = AlignUp(offset + images[i].pixels.size() * 4);
+    }
+
+    FILE* f = std::fopen(path, "wb");
+    if (!f) {
+        return false;
+    }
+    static const uint8_t kPad[kAtlasAlign] = {};
+    bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1 &&
+              (entries.empty() || std::fwrite(entries.data(), sizeof(AtlasEntry), entries.size(), f) == entries.size());
+    size_t written = sizeof(header) + entries.size() * sizeof(AtlasEntry);
+    for (size_t i = 0; ok && i < images.size(); ++i) {
+        const size_t bytes = images[i].pixels.size() * 4;
+        ok = std::fwrite(kPad, 1, entries[i].offset - written, f) == entries[i].offset - written &&
+             (bytes == 0 || std::fwrite(images[i].pixels.data(), 1, bytes, f) == bytes);
+        written = entries[i].offset + bytes;
+    }
+    return std::fclose(f) == 0 && ok;
+}
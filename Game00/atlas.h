@@ -0,0 +1,70 @@
+#pragma once
+
+// Sprite atlas: every sprite the game loads, already decoded and
+// premultiplied, in one file that is memory-mapped at startup. Written
+// offline by atlas_pack.cpp from the source PNGs, so the game does no image
+// decoding and asset loading is one map on Windows and Linux alike.
+//
+// Layout (little-endian):
+//   AtlasHeader
+//   AtlasEntry[spriteCount]
+//   pixel blocks, each 64-byte aligned: width * height premultiplied
+//   0xAARRGGBB pixels, rows top to bottom with no padding.
+// Like snapshots, it is meant for the machine that packed it, not as an
+// exchange format.
+
+#include "render.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const uint32_t kAtlasVersion = 1;
+const size_t kAtlasNameSize = 32;
+const size_t kAtlasAlign = 64;
+
+struct AtlasHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t spriteCount;
+    uint32_t reserved;
+};
+
+struct AtlasEntry {
+    // Zero-terminated; the source file name without its extension.
+    char name[kAtlasNameSize];
+    uint32_t width;
+    uint32_t height;
+    // From the start of the file.
+    uint64_t offset;
+};
+
+struct SpriteAtlas {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    const AtlasEntry* entries = nullptr;
+    uint32_t count = 0;
+    // Platform handles of the mapping (file and mapping object on Windows).
+    void* file = nullptr;
+    void* mapping = nullptr;
+};
+
+// Maps the atlas read-only and checks its header and index. False (and
+// nothing left open) if the file is missing, truncated or from another
+// version.
+bool OpenSpriteAtlas(SpriteAtlas& atlas, const char* path);
+#ifdef _WIN32
+bool OpenSpriteAtlas(SpriteAtlas& atlas, const wchar_t* path);
+#endif
+void CloseSpriteAtlas(SpriteAtlas& atlas);
+
+// nullptr if the atlas has no sprite of that name.
+const AtlasEntry* FindAtlasSprite(const SpriteAtlas& atlas, const char* name);
+// The sprite's pixels, straight from the mapping.
+const uint32_t* AtlasPixels(const SpriteAtlas& atlas, const AtlasEntry& entry);
+// Copies a sprite out into an Image (a memcpy, no decoding). False if the
+// atlas has no sprite of that name.
+bool LoadAtlasImage(const SpriteAtlas& atlas, const char* name, Image& out);
+
+// Writes `images` (premultiplied) under `names` as an atlas file.
+bool WriteSpriteAtlas(const char* path, const std::vector<const char*>& names, const std::vector<Image>& images);
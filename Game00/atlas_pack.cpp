@@ -0,0 +1,426 @@
+// Offline sprite packer: decodes PNGs, premultiplies them and writes one
+// atlas file (atlas.h) for the game to map at startup.
+//
+// Handles non-interlaced 8-bit PNGs (gray, RGB, palette, gray + alpha and
+// RGBA), which covers what image editors export for sprites. The decoder is
+// here rather than in the game so the game never decodes anything.
+//
+// Build (Linux):  g++ -std=c++17 -O2 atlas_pack.cpp atlas.cpp render_soft.cpp -o atlas_pack
+// Usage:          atlas_pack OUT.cga IMAGE.png...
+// Sprites are named after their files without the directory or extension,
+// e.g. Tank_Body.png becomes "Tank_Body".
+
+#include "atlas.h"
+#include "render_soft.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Inflate (RFC 1951) over a whole buffer.
+struct BitReader {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    size_t pos = 0;
+    uint32_t bits = 0;
+    int count = 0;
+    bool overrun = false;
+};
+
+static uint32_t ReadBits(BitReader& br, int n) {
+    while (br.count < n) {
+        if (br.pos < br.size) {
+            br.bits |= static_cast<uint32_t>(br.data[br.pos++]) << br.count;
+        } else {
+            br.overrun = true;
+        }
+        br.count += 8;
+    }
+    const uint32_t v = br.bits & ((1u << n) - 1);
+    br.bits >>= n;
+    br.count -= n;
+    return v;
+}
+
+// Canonical Huffman code, decoded a bit at a time.
+struct Huffman {
+    uint16_t counts[16] = {};
+    uint16_t symbols[288] = {};
+};
+
+static void BuildHuffman(Huffman& h, const uint8_t* lengths, int n) {
+    std::memset(h.counts, 0, sizeof(h.counts));
+    for (int i = 0; i < n; ++i) {
+        ++h.counts[lengths[i]];
+    }
+    h.counts[0] = 0;
+    uint16_t offsets[16] = {};
+    for (int len = 1; len < 16; ++len) {
+        offsets[len] = static_cast<uint16_t>(offsets[len - 1] + h.counts[len - 1]);
+    }
+    for (int i = 0; i < n; ++i) {
+        if (lengths[i]) {
+            h.symbols[offsets[lengths[i]]++] = static_cast<uint16_t>(i);
+        }
+    }
+}
+
+static int DecodeSymbol(BitReader& br, const Huffman& h) {
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    for (int len = 1; len < 16; ++len) {
+        code |= static_cast<int>(ReadBits(br, 1));
+        const int count = h.counts[len];
+        if (code - first < count) {
+            return h.symbols[index + code - first];
+        }
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+static const uint16_t kLengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                          35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t kLengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                          3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t kDistBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129,
+                                        193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+                                        6145, 8193, 12289, 16385, 24577 };
+static const uint8_t kDistExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                        6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static bool InflateBlock(BitReader& br, const Huffman& lit, const Huffman& dist, std::vector<uint8_t>& out) {
+    for (;;) {
+        const int sym = DecodeSymbol(br, lit);
+        if (sym < 0 || br.overrun) {
+            return false;
+        }
+        if (sym < 256) {
+            out.push_back(static_cast<uint8_t>(sym));
+            continue;
+        }
+        if (sym == 256) {
+            return true;
+        }
+        if (sym > 285) {
+            return false;
+        }
+        const size_t length = kLengthBase[sym - 257] + ReadBits(br, kLengthExtra[sym - 257]);
+        const int d = DecodeSymbol(br, dist);
+        if (d < 0 || d > 29) {
+            return false;
+        }
+        const size_t distance = kDistBase[d] + ReadBits(br, kDistExtra[d]);
+        if (distance > out.size()) {
+            return false;
+        }
+        // Byte by byte: the copy may overlap what it writes.
+        for (size_t i = 0; i < length; ++i) {
+            out.push_back(out[out.size() - distance]);
+        }
+    }
+}
+
+static bool ReadDynamicTables(BitReader& br, Huffman& lit, Huffman& dist) {
+    static const uint8_t kOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+    const int hlit = static_cast<int>(ReadBits(br, 5)) + 257;
+    const int hdist = static_cast<int>(ReadBits(br, 5)) + 1;
+    const int hclen = static_cast<int>(ReadBits(br, 4)) + 4;
+    uint8_t codeLengths[19] = {};
+    for (int i = 0; i < hclen; ++i) {
+        codeLengths[kOrder[i]] = static_cast<uint8_t>(ReadBits(br, 3));
+    }
+    Huffman lengthCode;
+    BuildHuffman(lengthCode, codeLengths, 19);
+    uint8_t lengths[288 + 32] = {};
+    int n = 0;
+    while (n < hlit + hdist) {
+        const int sym = DecodeSymbol(br, lengthCode);
+        if (sym < 0 || br.overrun) {
+            return false;
+        }
+        if (sym < 16) {
+            lengths[n++] = static_cast<uint8_t>(sym);
+            continue;
+        }
+        int repeat = 0;
+        uint8_t value = 0;
+        if (sym == 16) {
+            if (n == 0) {
+                return false;
+            }
+            value = lengths[n - 1];
+            repeat = 3 + static_cast<int>(ReadBits(br, 2));
+        } else if (sym == 17) {
+            repeat = 3 + static_cast<int>(ReadBits(br, 3));
+        } else {
+            repeat = 11 + static_cast<int>(ReadBits(br, 7));
+        }
+        if (n + repeat > hlit + hdist) {
+            return false;
+        }
+        while (repeat--) {
+            lengths[n++] = value;
+        }
+    }
+    BuildHuffman(lit, lengths, hlit);
+    BuildHuffman(dist, lengths + hlit, hdist);
+    return true;
+}
+
+// zlib stream (RFC 1950) to raw bytes. The Adler-32 trailer is not checked;
+// the PNG chunk CRCs already cover the data.
+static bool Inflate(const std::vector<uint8_t>& z, std::vector<uint8_t>& out) {
+    if (z.size() < 2 || (z[0] & 0x0F) != 8 || ((z[0] << 8) | z[1]) % 31 != 0 || (z[1] & 0x20)) {
+        return false;
+    }
+    BitReader br;
+    br.data = z.data() + 2;
+    br.size = z.size() - 2;
+    bool last = false;
+    while (!last) {
+        last = ReadBits(br, 1) != 0;
+        const uint32_t type = ReadBits(br, 2);
+        if (type == 0) {
+            // Stored: skip to the byte boundary, then LEN and NLEN.
+            br.bits = 0;
+            br.count = 0;
+            if (br.pos + 4 > br.size) {
+                return false;
+            }
+            const size_t len = br.data[br.pos] | (br.data[br.pos + 1] << 8);
+            const size_t nlen = br.data[br.pos + 2] | (br.data[br.pos + 3] << 8);
+            br.pos += 4;
+            if ((len ^ 0xFFFF) != nlen || br.pos + len > br.size) {
+                return false;
+            }
+            out.insert(out.end(), br.data + br.pos, br.data + br.pos + len);
+            br.pos += len;
+        } else if (type == 1) {
+            uint8_t lengths[288 + 32];
+            std::memset(lengths, 8, 144);
+            std::memset(lengths + 144, 9, 112);
+            std::memset(lengths + 256, 7, 24);
+            std::memset(lengths + 280, 8, 8);
+            std::memset(lengths + 288, 5, 32);
+            Huffman lit;
+            Huffman dist;
+            BuildHuffman(lit, lengths, 288);
+            BuildHuffman(dist, lengths + 288, 30);
+            if (!InflateBlock(br, lit, dist, out)) {
+                return false;
+            }
+        } else if (type == 2) {
+            Huffman lit;
+            Huffman dist;
+            if (!ReadDynamicTables(br, lit, dist) || !InflateBlock(br, lit, dist, out)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    return !br.overrun;
+}
+
+static uint32_t GetU32BE(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static uint8_t Paeth(int a, int b, int c) {
+    const int p = a + b - c;
+    const int pa = p > a ? p - a : a - p;
+    const int pb = p > b ? p - b : b - p;
+    const int pc = p > c ? p - c : c - p;
+    return static_cast<uint8_t>(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+}
+
+// Decodes into premultiplied 0xAARRGGBB. False with a message in `error`.
+static bool DecodePng(const std::vector<uint8_t>& file, Image& out, std::string& error) {
+    static const uint8_t kSig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    if (file.size() < 8 || std::memcmp(file.data(), kSig, 8) != 0) {
+        error = "not a PNG";
+        return false;
+    }
+    uint32_t width = 0, height = 0;
+    int colorType = -1;
+    std::vector<uint8_t> idat;
+    uint32_t palette[256] = {};
+    for (uint32_t& p : palette) {
+        p = 0xFF000000u;
+    }
+    size_t pos = 8;
+    while (pos + 12 <= file.size()) {
+        const uint32_t len = GetU32BE(&file[pos]);
+        const uint8_t* type = &file[pos + 4];
+        const uint8_t* body = &file[pos + 8];
+        if (len > file.size() - pos - 12) {
+            error = "truncated chunk";
+            return false;
+        }
+        if (std::memcmp(type, "IHDR", 4) == 0 && len >= 13) {
+            width = GetU32BE(body);
+            height = GetU32BE(body + 4);
+            colorType = body[9];
+            if (body[8] != 8 || body[12] != 0) {
+                error = "only 8-bit, non-interlaced PNGs are supported";
+                return false;
+            }
+        } else if (std::memcmp(type, "PLTE", 4) == 0) {
+            for (uint32_t i = 0; i < len / 3 && i < 256; ++i) {
+                palette[i] = 0xFF000000u | (body[i * 3] << 16) | (body[i * 3 + 1] << 8) | body[i * 3 + 2];
+            }
+        } else if (std::memcmp(type, "tRNS", 4) == 0 && colorType == 3) {
+            for (uint32_t i = 0; i < len && i < 256; ++i) {
+                palette[i] = (palette[i] & 0x00FFFFFFu) | (static_cast<uint32_t>(body[i]) << 24);
+            }
+        } else if (std::memcmp(type, "IDAT", 4) == 0) {
+            idat.insert(idat.end(), body, body + len);
+        } else if (std::memcmp(type, "IEND", 4) == 0) {
+            break;
+        }
+        pos += 12 + len;
+    }
+
+    int channels = 0;
+    switch (colorType) {
+    case 0: channels = 1; break;
+    case 2: channels = 3; break;
+    case 3: channels = 1; break;
+    case 4: channels = 2; break;
+    case 6: channels = 4; break;
+    default:
+        error = "missing or unsupported IHDR";
+        return false;
+    }
+    if (width == 0 || height == 0 || width > 16384 || height > 16384) {
+        error = "bad image size";
+        return false;
+    }
+    std::vector<uint8_t> raw;
+    const size_t stride = static_cast<size_t>(width) * channels;
+    if (!Inflate(idat, raw) || raw.size() < (stride + 1) * height) {
+        error = "corrupt image data";
+        return false;
+    }
+
+    // Undo the per-row filters in place, then convert.
+    out.width = static_cast<int>(width);
+    out.height = static_cast<int>(height);
+    out.pixels.resize(static_cast<size_t>(width) * height);
+    std::vector<uint8_t> prev(stride, 0);
+    for (uint32_t y = 0; y < height; ++y) {
+        uint8_t* row = &raw[y * (stride + 1) + 1];
+        const uint8_t filter = row[-1];
+        for (size_t i = 0; i < stride; ++i) {
+            const int a = i >= static_cast<size_t>(channels) ? row[i - channels] : 0;
+            const int b = prev[i];
+            const int c = i >= static_cast<size_t>(channels) ? prev[i - channels] : 0;
+            switch (filter) {
+            case 0: break;
+            case 1: row[i] = static_cast<uint8_t>(row[i] + a); break;
+            case 2: row[i] = static_cast<uint8_t>(row[i] + b); break;
+            case 3: row[i] = static_cast<uint8_t>(row[i] + (a + b) / 2); break;
+            case 4: row[i] = static_cast<uint8_t>(row[i] + Paeth(a, b, c)); break;
+            default:
+                error = "bad row filter";
+                return false;
+            }
+        }
+        std::memcpy(prev.data(), row, stride);
+        uint32_t* dst = out.pixels.data() + static_cast<size_t>(y) * width;
+        for (uint32_t x = 0; x < width; ++x) {
+            const uint8_t* p = row + static_cast<size_t>(x) * channels;
+            uint32_t argb = 0;
+            switch (colorType) {
+            case 0: argb = Argb(255, p[0], p[0], p[0]); break;
+            case 2: argb = Argb(255, p[0], p[1], p[2]); break;
+            case 3: argb = palette[p[0]]; break;
+            case 4: argb = Argb(p[1], p[0], p[0], p[0]); break;
+            default: argb = Argb(p[3], p[0], p[1], p[2]); break;
+            }
+            dst[x] = Premultiply(argb);
+        }
+    }
+    return true;
+}
+
+static bool ReadFile(const char* path, std::vector<uint8_t>& out) {
+    FILE* f = std::fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+    uint8_t buf[65536];
+    size_t n = 0;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) {
+        out.insert(out.end(), buf, buf + n);
+    }
+    const bool ok = !std::ferror(f);
+    std::fclose(f);
+    return ok;
+}
+
+// "dir/Tank_Body.png" -> "Tank_Body".
+static std::string SpriteName(const char* path) {
+    std::string name(path);
+    const size_t slash = name.find_last_of("\\/");
+    if (slash != std::string::npos) {
+        name.erase(0, slash + 1);
+    }
+    const size_t dot = name.find_last_of('.');
+    if (dot != std::string::npos && dot > 0) {
+        name.resize(dot);
+    }
+    return name;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: %s OUT.cga IMAGE.png...\n", argv[0]);
+        return 2;
+    }
+    std::vector<std::string> names;
+    std::vector<Image> images;
+    size_t bytes = 0;
+    for (int i = 2; i < argc; ++i) {
+        std::vector<uint8_t> file;
+        Image image;
+        std::string error;
+        if (!ReadFile(argv[i], file)) {
+            std::fprintf(stderr, "failed to read %s\n", argv[i]);
+            return 1;
+        }
+        if (!DecodePng(file, image, error)) {
+            std::fprintf(stderr, "%s: %s\n", argv[i], error.c_str());
+            return 1;
+        }
+        names.push_back(SpriteName(argv[i]));
+        if (names.back().empty() || names.back().size() >= kAtlasNameSize) {
+            std::fprintf(stderr, "%s: sprite names must be 1 to %zu characters\n", argv[i], kAtlasNameSize - 1);
+            return 1;
+        }
+        for (size_t j = 0; j + 1 < names.size(); ++j) {
+            if (names[j] == names.back()) {
+                std::fprintf(stderr, "%s: a sprite named %s is already packed\n", argv[i], names.back().c_str());
+                return 1;
+            }
+        }
+        std::printf("%-24s %5d x %-5d\n", names.back().c_str(), image.width, image.height);
+        bytes += image.pixels.size() * 4;
+        images.push_back(std::move(image));
+    }
+    std::vector<const char*> namePtrs;
+    for (const std::string& n : names) {
+        namePtrs.push_back(n.c_str());
+    }
+    if (!WriteSpriteAtlas(argv[1], namePtrs, images)) {
+        std::fprintf(stderr, "failed to write %s\n", argv[1]);
+        return 1;
+    }
+    std::printf("packed %zu sprites (%zu KB of pixels) into %s\n", images.size(), bytes / 1024, argv[1]);
+    return 0;
+}
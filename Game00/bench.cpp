@@ -0,0 +1,268 @@
+// Microbenchmarks for the simulation hot paths at 10 to 1,000,000 entities:
+// shell and bomb integration, the helicopter update with its bomb-drop
+// checks, the helicopter AI, shell-vs-helicopter collision and dead-projectile
+// compaction.
+// Prints ns per entity and entities per second, and can save the results as
+// JSON and compare a run against a saved baseline.
+//
+// Build (Linux):  g++ -std=c++17 -O2 bench.cpp sim.cpp ecs.cpp ai.cpp projectiles.cpp grid.cpp -o bench
+// Usage:          bench [--json PATH] [--compare BASELINE.json] [--max N] [--filter NAME]
+
+#include "sim.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+struct BenchResult {
+    std::string name;
+    size_t entities = 0;
+    double nsPerCall = 0.0;
+};
+
+static double NsPerEntity(const BenchResult& r) {
+    return r.nsPerCall / static_cast<double>(r.entities);
+}
+
+// Median over several batches of the time per call. Each batch first calls
+// setup(batch) untimed, then run(i) for i in [0, batch); batches are sized
+// so one holds about 100k entity updates, which keeps clock overhead out of
+// the small counts.
+template <typename Setup, typename Run>
+static double TimePerCall(size_t entities, Setup&& setup, Run&& run) {
+    const size_t batch = std::max<size_t>(1, 100000 / entities);
+    const int samples = entities >= 100000 ? 5 : 9;
+    std::vector<double> times;
+    for (int s = 0; s < samples + 1; ++s) {
+        setup(batch);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < batch; ++i) {
+            run(i);
+        }
+        auto end = std::chrono::steady_clock::now();
+        // The first batch warms caches and branch predictors.
+        if (s > 0) {
+            times.push_back(std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(batch));
+        }
+    }
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    return times[times.size() / 2];
+}
+
+static SimConfig BenchConfig(size_t shells, size_t bombs, int helicopters) {
+    SimConfig cfg{};
+    cfg.maxShells = static_cast<int>(shells);
+    cfg.maxBombs = static_cast<int>(bombs);
+    cfg.helicopterCount = helicopters;
+    return cfg;
+}
+
+// Fills the pool with projectiles spread over the screen, moving in every
+// direction, all in bounds for the first step.
+static void FillProjectiles(ProjectileSoA& p, const SimConfig& cfg, size_t n, Pcg32& rng) {
+    for (size_t i = 0; i < n; ++i) {
+        SpawnProjectile(p, UniformFloat(rng, 0.f, cfg.screenWidth), UniformFloat(rng, 0.f, cfg.screenHeight - 60.f),
+                        UniformFloat(rng, -cfg.projectileSpeed, cfg.projectileSpeed),
+                        UniformFloat(rng, -cfg.projectileSpeed, cfg.projectileSpeed));
+    }
+}
+
+static double BenchIntegrate(size_t n, bool bombs) {
+    const SimConfig cfg = BenchConfig(n, 1, 0);
+    ProjectileSoA pool;
+    InitProjectilePool(pool, n);
+    Pcg32 rng;
+    FillProjectiles(pool, cfg, n, rng);
+    const float inf = std::numeric_limits<float>::infinity();
+    const CullBounds bounds = bombs ? CullBounds{ -inf, inf, cfg.screenHeight + 50.f }
+                                    : CullBounds{ -50.f, cfg.screenWidth + 50.f, cfg.screenHeight };
+    // The kernel runs over every slot whether or not it is still live, so
+    // repeating it on the same pool costs the same every time.
+    return TimePerCall(n, [](size_t) {}, [&](size_t) { IntegrateBallistic(pool, cfg.gravity, 1.f / cfg.tickRateHz, bounds); });
+}
+
+static double BenchHelicopters(size_t n) {
+    World world;
+    InitWorld(world, BenchConfig(1, 1024, static_cast<int>(n)), 1u);
+    // Spread them over the whole flight path so some are always over the
+    // tank and some always respawning.
+    const SimConfig& cfg = world.cfg;
+    for (size_t i = 0; i < n; ++i) {
+        GetComponent(world.entities.positions, world.helicopters[i]).pos.x = -cfg.helicopterWidth + (cfg.screenWidth + 2.f * cfg.helicopterWidth) * static_cast<float>(i) / static_cast<float>(n);
+    }
+    return TimePerCall(n, [&](size_t) { ClearProjectiles(world.bombs); },
+                       [&](size_t) { UpdateEntities(world, 1.f / cfg.tickRateHz); });
+}
+
+// n helicopters deciding against a fixed number of shells, under the default
+// budget: decisions cost the same whatever n is, and steering grows with it.
+static double BenchAi(size_t n, size_t shells) {
+    World world;
+    InitWorld(world, BenchConfig(shells, 1, static_cast<int>(n)), 3u);
+    Pcg32 rng;
+    FillProjectiles(world.shells, world.cfg, shells, rng);
+    return TimePerCall(n, [](size_t) {}, [&](size_t) { RunHelicopterAi(world, 1.f / world.cfg.tickRateHz); });
+}
+
+// n shells against a fixed number of helicopters. Hits kill shells and
+// respawn helicopters, so every call gets its own copy of the scene.
+static double BenchCollide(size_t n, int helicopters, int (*collide)(World&)) {
+    World scene;
+    InitWorld(scene, BenchConfig(n, 1, helicopters), 7u);
+    Pcg32 rng;
+    FillProjectiles(scene.shells, scene.cfg, n, rng);
+    for (size_t i = 0; i < n; ++i) {
+        scene.shells.prevX[i] = scene.shells.x[i] - scene.shells.vx[i] / scene.cfg.tickRateHz;
+        scene.shells.prevY[i] = scene.shells.y[i] - scene.shells.vy[i] / scene.cfg.tickRateHz;
+    }
+    std::vector<World> copies;
+    return TimePerCall(n, [&](size_t batch) { copies.assign(batch, scene); }, [&](size_t i) { collide(copies[i]); });
+}
+
+// A quarter of the pool, picked at random, was killed this step.
+static double BenchCompact(size_t n) {
+    const SimConfig cfg = BenchConfig(n, 1, 0);
+    ProjectileSoA pool;
+    InitProjectilePool(pool, n);
+    Pcg32 rng;
+    FillProjectiles(pool, cfg, n, rng);
+    for (size_t i = 0; i < n; ++i) {
+        if ((NextU32(rng) & 3) == 0) {
+            KillProjectile(pool, i);
+        }
+    }
+    std::vector<ProjectileSoA> copies;
+    return TimePerCall(n, [&](size_t batch) { copies.assign(batch, pool); }, [&](size_t i) { CompactProjectiles(copies[i]); });
+}
+
+static bool WriteJson(const char* path, const std::vector<BenchResult>& results) {
+    FILE* f = std::fopen(path, "w");
+    if (!f) {
+        return false;
+    }
+    std::fprintf(f, "{\n  \"kernel\": \"%s\",\n  \"results\": [\n", BallisticKernelName());
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        std::fprintf(f, "    {\"bench\": \"%s\", \"entities\": %zu, \"ns_per_call\": %.3f, \"ns_per_entity\": %.5f, \"entities_per_sec\": %.0f}%s\n",
+                     r.name.c_str(), r.entities, r.nsPerCall, NsPerEntity(r), 1e9 / NsPerEntity(r),
+                     i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+    return std::fclose(f) == 0;
+}
+
+// Reads back what WriteJson wrote: one result object per line.
+static bool ReadJson(const char* path, std::vector<BenchResult>& results) {
+    FILE* f = std::fopen(path, "r");
+    if (!f) {
+        return false;
+    }
+    char line[512];
+    while (std::fgets(line, sizeof(line), f)) {
+        char name[128];
+        size_t entities = 0;
+        double nsPerCall = 0.0;
+        const char* at = std::strstr(line, "{\"bench\"");
+        if (at && std::sscanf(at, "{\"bench\": \"%127[^\"]\", \"entities\": %zu, \"ns_per_call\": %lf", name, &entities, &nsPerCall) == 3) {
+            results.push_back({ name, entities, nsPerCall });
+        }
+    }
+    std::fclose(f);
+    return true;
+}
+
+static const BenchResult* FindResult(const std::vector<BenchResult>& results, const BenchResult& r) {
+    for (const BenchResult& b : results) {
+        if (b.name == r.name && b.entities == r.entities) {
+            return &b;
+        }
+    }
+    return nullptr;
+}
+
+int main(int argc, char** argv) {
+    const char* jsonPath = nullptr;
+    const char* comparePath = nullptr;
+    const char* filter = nullptr;
+    size_t maxEntities = 1000000;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (std::strcmp(arg, "--json") == 0 && val) {
+            jsonPath = val;
+            ++i;
+        } else if (std::strcmp(arg, "--compare") == 0 && val) {
+            comparePath = val;
+            ++i;
+        } else if (std::strcmp(arg, "--max") == 0 && val) {
+            maxEntities = static_cast<size_t>(std::strtoull(val, nullptr, 10));
+            ++i;
+        } else if (std::strcmp(arg, "--filter") == 0 && val) {
+            filter = val;
+            ++i;
+        } else {
+            std::fprintf(stderr, "usage: %s [--json PATH] [--compare BASELINE.json] [--max N] [--filter NAME]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<BenchResult> baseline;
+    if (comparePath && !ReadJson(comparePath, baseline)) {
+        std::fprintf(stderr, "failed to read %s\n", comparePath);
+        return 1;
+    }
+
+    struct Bench {
+        const char* name;
+        double (*run)(size_t n);
+    };
+    const Bench benches[] = {
+        { "integrate_shells", [](size_t n) { return BenchIntegrate(n, false); } },
+        { "integrate_bombs", [](size_t n) { return BenchIntegrate(n, true); } },
+        { "helicopters", BenchHelicopters },
+        { "ai_1024_shells", [](size_t n) { return BenchAi(n, 1024); } },
+        // StepWorld's brute-force path (the default 3 helicopters) and its
+        // grid path.
+        { "collide_brute_3h", [](size_t n) { return BenchCollide(n, 3, CollideShellsBruteForce); } },
+        { "collide_grid_32h", [](size_t n) { return BenchCollide(n, 32, CollideShellsGrid); } },
+        { "compact", BenchCompact },
+    };
+    const size_t counts[] = { 10, 100, 1000, 10000, 100000, 1000000 };
+
+    std::printf("kernel: %s\n", BallisticKernelName());
+    std::printf("%-18s %9s %14s %12s %14s%s\n", "bench", "entities", "ns/call", "ns/entity", "entities/s",
+                baseline.empty() ? "" : "   vs baseline");
+    std::vector<BenchResult> results;
+    for (const Bench& bench : benches) {
+        if (filter && !std::strstr(bench.name, filter)) {
+            continue;
+        }
+        for (size_t n : counts) {
+            if (n > maxEntities) {
+                continue;
+            }
+            BenchResult r{ bench.name, n, bench.run(n) };
+            std::printf("%-18s %9zu %14.1f %12.4f %14.0f", r.name.c_str(), n, r.nsPerCall, NsPerEntity(r), 1e9 / NsPerEntity(r));
+            if (const BenchResult* base = FindResult(baseline, r)) {
+                // Above 1 is faster than the baseline.
+                std::printf("   %6.2fx", base->nsPerCall / r.nsPerCall);
+            }
+            std::printf("\n");
+            results.push_back(r);
+        }
+    }
+
+    if (jsonPath) {
+        if (!WriteJson(jsonPath, results)) {
+            std::fprintf(stderr, "failed to write %s\n", jsonPath);
+            return 1;
+        }
+        std::printf("saved %s\n", jsonPath);
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+// Compares the uniform-grid shell-vs-helicopter broadphase with the
+// brute-force loop over a sweep of helicopter and shell counts, and prints
+// the helicopter count at which the grid starts winning for each shell count.
+//
+// Build (Linux):  g++ -std=c++17 -O2 bench_collision.cpp sim.cpp ecs.cpp ai.cpp projectiles.cpp grid.cpp -o bench_collision
+
+#include "sim.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+// Scatters helicopters over their altitude band and shells over the sky,
+// each with one 120 Hz step of motion behind it for the swept tests.
+static void BuildScene(World& world, int helis, int shells, uint32_t seed) {
+    SimConfig cfg{};
+    cfg.helicopterCount = 0;
+    cfg.maxShells = shells;
+    InitWorld(world, cfg, seed);
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> hx(-cfg.helicopterWidth, cfg.screenWidth);
+    std::uniform_real_distribution<float> hy(cfg.helicopterMinAlt, cfg.helicopterMaxAlt + 90.f);
+    std::uniform_real_distribution<float> sx(0.f, cfg.screenWidth);
+    std::uniform_real_distribution<float> sy(0.f, cfg.screenHeight);
+    std::uniform_real_distribution<float> sv(-cfg.projectileSpeed, cfg.projectileSpeed);
+    const float dt = 1.f / 120.f;
+    for (int i = 0; i < helis; ++i) {
+        Helicopter h{};
+        h.pos = { hx(rng), hy(rng) };
+        h.speed = 120.f;
+        h.dir = (i & 1) ? 1 : -1;
+        h.prevPos = { h.pos.x - h.speed * h.dir * dt, h.pos.y };
+        SpawnHelicopter(world, h);
+    }
+    for (int i = 0; i < shells; ++i) {
+        const float x = sx(rng);
+        const float y = sy(rng);
+        const float vx = sv(rng);
+        const float vy = sv(rng);
+        SpawnProjectile(world.shells, x, y, vx, vy);
+        const size_t d = world.shells.count - 1;
+        world.shells.prevX[d] = x - vx * dt;
+        world.shells.prevY[d] = y - vy * dt;
+    }
+}
+
+// Average nanoseconds per call. Every call gets a fresh copy of the scene
+// because hits kill shells and respawn helicopters.
+template <typename Fn>
+static double TimeCollide(const World& scene, int reps, Fn&& fn, int& hits, uint64_t& checksum) {
+    double total = 0.0;
+    for (int r = 0; r < reps; ++r) {
+        World w = scene;
+        auto start = std::chrono::steady_clock::now();
+        hits = fn(w);
+        auto end = std::chrono::steady_clock::now();
+        total += std::chrono::duration<double, std::nano>(end - start).count();
+        checksum = WorldChecksum(w) ^ static_cast<uint64_t>(CountLive(w.shells));
+    }
+    return total / reps;
+}
+
+int main() {
+    const int heliCounts[] = { 1, 3, 10, 30, 100, 300, 1000, 3000 };
+    const int shellCounts[] = { 10, 100, 1000, 10000, 30000 };
+
+    std::printf("%8s %8s %14s %14s %9s %6s\n", "helis", "shells", "brute ns", "grid ns", "speedup", "hits");
+    bool mismatch = false;
+    for (int shells : shellCounts) {
+        int crossover = -1;
+        for (int helis : heliCounts) {
+            World scene;
+            BuildScene(scene, helis, shells, 1234u);
+
+            long long work = static_cast<long long>(helis) * shells;
+            int reps = work > 10000000 ? 3 : (work > 100000 ? 20 : 200);
+
+            int bruteHits = 0;
+            int gridHits = 0;
+            uint64_t bruteSum = 0;
+            uint64_t gridSum = 0;
+            double brute = TimeCollide(scene, reps, CollideShellsBruteForce, bruteHits, bruteSum);
+            double grid = TimeCollide(scene, reps, CollideShellsGrid, gridHits, gridSum);
+            if (bruteHits != gridHits || bruteSum != gridSum) {
+                mismatch = true;
+            }
+            if (crossover < 0 && grid < brute) {
+                crossover = helis;
+            }
+            std::printf("%8d %8d %14.0f %14.0f %8.2fx %6d\n", helis, shells, brute, grid, brute / grid, gridHits);
+        }
+        if (crossover > 0) {
+            std::printf("  crossover at %d shells: grid wins from %d helicopters\n", shells, crossover);
+        } else {
+            std::printf("  crossover at %d shells: brute force wins across the sweep\n", shells);
+        }
+    }
+
+    if (mismatch) {
+        std::printf("ERROR: grid and brute-force results differ\n");
+        return 1;
+    }
+    return 0;
+}
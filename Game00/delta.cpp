@@ -0,0 +1,99 @@
+#include "delta.h"
+
+// A literal run is cut at a zero run this long; shorter ones are cheaper
+// to keep inside the literal than to pay two varints for.
+static const size_t kMinZeroRun = 3;
+
+static void PutVarint(std::vector<uint8_t>& out, uint64_t v) {
+    do {
+        const uint8_t b = static_cast<uint8_t>(v & 0x7f);
+        v >>= 7;
+        out.push_back(static_cast<uint8_t>(b | (v ? 0x80 : 0)));
+    } while (v);
+}
+
+static bool GetVarint(const uint8_t*& at, const uint8_t* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (at == end) {
+            return false;
+        }
+        const uint8_t b = *at++;
+        v |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint8_t XorAt(const uint8_t* base, size_t baseSize, const uint8_t* cur, size_t i) {
+    return i < baseSize ? static_cast<uint8_t>(base[i] ^ cur[i]) : cur[i];
+}
+
+void EncodeDelta(const uint8_t* base, size_t baseSize, const uint8_t* cur, size_t curSize, std::vector<uint8_t>& out) {
+    PutVarint(out, curSize);
+    size_t i = 0;
+    for (;;) {
+        const size_t zeroStart = i;
+        while (i < curSize && XorAt(base, baseSize, cur, i) == 0) {
+            ++i;
+        }
+        if (i == curSize) {
+            // Trailing zeros are implied by the size.
+            break;
+        }
+        const size_t zeros = i - zeroStart;
+        // The literal absorbs zero runs too short to cut at.
+        const size_t litStart = i;
+        size_t litEnd = i;
+        while (i < curSize) {
+            if (XorAt(base, baseSize, cur, i) != 0) {
+                litEnd = ++i;
+                continue;
+            }
+            size_t z = i;
+            while (z < curSize && z - i < kMinZeroRun && XorAt(base, baseSize, cur, z) == 0) {
+                ++z;
+            }
+            if (z - i == kMinZeroRun || z == curSize) {
+                break;
+            }
+            i = z;
+        }
+        i = litEnd;
+        PutVarint(out, zeros);
+        PutVarint(out, litEnd - litStart);
+        for (size_t j = litStart; j < litEnd; ++j) {
+            out.push_back(XorAt(base, baseSize, cur, j));
+        }
+    }
+}
+
+bool DecodeDelta(const uint8_t* base, size_t baseSize, const uint8_t* data, size_t size, size_t maxSize,
+                 std::vector<uint8_t>& out) {
+    const uint8_t* at = data;
+    const uint8_t* end = data + size;
+    uint64_t total = 0;
+    if (!GetVarint(at, end, total) || total > maxSize) {
+        return false;
+    }
+    out.resize(static_cast<size_t>(total));
+    for (size_t i = 0; i < out.size(); ++i) {
+        out[i] = i < baseSize ? base[i] : 0;
+    }
+    size_t pos = 0;
+    while (at != end) {
+        uint64_t zeros = 0;
+        uint64_t literals = 0;
+        if (!GetVarint(at, end, zeros) || !GetVarint(at, end, literals) || zeros > total - pos ||
+            literals > total - pos - zeros || literals > static_cast<uint64_t>(end - at)) {
+            return false;
+        }
+        pos += static_cast<size_t>(zeros);
+        for (uint64_t j = 0; j < literals; ++j) {
+            out[pos++] ^= *at++;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+// Byte-level delta coding between two versions of a blob: the new blob is
+// XORed with the old one (bytes past the old one's end are XORed with
+// zero), and the result is stored as alternating runs of zero bytes and
+// literal bytes. Where little changed, that leaves a few short literals
+// between long zero runs.
+//
+// Encoded form: varint(size of the new blob), then pairs of
+// varint(zero run) varint(literal count) followed by the literal bytes,
+// until the blob is covered. Varints are LEB128 as in replay logs.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Appends the encoding of `cur` against `base` to `out`. `base` may be
+// empty (baseSize 0), which codes `cur` against zeros.
+void EncodeDelta(const uint8_t* base, size_t baseSize, const uint8_t* cur, size_t curSize, std::vector<uint8_t>& out);
+// Replaces `out` with the blob `data` encodes against `base`. False if the
+// encoding is malformed, truncated or would decode to more than maxSize.
+bool DecodeDelta(const uint8_t* base, size_t baseSize, const uint8_t* data, size_t size, size_t maxSize,
+                 std::vector<uint8_t>& out);
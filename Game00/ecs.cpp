@@ -0,0 +1,85 @@
+#include "ecs.h"
+
+#include <algorithm>
+
+Entity CreateEntity(EntityStore& store) {
+    Entity e;
+    if (!store.freeIndices.empty()) {
+        e.index = store.freeIndices.back();
+        store.freeIndices.pop_back();
+    } else {
+        e.index = static_cast<uint32_t>(store.generations.size());
+        store.generations.push_back(1);
+        store.alive.push_back(0);
+        // Grown with the index space so ClearEntities never allocates.
+        store.freeIndices.reserve(store.generations.capacity());
+    }
+    e.generation = store.generations[e.index];
+    store.alive[e.index] = 1;
+    return e;
+}
+
+template <typename T>
+static void ClearPool(ComponentPool<T>& pool) {
+    pool.dense.clear();
+    pool.owner.clear();
+    std::fill(pool.sparse.begin(), pool.sparse.end(), kNoSlot);
+}
+
+static void RemoveAllComponents(EntityStore& store, uint32_t index) {
+    RemoveComponent(store.positions, index);
+    RemoveComponent(store.velocities, index);
+    RemoveComponent(store.colliders, index);
+    RemoveComponent(store.dropCooldowns, index);
+    RemoveComponent(store.pilots, index);
+}
+
+void DestroyEntity(EntityStore& store, Entity e) {
+    if (!IsAlive(store, e)) {
+        return;
+    }
+    RemoveAllComponents(store, e.index);
+    store.alive[e.index] = 0;
+    ++store.generations[e.index];
+    store.freeIndices.push_back(e.index);
+}
+
+bool IsAlive(const EntityStore& store, Entity e) {
+    return e.index < store.generations.size() && store.alive[e.index] && store.generations[e.index] == e.generation;
+}
+
+void ClearEntities(EntityStore& store) {
+    ClearPool(store.positions);
+    ClearPool(store.velocities);
+    ClearPool(store.colliders);
+    ClearPool(store.dropCooldowns);
+    ClearPool(store.pilots);
+    // Every index goes back on the free list, lowest on top, so a store
+    // refilled in the same order hands out the same indices.
+    store.freeIndices.clear();
+    for (size_t i = store.generations.size(); i-- > 0;) {
+        if (store.alive[i]) {
+            store.alive[i] = 0;
+            ++store.generations[i];
+        }
+        store.freeIndices.push_back(static_cast<uint32_t>(i));
+    }
+}
+
+void SavePositions(EntityStore& store) {
+    for (Position& p : store.positions.dense) {
+        p.prev = p.pos;
+    }
+}
+
+void IntegrateMotion(EntityStore& store, float dt) {
+    ForEach(store.positions, store.velocities, [&](uint32_t, Position& p, const Velocity& v) {
+        p.pos = p.pos + v.vel * dt;
+    });
+}
+
+void TickCooldowns(EntityStore& store, float dt) {
+    for (DropCooldown& c : store.dropCooldowns.dense) {
+        c.seconds = std::max(0.f, c.seconds - dt);
+    }
+}
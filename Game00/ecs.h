@@ -0,0 +1,180 @@
+#pragma once
+
+// Entity-component store with one sparse-set pool per component type.
+//
+// An entity is an index plus a generation, like ProjectileHandle: destroying
+// it bumps the generation so stale copies stop resolving. Each pool keeps its
+// components packed in a dense array with a parallel array of owning entity
+// indices, plus a sparse array from entity index to dense slot. Adding is an
+// append and removing swaps the last component into the hole, so pools stay
+// dense and systems walk them front to back.
+//
+// Systems that need two components walk the smaller pool and look each
+// entity up in the other. Entities created together get the same order in
+// every pool, so for them that lookup walks the other pool in order too.
+//
+// Shells and bombs are not entities: they stay in ProjectileSoA, whose
+// split x/y arrays the SIMD ballistic kernel needs.
+
+#include "vec2.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct Entity {
+    uint32_t index = 0xFFFFFFFFu;
+    uint32_t generation = 0;
+};
+
+// Position at the end of the last step, and at its start for render
+// interpolation.
+struct Position {
+    Vec2 pos;
+    Vec2 prev;
+};
+
+struct Velocity {
+    Vec2 vel;
+};
+
+// Box of w x h with its top-left corner at the entity's position.
+struct Collider {
+    float w = 0.f;
+    float h = 0.f;
+};
+
+// Seconds until the entity may drop its next bomb.
+struct DropCooldown {
+    float seconds = 0.f;
+};
+
+// What a helicopter's AI (ai.h) last decided, and what it falls back to.
+// Altitudes are the y of the helicopter's top edge.
+struct Pilot {
+    float cruiseAlt = 0.f;
+    float cruiseSpeed = 0.f;
+    float targetAlt = 0.f;
+    float targetSpeed = 0.f;
+    // Seconds until the shell it is dodging arrives; 0 when none is.
+    float threatSeconds = 0.f;
+    // AiScheduler::step of the last decision.
+    uint32_t decidedStep = 0;
+};
+
+// Sparse entry of an entity without the component.
+const uint32_t kNoSlot = 0xFFFFFFFFu;
+
+template <typename T>
+struct ComponentPool {
+    std::vector<T> dense;
+    // Entity index owning each dense slot.
+    std::vector<uint32_t> owner;
+    // Per entity index: dense slot, or kNoSlot.
+    std::vector<uint32_t> sparse;
+};
+
+struct EntityStore {
+    // Per entity index; generations start at 1 so a default Entity never
+    // resolves.
+    std::vector<uint32_t> generations;
+    std::vector<uint8_t> alive;
+    std::vector<uint32_t> freeIndices;
+
+    ComponentPool<Position> positions;
+    ComponentPool<Velocity> velocities;
+    ComponentPool<Collider> colliders;
+    ComponentPool<DropCooldown> dropCooldowns;
+    ComponentPool<Pilot> pilots;
+};
+
+Entity CreateEntity(EntityStore& store);
+// Removes every component of the entity and invalidates its handles. Lists
+// of handles outside the store are not touched; helicopters go through
+// DestroyHelicopter (sim.h), which also drops them from World::helicopters.
+void DestroyEntity(EntityStore& store, Entity e);
+bool IsAlive(const EntityStore& store, Entity e);
+// Destroys everything, keeping the memory for reuse.
+void ClearEntities(EntityStore& store);
+
+template <typename T>
+inline bool HasComponent(const ComponentPool<T>& pool, uint32_t index) {
+    return index < pool.sparse.size() && pool.sparse[index] != kNoSlot;
+}
+
+// Adds or replaces the entity's component.
+template <typename T>
+inline T& AddComponent(ComponentPool<T>& pool, Entity e, const T& value) {
+    if (e.index >= pool.sparse.size()) {
+        pool.sparse.resize(static_cast<size_t>(e.index) + 1, kNoSlot);
+    }
+    uint32_t& slot = pool.sparse[e.index];
+    if (slot == kNoSlot) {
+        slot = static_cast<uint32_t>(pool.dense.size());
+        pool.dense.push_back(value);
+        pool.owner.push_back(e.index);
+    } else {
+        pool.dense[slot] = value;
+    }
+    return pool.dense[slot];
+}
+
+template <typename T>
+inline void RemoveComponent(ComponentPool<T>& pool, uint32_t index) {
+    if (!HasComponent(pool, index)) {
+        return;
+    }
+    const uint32_t slot = pool.sparse[index];
+    const uint32_t last = static_cast<uint32_t>(pool.dense.size() - 1);
+    if (slot != last) {
+        pool.dense[slot] = pool.dense[last];
+        pool.owner[slot] = pool.owner[last];
+        pool.sparse[pool.owner[slot]] = slot;
+    }
+    pool.dense.pop_back();
+    pool.owner.pop_back();
+    pool.sparse[index] = kNoSlot;
+}
+
+// The entity must have the component.
+template <typename T>
+inline T& GetComponent(ComponentPool<T>& pool, Entity e) {
+    assert(HasComponent(pool, e.index));
+    return pool.dense[pool.sparse[e.index]];
+}
+
+template <typename T>
+inline const T& GetComponent(const ComponentPool<T>& pool, Entity e) {
+    assert(HasComponent(pool, e.index));
+    return pool.dense[pool.sparse[e.index]];
+}
+
+// Calls fn(index, a, b) for every entity with both components.
+template <typename A, typename B, typename Fn>
+inline void ForEach(ComponentPool<A>& a, ComponentPool<B>& b, Fn&& fn) {
+    if (a.dense.size() <= b.dense.size()) {
+        for (size_t i = 0; i < a.dense.size(); ++i) {
+            const uint32_t index = a.owner[i];
+            if (HasComponent(b, index)) {
+                fn(index, a.dense[i], b.dense[b.sparse[index]]);
+            }
+        }
+    } else {
+        for (size_t i = 0; i < b.dense.size(); ++i) {
+            const uint32_t index = b.owner[i];
+            if (HasComponent(a, index)) {
+                fn(index, a.dense[a.sparse[index]], b.dense[i]);
+            }
+        }
+    }
+}
+
+// Systems, in the order StepWorld runs them.
+
+// prev = pos for every Position.
+void SavePositions(EntityStore& store);
+// pos += vel * dt for every Position + Velocity.
+void IntegrateMotion(EntityStore& store, float dt);
+// Counts every DropCooldown down to 0.
+void TickCooldowns(EntityStore& store, float dt);
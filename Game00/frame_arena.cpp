@@ -0,0 +1,40 @@
+#include "frame_arena.h"
+
+#include <algorithm>
+
+void InitFrameArena(FrameArena& arena, size_t bytes) {
+    arena.block.reset(new uint8_t[bytes]);
+    arena.capacity = bytes;
+    arena.used = 0;
+    arena.spill.clear();
+    arena.frameBytes = 0;
+    arena.highWater = 0;
+    arena.spills = 0;
+}
+
+void* ArenaAlloc(FrameArena& arena, size_t bytes, size_t align) {
+    arena.frameBytes += bytes + align - 1;
+    const uintptr_t base = reinterpret_cast<uintptr_t>(arena.block.get());
+    const uintptr_t at = (base + arena.used + align - 1) & ~static_cast<uintptr_t>(align - 1);
+    if (arena.block && at + bytes <= base + arena.capacity) {
+        arena.used = at + bytes - base;
+        return reinterpret_cast<void*>(at);
+    }
+    ++arena.spills;
+    arena.spill.emplace_back(new uint8_t[bytes + align]);
+    const uintptr_t spilled = reinterpret_cast<uintptr_t>(arena.spill.back().get());
+    return reinterpret_cast<void*>((spilled + align - 1) & ~static_cast<uintptr_t>(align - 1));
+}
+
+void ResetFrameArena(FrameArena& arena) {
+    arena.highWater = std::max(arena.highWater, arena.frameBytes);
+    if (!arena.spill.empty()) {
+        // Room for the biggest frame so far, and some to spare.
+        arena.spill.clear();
+        const size_t bytes = arena.highWater + arena.highWater / 2;
+        arena.block.reset(new uint8_t[bytes]);
+        arena.capacity = bytes;
+    }
+    arena.used = 0;
+    arena.frameBytes = 0;
+}
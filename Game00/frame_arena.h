@@ -0,0 +1,64 @@
+#pragma once
+
+// Linear allocator for data that lives for one frame: allocating bumps a
+// pointer, and ResetFrameArena at the end of the frame frees everything at
+// once. Only trivially destructible types belong here; nothing is
+// destroyed.
+//
+// The block is sized up front. A frame that needs more spills into extra
+// heap blocks, and the next reset regrows the block to the largest frame
+// seen, so a one-off spike costs one allocation rather than a failure.
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+struct FrameArena {
+    std::unique_ptr<uint8_t[]> block;
+    size_t capacity = 0;
+    size_t used = 0;
+    std::vector<std::unique_ptr<uint8_t[]>> spill;
+    // Bytes asked for this frame (spill included), and the most any frame
+    // has asked for.
+    size_t frameBytes = 0;
+    size_t highWater = 0;
+    uint64_t spills = 0;
+};
+
+void InitFrameArena(FrameArena& arena, size_t bytes);
+// Never fails; past the block it spills to the heap.
+void* ArenaAlloc(FrameArena& arena, size_t bytes, size_t align);
+// Frees everything allocated since the last reset.
+void ResetFrameArena(FrameArena& arena);
+
+// Fixed-capacity array in the arena, for lists whose size has a known bound
+// each frame. Pushing past the capacity is a bug and is dropped.
+template <typename T>
+struct FrameArray {
+    static_assert(std::is_trivially_destructible<T>::value, "the arena never runs destructors");
+    T* data = nullptr;
+    size_t size = 0;
+    size_t capacity = 0;
+
+    void push_back(const T& value) {
+        if (size < capacity) {
+            data[size++] = value;
+        }
+    }
+    T& operator[](size_t i) { return data[i]; }
+    const T& operator[](size_t i) const { return data[i]; }
+    T* begin() { return data; }
+    T* end() { return data + size; }
+    const T* begin() const { return data; }
+    const T* end() const { return data + size; }
+};
+
+template <typename T>
+FrameArray<T> MakeFrameArray(FrameArena& arena, size_t capacity) {
+    FrameArray<T> a;
+    a.data = static_cast<T*>(ArenaAlloc(arena, capacity * sizeof(T), alignof(T)));
+    a.capacity = capacity;
+    return a;
+}
@@ -0,0 +1,150 @@
+#include "frame_pacer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#ifdef _WIN32
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#  ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#    define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#  endif
+#endif
+
+static const int kMaxInterval = 4;
+static const double kMinWakeMargin = 0.0002;
+static const double kMaxWakeMargin = 0.004;
+
+static double NowSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Coarse sleep. The high-resolution timer (Windows 10 1803+) wakes within a
+// fraction of a millisecond without raising the system timer rate; without
+// it this falls back to the standard sleep.
+static void SleepSeconds(FramePacer& pacer, double seconds) {
+#ifdef _WIN32
+    if (pacer.timer) {
+        LARGE_INTEGER due{};
+        due.QuadPart = -static_cast<LONGLONG>(seconds * 1e7); // relative, 100 ns units
+        if (SetWaitableTimer(static_cast<HANDLE>(pacer.timer), &due, 0, nullptr, nullptr, FALSE)) {
+            WaitForSingleObject(static_cast<HANDLE>(pacer.timer), INFINITE);
+            return;
+        }
+    }
+#else
+    (void)pacer;
+#endif
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+}
+
+static void UpdateWakeMargin(FramePacer& pacer) {
+    float sorted[FramePacer::kOvershoots] = {};
+    const size_t n = pacer.overshootCount;
+    std::copy(pacer.overshoot, pacer.overshoot + n, sorted);
+    float* p90 = sorted + n * 9 / 10;
+    std::nth_element(sorted, p90, sorted + n);
+    pacer.wakeMargin = std::min(std::max(static_cast<double>(*p90) * 1.1, kMinWakeMargin), kMaxWakeMargin);
+}
+
+void InitFramePacer(FramePacer& pacer, double targetHz) {
+    pacer.targetPeriod = 1.0 / std::max(targetHz, 1.0);
+    pacer.interval = 1;
+    pacer.lastWake = NowSeconds();
+    pacer.deadline = pacer.lastWake;
+    pacer.workEma = 0.0;
+    pacer.head = 0;
+    pacer.count = 0;
+    pacer.overshootHead = 0;
+    pacer.overshootCount = 0;
+#ifdef _WIN32
+    if (!pacer.timer) {
+        pacer.timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    }
+#endif
+}
+
+void DestroyFramePacer(FramePacer& pacer) {
+#ifdef _WIN32
+    if (pacer.timer) {
+        CloseHandle(static_cast<HANDLE>(pacer.timer));
+    }
+#endif
+    pacer.timer = nullptr;
+}
+
+void PaceFrame(FramePacer& pacer) {
+    const double workEnd = NowSeconds();
+    const double work = workEnd - pacer.lastWake;
+    pacer.workEma = pacer.workEma > 0.0 ? pacer.workEma + (work - pacer.workEma) * 0.1 : work;
+
+    // Smallest whole multiple of the target period the work fits in, with
+    // some headroom so a frame that only just fits does not flap.
+    const int fits = static_cast<int>(std::ceil(pacer.workEma * 1.1 / pacer.targetPeriod));
+    pacer.interval = std::min(std::max(fits, 1), kMaxInterval);
+
+    pacer.deadline += pacer.interval * pacer.targetPeriod;
+    if (pacer.deadline < workEnd) {
+        // Missed it; start over from now rather than rushing to catch up.
+        pacer.deadline = workEnd;
+    }
+
+    const double remaining = pacer.deadline - workEnd;
+    if (remaining > pacer.wakeMargin) {
+        const double request = remaining - pacer.wakeMargin;
+        const double sleepStart = NowSeconds();
+        SleepSeconds(pacer, request);
+        pacer.overshoot[pacer.overshootHead] = static_cast<float>(NowSeconds() - sleepStart - request);
+        pacer.overshootHead = (pacer.overshootHead + 1) % FramePacer::kOvershoots;
+        pacer.overshootCount = std::min(pacer.overshootCount + 1, FramePacer::kOvershoots);
+        UpdateWakeMargin(pacer);
+    }
+
+    const double spinStart = NowSeconds();
+    double now = spinStart;
+    while (now < pacer.deadline) {
+        std::this_thread::yield();
+        now = NowSeconds();
+    }
+
+    pacer.frameMs[pacer.head] = static_cast<float>((now - pacer.lastWake) * 1e3);
+    pacer.spinMs[pacer.head] = static_cast<float>((now - spinStart) * 1e3);
+    pacer.workMs[pacer.head] = static_cast<float>(work * 1e3);
+    pacer.head = (pacer.head + 1) % FramePacer::kWindow;
+    pacer.count = std::min(pacer.count + 1, FramePacer::kWindow);
+    pacer.lastWake = now;
+}
+
+FramePacerStats GetFramePacerStats(const FramePacer& pacer) {
+    FramePacerStats stats;
+    stats.targetMs = pacer.targetPeriod * 1e3;
+    stats.periodMs = stats.targetMs * pacer.interval;
+    if (pacer.count == 0) {
+        return stats;
+    }
+    double sum = 0.0;
+    double spin = 0.0;
+    double work = 0.0;
+    for (size_t i = 0; i < pacer.count; ++i) {
+        sum += pacer.frameMs[i];
+        spin += pacer.spinMs[i];
+        work += pacer.workMs[i];
+    }
+    const double n = static_cast<double>(pacer.count);
+    stats.meanMs = sum / n;
+    stats.spinMs = spin / n;
+    stats.workMs = work / n;
+    double var = 0.0;
+    for (size_t i = 0; i < pacer.count; ++i) {
+        const double d = pacer.frameMs[i] - stats.meanMs;
+        var += d * d;
+        stats.worstErrorMs = std::max(stats.worstErrorMs, std::abs(pacer.frameMs[i] - stats.periodMs));
+    }
+    stats.jitterMs = std::sqrt(var / n);
+    return stats;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+// Frame pacing for the window loops. PaceFrame blocks until the next frame
+// is due: it sleeps for most of the wait and then spins only for the last
+// stretch, sized from how late recent sleeps woke up, so an idle instance
+// uses almost no CPU and frames still start on time.
+//
+// When a frame's work no longer fits in the period, the pacer moves to a
+// whole multiple of it (120 -> 60 -> 40 -> 30 Hz) instead of running at an
+// irregular rate, and goes back once the work fits again.
+
+#include <cstddef>
+
+struct FramePacerStats {
+    double targetMs = 0.0;
+    // Current period after adapting to the frame cost.
+    double periodMs = 0.0;
+    // Frame-to-frame time over the recent window.
+    double meanMs = 0.0;
+    double jitterMs = 0.0;    // standard deviation
+    double worstErrorMs = 0.0; // largest distance from the period
+    // Average frame work, and how much of each frame went to the precise
+    // wait (the part that keeps a core busy).
+    double workMs = 0.0;
+    double spinMs = 0.0;
+};
+
+struct FramePacer {
+    static constexpr size_t kWindow = 240;
+
+    double targetPeriod = 1.0 / 60.0;
+    int interval = 1;
+    double deadline = 0.0;
+    double lastWake = 0.0;
+    double workEma = 0.0;
+    // Expected sleep overshoot (90th percentile of the recent ones); waits
+    // shorter than this are spun. The rare much later wake is cheaper to
+    // eat as one late frame than to spin for on every frame.
+    double wakeMargin = 0.002;
+    static constexpr size_t kOvershoots = 64;
+    float overshoot[kOvershoots] = {};
+    size_t overshootHead = 0;
+    size_t overshootCount = 0;
+
+    float frameMs[kWindow] = {};
+    float spinMs[kWindow] = {};
+    float workMs[kWindow] = {};
+    size_t head = 0;
+    size_t count = 0;
+
+    // High-resolution waitable timer on Windows, null elsewhere.
+    void* timer = nullptr;
+};
+
+void InitFramePacer(FramePacer& pacer, double targetHz);
+void DestroyFramePacer(FramePacer& pacer);
+// Call once per frame after presenting. Everything since the previous call
+// returned counts as the frame's work.
+void PaceFrame(FramePacer& pacer);
+FramePacerStats GetFramePacerStats(const FramePacer& pacer);
@@ -0,0 +1,80 @@
+#include "grid.h"
+
+#include <algorithm>
+#include <cmath>
+
+void ConfigureGrid(UniformGrid& grid, float minX, float minY, float maxX, float maxY, float cellW, float cellH) {
+    grid.minX = minX;
+    grid.minY = minY;
+    grid.invCellW = 1.f / cellW;
+    grid.invCellH = 1.f / cellH;
+    grid.cols = std::max(1, static_cast<int>(std::ceil((maxX - minX) / cellW)));
+    grid.rows = std::max(1, static_cast<int>(std::ceil((maxY - minY) / cellH)));
+    const size_t cells = static_cast<size_t>(grid.cols) * static_cast<size_t>(grid.rows);
+    grid.cellStart.assign(cells + 1, 0);
+    grid.cursor.assign(cells, 0);
+    grid.items.clear();
+}
+
+void BuildGrid(UniformGrid& grid, const AABB* boxes, size_t count) {
+    const size_t cells = grid.cursor.size();
+    std::fill(grid.cursor.begin(), grid.cursor.end(), 0u);
+
+    // Pass 1: count how many boxes touch each cell.
+    for (size_t i = 0; i < count; ++i) {
+        const AABB& b = boxes[i];
+        int c0 = GridCol(grid, b.minX);
+        int c1 = GridCol(grid, b.maxX);
+        int r0 = GridRow(grid, b.minY);
+        int r1 = GridRow(grid, b.maxY);
+        for (int r = r0; r <= r1; ++r) {
+            for (int c = c0; c <= c1; ++c) {
+                ++grid.cursor[r * grid.cols + c];
+            }
+        }
+    }
+
+    uint32_t total = 0;
+    for (size_t c = 0; c < cells; ++c) {
+        grid.cellStart[c] = total;
+        total += grid.cursor[c];
+        grid.cursor[c] = grid.cellStart[c];
+    }
+    grid.cellStart[cells] = total;
+    grid.items.resize(total);
+
+    // Pass 2: scatter. Items within a cell stay in ascending box order.
+    for (size_t i = 0; i < count; ++i) {
+        const AABB& b = boxes[i];
+        int c0 = GridCol(grid, b.minX);
+        int c1 = GridCol(grid, b.maxX);
+        int r0 = GridRow(grid, b.minY);
+        int r1 = GridRow(grid, b.maxY);
+        for (int r = r0; r <= r1; ++r) {
+            for (int c = c0; c <= c1; ++c) {
+                grid.items[grid.cursor[r * grid.cols + c]++] = static_cast<uint32_t>(i);
+            }
+        }
+    }
+}
+
+void BuildGridCells(UniformGrid& grid, const uint32_t* cells, size_t count) {
+    const size_t cellCount = grid.cursor.size();
+    std::fill(grid.cursor.begin(), grid.cursor.end(), 0u);
+    for (size_t i = 0; i < count; ++i) {
+        ++grid.cursor[cells[i]];
+    }
+
+    uint32_t total = 0;
+    for (size_t c = 0; c < cellCount; ++c) {
+        grid.cellStart[c] = total;
+        total += grid.cursor[c];
+        grid.cursor[c] = grid.cellStart[c];
+    }
+    grid.cellStart[cellCount] = total;
+    grid.items.resize(total);
+
+    for (size_t i = 0; i < count; ++i) {
+        grid.items[grid.cursor[cells[i]]++] = static_cast<uint32_t>(i);
+    }
+}
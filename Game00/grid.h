@@ -0,0 +1,92 @@
+#pragma once
+
+// Uniform grid broadphase. Boxes are bucketed into every cell they overlap
+// with a two-pass counting sort (no per-cell containers), so a rebuild each
+// tick costs O(boxes + cells) and reuses the same buffers.
+//
+// Anything outside the configured extent is clamped to the border cells, so
+// queries stay correct for off-screen objects; they are just less selective.
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+struct AABB {
+    float minX;
+    float minY;
+    float maxX;
+    float maxY;
+};
+
+struct UniformGrid {
+    float minX = 0.f;
+    float minY = 0.f;
+    float invCellW = 1.f;
+    float invCellH = 1.f;
+    int cols = 1;
+    int rows = 1;
+    // Items of cell c are items[cellStart[c] .. cellStart[c + 1]).
+    std::vector<uint32_t> cellStart;
+    std::vector<uint32_t> items;
+    std::vector<uint32_t> cursor;
+};
+
+void ConfigureGrid(UniformGrid& grid, float minX, float minY, float maxX, float maxY, float cellW, float cellH);
+void BuildGrid(UniformGrid& grid, const AABB* boxes, size_t count);
+// For things that each sit in one cell, already worked out by the caller:
+// item i goes in cells[i].
+void BuildGridCells(UniformGrid& grid, const uint32_t* cells, size_t count);
+
+inline int GridCol(const UniformGrid& grid, float x) {
+    int c = static_cast<int>((x - grid.minX) * grid.invCellW);
+    return c < 0 ? 0 : (c >= grid.cols ? grid.cols - 1 : c);
+}
+
+inline int GridRow(const UniformGrid& grid, float y) {
+    int r = static_cast<int>((y - grid.minY) * grid.invCellH);
+    return r < 0 ? 0 : (r >= grid.rows ? grid.rows - 1 : r);
+}
+
+inline int GridCellAt(const UniformGrid& grid, float x, float y) {
+    return GridRow(grid, y) * grid.cols + GridCol(grid, x);
+}
+
+// Slab test of the segment (x0, y0) -> (x1, y1) against a closed box. On a
+// hit, tHit is the entry point as a fraction of the segment (0 when the
+// segment starts inside).
+inline bool SweepSegmentAABB(float x0, float y0, float x1, float y1, const AABB& box, float& tHit) {
+    // Most tests are misses with the whole segment on one side of the box.
+    if ((x0 < box.minX && x1 < box.minX) || (x0 > box.maxX && x1 > box.maxX) ||
+        (y0 < box.minY && y1 < box.minY) || (y0 > box.maxY && y1 > box.maxY)) {
+        return false;
+    }
+    float tMin = 0.f;
+    float tMax = 1.f;
+    const float d[2] = { x1 - x0, y1 - y0 };
+    const float p[2] = { x0, y0 };
+    const float lo[2] = { box.minX, box.minY };
+    const float hi[2] = { box.maxX, box.maxY };
+    for (int axis = 0; axis < 2; ++axis) {
+        if (d[axis] == 0.f) {
+            if (p[axis] < lo[axis] || p[axis] > hi[axis]) {
+                return false;
+            }
+            continue;
+        }
+        const float inv = 1.f / d[axis];
+        float t0 = (lo[axis] - p[axis]) * inv;
+        float t1 = (hi[axis] - p[axis]) * inv;
+        if (t0 > t1) {
+            const float tmp = t0;
+            t0 = t1;
+            t1 = tmp;
+        }
+        tMin = t0 > tMin ? t0 : tMin;
+        tMax = t1 < tMax ? t1 : tMax;
+        if (tMin > tMax) {
+            return false;
+        }
+    }
+    tHit = tMin;
+    return true;
+}
@@ -0,0 +1,1007 @@
+// Headless driver for the simulation in sim.cpp. Runs the game loop without a
+// window as fast as the CPU allows and reports ticks per second.
+//
+// Build (Linux):  g++ -std=c++17 -O2 headless.cpp sim.cpp ecs.cpp ai.cpp projectiles.cpp grid.cpp render_soft.cpp scene.cpp hud.cpp
+//                     particles.cpp sprite_cache.cpp trajectory.cpp render_state.cpp sim_thread.cpp snapshot.cpp
+//                     replay.cpp profile.cpp frame_pacer.cpp atlas.cpp delta.cpp net.cpp rewind.cpp frame_arena.cpp alloc_count.cpp
+//                     input.cpp -pthread -o headless
+// Usage:          headless [--ticks N] [--hz RATE] [--seed N] [--helis N] [--stress N]
+//                          [--render] [--dirty] [--particles] [--dump PATH] [--aim] [--threaded] [--pace FPS]
+//                          [--record PATH] [--keyframe N] [--replay PATH] [--seek TICK] [--trace PATH]
+//                          [--particle-stress N] [--atlas PATH] [--net N] [--net-loss P]
+//                          [--serve PORT] [--players N] [--rewind SECONDS] [--rewind-raw] [--ai-budget UNITS]
+//                          [--taps N]
+//
+// --render draws every tick with the software renderer and reports the
+// render cost separately; --dump writes the last frame as .ppm or .png.
+// --dirty renders through DrawSceneDirty instead, reports how much of the
+// screen it redraws per frame and checks the result against a full redraw.
+// --particles adds the hit effects to what is rendered.
+// --particle-stress N skips the game and keeps N particles alive for --ticks
+// 60 Hz frames, timing the update and the additive draw per frame.
+// --aim solves firing angles for every helicopter each tick (and draws
+// them when rendering). --threaded runs the simulation on its own thread
+// and renders/aims on the main thread from the latest published state.
+// --pace FPS does the same in real time, like the game: the simulation runs
+// at its tick rate and frames are paced to FPS, and it reports the frame
+// jitter and CPU use.
+// --record writes the scripted session to a replay log (keyframe every N
+// steps); --replay plays a log back at full speed, checks it against its
+// keyframes and times a seek to --seek TICK. Built with -DCGAME_PROFILE=1,
+// it prints per-phase step percentiles and --trace writes a Chrome trace.
+// --atlas draws the tank from a packed sprite atlas (atlas_pack.cpp) and
+// reports how long loading it took.
+// --net N plays a co-op session (net.h) with a server and N clients in this
+// process over loopback, dropping --net-loss P of all packets, and reports
+// the server's tick cost, the bandwidth per client and the prediction
+// errors. --serve PORT runs a dedicated server for --players N game
+// clients in real time.
+// --rewind SECONDS keeps that much of the session in a rewind buffer
+// (rewind.h), then plays all of it backwards, timing capture and restore
+// per step and checking each rewound state; --rewind-raw stores full
+// snapshots instead of deltas.
+// Every run reports the helicopter AI's wall time per step (mean and worst)
+// and how its decisions were spread; --ai-budget sets SimConfig::aiBudget.
+// --taps N plays N fire taps of 2 to 40 ms against the step schedule, once
+// polled at every step and once through the input queue (input.h), and
+// reports the taps each lost and how far their shots left from the press.
+//
+// Apart from --replay and --serve, every mode counts heap allocations
+// (alloc_count.h) once its buffers have warmed up and exits with 1 if there
+// were any.
+
+#include "sim.h"
+#include "alloc_count.h"
+#include "atlas.h"
+#include "render_soft.h"
+#include "scene.h"
+#include "particles.h"
+#include "sim_thread.h"
+#include "replay.h"
+#include "profile.h"
+#include "frame_pacer.h"
+#include "net.h"
+#include "rewind.h"
+#include "input.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <atomic>
+#include <thread>
+
+// Deterministic stand-in for the keyboard: sweeps the turret back and forth
+// and taps fire at a steady rate, each press at a different point of its
+// step.
+static SimInput ScriptedInput(uint64_t tick) {
+    SimInput in{};
+    uint64_t phase = tick % 480;
+    in.left = phase < 240;
+    in.right = !in.left;
+    in.fire = (tick % 24) < 2;
+    in.firePhase = static_cast<uint8_t>((tick / 24 * 7) % kFirePhases);
+    return in;
+}
+
+// Keeps the shell count topped up to `target` with a fan of synthetic shots
+// from the tank, so the integration and collision loops see a dense scene.
+static void TopUpShells(World& world, size_t target, uint64_t& counter) {
+    const Vec2 base = TurretBase(world, 0);
+    while (world.shells.count < target && !IsFull(world.shells)) {
+        float deg = 20.f + static_cast<float>((counter * 37) % 140);
+        float speed = world.cfg.projectileSpeed * (0.6f + 0.4f * static_cast<float>(counter % 11) / 10.f);
+        float rad = deg * 3.14159265f / 180.f;
+        SpawnProjectile(world.shells, base.x, base.y, std::cos(rad) * speed, -std::sin(rad) * speed);
+        ++counter;
+    }
+}
+
+// State of the scripted run, advanced one step at a time either inline or
+// from the simulation thread.
+struct HeadlessRun {
+    SimConfig cfg;
+    uint32_t seed = 1;
+    size_t stress = 0;
+    uint64_t stressCounter = 0;
+    uint64_t warmupTicks = 0;
+    uint64_t allocsAtWarmup = 0;
+    uint64_t games = 1;
+    uint64_t totalScore = 0;
+    ReplayRecorder* recorder = nullptr;
+    // Helicopter AI after warmup: wall time, decisions (and those cut
+    // short by the budget), and the worst step and wait.
+    uint64_t aiSteps = 0;
+    uint64_t aiNs = 0;
+    uint64_t aiMaxNs = 0;
+    uint64_t aiDecisions = 0;
+    uint64_t aiUrgent = 0;
+    uint64_t aiCutShort = 0;
+    uint32_t aiMaxUnits = 0;
+    uint32_t aiMaxWait = 0;
+};
+
+static void HeadlessStep(void* user, World& world, uint64_t tick, double) {
+    HeadlessRun& run = *static_cast<HeadlessRun*>(user);
+    if (run.stress) {
+        TopUpShells(world, run.stress, run.stressCounter);
+    }
+    if (tick == run.warmupTicks) {
+        run.allocsAtWarmup = HeapAllocations();
+    }
+    const SimInput input = ScriptedInput(tick);
+    if (run.recorder) {
+        RecordTick(*run.recorder, world, input);
+    }
+    StepWorld(world, 1.f / run.cfg.tickRateHz, input);
+    if (tick >= run.warmupTicks) {
+        const AiScheduler& ai = world.ai;
+        ++run.aiSteps;
+        run.aiNs += ai.stepNs;
+        run.aiMaxNs = std::max(run.aiMaxNs, ai.stepNs);
+        run.aiDecisions += ai.decisions;
+        run.aiUrgent += ai.urgentDecisions;
+        run.aiCutShort += ai.cutShort;
+        run.aiMaxUnits = std::max(run.aiMaxUnits, ai.units);
+        run.aiMaxWait = std::max(run.aiMaxWait, ai.maxWait);
+    }
+    if (world.gameOver) {
+        run.totalScore += world.score;
+        const uint32_t seed = run.seed + static_cast<uint32_t>(run.games);
+        InitWorld(world, run.cfg, seed);
+        if (run.recorder) {
+            RecordRestart(*run.recorder, seed);
+        }
+        ++run.games;
+    }
+}
+
+// Plays a recorded log back as fast as possible, checking every keyframe on
+// the way, then times a seek to `seekTick` against the full run.
+static int PlayReplay(const char* path, uint64_t seekTick) {
+    ReplayLog log;
+    if (!LoadReplay(path, log)) {
+        std::fprintf(stderr, "failed to read %s\n", path);
+        return 1;
+    }
+    ReplayPlayer player;
+    InitReplayPlayer(player, log);
+    const uint64_t ticks = log.inputs.size();
+    seekTick = seekTick < ticks ? seekTick : ticks;
+    uint64_t seekChecksum = WorldChecksum(player.world);
+
+    auto start = std::chrono::steady_clock::now();
+    while (StepReplay(player)) {
+        if (player.tick == seekTick) {
+            seekChecksum = WorldChecksum(player.world);
+        }
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const uint64_t endChecksum = WorldChecksum(player.world);
+
+    std::printf("replay:      %s\n", path);
+    std::printf("ticks:       %llu (%zu keyframes, %zu restarts)\n", static_cast<unsigned long long>(ticks),
+                log.keyframes.size(), log.restarts.size());
+    std::printf("elapsed:     %.3f s\n", seconds);
+    std::printf("ticks/sec:   %.0f\n", seconds > 0.0 ? static_cast<double>(ticks) / seconds : 0.0);
+    std::printf("checksum:    %016llx\n", static_cast<unsigned long long>(endChecksum));
+    if (player.desyncTick != ~0ull) {
+        std::printf("desync:      state differs from the recording at tick %llu\n",
+                    static_cast<unsigned long long>(player.desyncTick));
+    }
+
+    auto s0 = std::chrono::steady_clock::now();
+    const uint64_t stepped = SeekReplay(player, seekTick);
+    const double seekMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - s0).count();
+    const bool seekOk = WorldChecksum(player.world) == seekChecksum;
+    std::printf("seek:        tick %llu, %llu steps past the keyframe, %.3f ms, %s\n",
+                static_cast<unsigned long long>(seekTick), static_cast<unsigned long long>(stepped), seekMs,
+                seekOk ? "state matches" : "STATE DIFFERS");
+    return player.desyncTick == ~0ull && seekOk ? 0 : 1;
+}
+
+// Keeps `target` particles alive over `frames` frames of 1/60 s, topping the
+// pools up with bursts all over the screen, and reports the update and draw
+// cost per frame against the 16.7 ms a 60 fps frame has.
+static int ParticleStress(size_t target, uint64_t frames) {
+    const SimConfig cfg{};
+    SoftRenderer renderer(static_cast<int>(cfg.screenWidth), static_cast<int>(cfg.screenHeight));
+    ParticleSystem particles;
+    InitParticleSystem(particles, target, 64);
+    Pcg32 spots;
+    const float dt = 1.f / 60.f;
+    const uint64_t warmup = frames <= 60 ? frames / 2 : 60;
+    double updateSeconds = 0.0;
+    double drawSeconds = 0.0;
+    double live = 0.0;
+    uint64_t allocsAtWarmup = 0;
+    for (uint64_t f = 0; f < frames; ++f) {
+        if (f == warmup) {
+            allocsAtWarmup = HeapAllocations();
+            updateSeconds = drawSeconds = live = 0.0;
+        }
+        // The mix a helicopter hit emits, all over the screen.
+        while (LiveParticles(particles) + 96 <= target) {
+            const float x = UniformFloat(spots, 0.f, cfg.screenWidth);
+            const float y = UniformFloat(spots, 0.f, cfg.screenHeight);
+            EmitBurst(particles, ParticleDebris, x, y, 48);
+            EmitBurst(particles, ParticleSmoke, x, y, 42);
+            EmitBurst(particles, ParticleFlash, x, y, 3);
+        }
+        auto u0 = std::chrono::steady_clock::now();
+        UpdateParticles(particles, dt);
+        auto d0 = std::chrono::steady_clock::now();
+        renderer.Clear(Argb(255, 18, 26, 36));
+        DrawParticles(renderer, particles);
+        auto d1 = std::chrono::steady_clock::now();
+        updateSeconds += std::chrono::duration<double>(d0 - u0).count();
+        drawSeconds += std::chrono::duration<double>(d1 - d0).count();
+        live += static_cast<double>(LiveParticles(particles));
+    }
+    const double measured = static_cast<double>(frames > warmup ? frames - warmup : 1);
+    const double updateMs = updateSeconds * 1e3 / measured;
+    const double drawMs = drawSeconds * 1e3 / measured;
+    std::printf("kernel:      %s\n", BallisticKernelName());
+    std::printf("particles:   %.0f live on average, %llu frames\n", live / measured, static_cast<unsigned long long>(frames));
+    std::printf("update:      %.3f ms/frame (%.2f ns/particle)\n", updateMs, updateMs * 1e6 / std::max(live / measured, 1.0));
+    std::printf("draw:        %.3f ms/frame\n", drawMs);
+    std::printf("budget:      %.1f%% of a 60 fps frame\n", 100.0 * (updateMs + drawMs) / (1e3 / 60.0));
+    const uint64_t allocs = HeapAllocations() - allocsAtWarmup;
+    std::printf("heap allocs: %llu after warmup\n", static_cast<unsigned long long>(allocs));
+    return allocs == 0 ? 0 : 1;
+}
+
+// Runs the scripted session for `ticks` steps, capturing every step into a
+// rewind buffer holding `seconds` of play, then rewinds through all of it.
+// Reports what capturing and restoring a step cost and how many bytes a
+// stored step takes, and checks every rewound state against the checksum
+// recorded for it on the way forward.
+static int RewindBench(const SimConfig& cfg, uint32_t seed, uint64_t ticks, size_t stress, double seconds, bool compress) {
+    HeadlessRun run;
+    run.cfg = cfg;
+    run.seed = seed;
+    run.stress = stress;
+    run.warmupTicks = ticks <= 1000 ? ticks / 2 : 1000;
+    World world;
+    InitWorld(world, cfg, seed);
+
+    const size_t maxFrames = static_cast<size_t>(std::max(seconds * cfg.tickRateHz, 1.0));
+    RewindBuffer rewind;
+    rewind.compress = compress;
+    InitRewindBuffer(rewind, cfg, maxFrames, size_t(64) << 20);
+    std::vector<uint64_t> checksums(maxFrames + 1);
+    CaptureRewind(rewind, world);
+    checksums[0] = WorldChecksum(world);
+
+    double captureSeconds = 0.0;
+    double worstCapture = 0.0;
+    uint64_t snapshotBytes = 0;
+    for (uint64_t t = 0; t < ticks; ++t) {
+        HeadlessStep(&run, world, t, 0.0);
+        auto c0 = std::chrono::steady_clock::now();
+        CaptureRewind(rewind, world);
+        const double c = std::chrono::duration<double>(std::chrono::steady_clock::now() - c0).count();
+        captureSeconds += c;
+        worstCapture = std::max(worstCapture, c);
+        snapshotBytes += rewind.current.size();
+        checksums[(t + 1) % checksums.size()] = WorldChecksum(world);
+    }
+    const uint64_t allocs = HeapAllocations() - run.allocsAtWarmup;
+    const size_t kept = rewind.count;
+    const size_t keptBytes = rewind.bytesUsed;
+
+    double restoreSeconds = 0.0;
+    double worstRestore = 0.0;
+    uint64_t tick = ticks;
+    uint64_t mismatches = 0;
+    for (;;) {
+        auto r0 = std::chrono::steady_clock::now();
+        if (!RewindStep(rewind, world)) {
+            break;
+        }
+        const double r = std::chrono::duration<double>(std::chrono::steady_clock::now() - r0).count();
+        restoreSeconds += r;
+        worstRestore = std::max(worstRestore, r);
+        --tick;
+        mismatches += WorldChecksum(world) != checksums[tick % checksums.size()] ? 1 : 0;
+    }
+
+    const double n = static_cast<double>(ticks ? ticks : 1);
+    const double k = static_cast<double>(kept ? kept : 1);
+    std::printf("rewind:      %zu of %zu steps kept (%.1f s), %.2f MB\n", kept, maxFrames,
+                static_cast<double>(kept) / cfg.tickRateHz, static_cast<double>(keptBytes) / (1 << 20));
+    std::printf("stored:      %.1f B/step %s vs %.1f B snapshots\n", static_cast<double>(keptBytes) / k,
+                compress ? "delta-coded" : "raw", static_cast<double>(snapshotBytes) / n);
+    std::printf("capture:     %.3f us/step, worst %.3f us\n", captureSeconds * 1e6 / n, worstCapture * 1e6);
+    std::printf("restore:     %.3f us/step, worst %.3f us\n", restoreSeconds * 1e6 / k, worstRestore * 1e6);
+    std::printf("heap allocs: %llu after warmup\n", static_cast<unsigned long long>(allocs));
+    std::printf("states:      %llu of %zu rewound steps differ from the original\n",
+                static_cast<unsigned long long>(mismatches), kept);
+    return mismatches == 0 && allocs == 0 ? 0 : 1;
+}
+
+// Plays `taps` fire taps against the step schedule in simulated time, once
+// polling the key at the end of every step, the moment the step would run,
+// and once through the input queue. Taps are 2 to 40 ms long and further
+// apart than the fire cooldown, so every one should fire. Reports per way
+// how many were lost, how far from the press the shot left in game time,
+// and the time from the press to the end of the step that fired it. Fails
+// if the queue lost any.
+static int TapBench(SimConfig cfg, uint32_t seed, uint64_t taps) {
+    struct Tap {
+        double down;
+        double up;
+    };
+    // No helicopters, so nothing ends the game.
+    cfg.helicopterCount = 0;
+    const double dt = 1.0 / cfg.tickRateHz;
+    Pcg32 rng;
+    SeedPcg32(rng, seed);
+    std::vector<Tap> list(static_cast<size_t>(std::max<uint64_t>(taps, 1)));
+    double t = 0.5;
+    size_t shortTaps = 0;
+    for (Tap& tap : list) {
+        const double length = UniformFloat(rng, 0.002f, 0.040f);
+        tap.down = t;
+        tap.up = t + length;
+        t = tap.up + cfg.fireCooldown + UniformFloat(rng, 0.05f, 0.3f);
+        shortTaps += length < dt ? 1 : 0;
+    }
+    World polled;
+    World queued;
+    InitWorld(polled, cfg, seed);
+    InitWorld(queued, cfg, seed);
+    InputQueue queue;
+    InputTracker tracker;
+
+    struct Shots {
+        uint64_t count = 0;
+        double offsetSum = 0.0;
+        double offsetWorst = 0.0;
+        double latencySum = 0.0;
+        double latencyWorst = 0.0;
+    } poll;
+    const uint64_t allocsAtStart = HeapAllocations();
+    size_t nextEvent = 0;
+    size_t tap = 0;
+    const uint64_t steps = static_cast<uint64_t>(t / dt) + 1;
+    for (uint64_t k = 0; k < steps; ++k) {
+        const double stepStart = static_cast<double>(k) * dt;
+        const double stepEnd = stepStart + dt;
+        // The keyboard side pushes whatever happened up to when the step
+        // runs.
+        for (; nextEvent < 2 * list.size(); ++nextEvent) {
+            const Tap& e = list[nextEvent / 2];
+            const double at = nextEvent % 2 ? e.up : e.down;
+            if (at >= stepEnd) {
+                break;
+            }
+            PushInputEvent(queue, InputFire, nextEvent % 2 == 0, at);
+        }
+        StepWorld(queued, static_cast<float>(dt), TakeStepInput(queue, tracker, stepStart, dt));
+        NoteStepFired(tracker, queued.tanks[0].fired, stepEnd);
+
+        while (tap + 1 < list.size() && list[tap + 1].down < stepEnd) {
+            ++tap;
+        }
+        SimInput in{};
+        in.fire = list[tap].down < stepEnd && stepEnd < list[tap].up;
+        StepWorld(polled, static_cast<float>(dt), in);
+        if (polled.tanks[0].fired) {
+            // Polled input has no press time; the shot leaves at the start.
+            const double offset = std::fabs(stepStart - list[tap].down);
+            const double latency = stepEnd - list[tap].down;
+            ++poll.count;
+            poll.offsetSum += offset;
+            poll.offsetWorst = std::max(poll.offsetWorst, offset);
+            poll.latencySum += latency;
+            poll.latencyWorst = std::max(poll.latencyWorst, latency);
+        }
+    }
+    const uint64_t allocs = HeapAllocations() - allocsAtStart;
+
+    const double n = static_cast<double>(list.size());
+    const double polledShots = static_cast<double>(std::max<uint64_t>(poll.count, 1));
+    const double queuedShots = static_cast<double>(std::max<uint64_t>(tracker.shots, 1));
+    const uint64_t queueLost = list.size() - tracker.shots;
+    std::printf("taps:        %zu of 2 to 40 ms, %.0f%% shorter than a %.2f ms step\n", list.size(),
+                100.0 * static_cast<double>(shortTaps) / n, dt * 1e3);
+    std::printf("polled:      %llu lost, shot %.3f ms from the press on average (worst %.3f), %.2f ms to its step's end (worst %.2f)\n",
+                static_cast<unsigned long long>(list.size() - poll.count), poll.offsetSum * 1e3 / polledShots,
+                poll.offsetWorst * 1e3, poll.latencySum * 1e3 / polledShots, poll.latencyWorst * 1e3);
+    std::printf("queued:      %llu lost, shot %.3f ms from the press on average (worst %.3f), %.2f ms to its step's end (worst %.2f)\n",
+                static_cast<unsigned long long>(queueLost), tracker.offsetSum * 1e3 / queuedShots,
+                tracker.offsetWorst * 1e3, tracker.latencySum * 1e3 / queuedShots, tracker.latencyWorst * 1e3);
+    std::printf("heap allocs: %llu\n", static_cast<unsigned long long>(allocs));
+    return queueLost == 0 && allocs == 0 ? 0 : 1;
+}
+
+// Runs a server and `clientCount` clients in this process over loopback for
+// `ticks` steps, each client playing the scripted input from a different
+// phase, and reports the server's cost per tick, the traffic per client and
+// how often the clients' turret prediction was wrong. Time is simulated
+// (one step per loop), so the run is as fast as the CPU allows. Fails if a
+// client did not join or ended up with a state that differs from what the
+// server sent for that tick.
+static int NetLoopback(SimConfig cfg, uint32_t seed, int clientCount, uint64_t ticks, float loss) {
+    if (!NetStartup()) {
+        std::fprintf(stderr, "network startup failed\n");
+        return 1;
+    }
+    cfg.tankCount = clientCount;
+    NetServer server;
+    if (!StartNetServer(server, cfg, seed, 0, true)) {
+        std::fprintf(stderr, "failed to open the server socket\n");
+        return 1;
+    }
+    server.socket.lossRate = loss;
+    const NetAddress address{ 0x7f000001, LocalPort(server.socket) };
+    std::vector<NetClient> clients(static_cast<size_t>(clientCount));
+    for (NetClient& c : clients) {
+        if (!StartNetClient(c, address)) {
+            std::fprintf(stderr, "failed to open a client socket\n");
+            return 1;
+        }
+        c.socket.lossRate = loss;
+    }
+
+    const double dt = 1.0 / cfg.tickRateHz;
+    const uint64_t warmup = ticks <= 1000 ? ticks / 2 : 1000;
+    uint64_t allocsAtWarmup = 0;
+    uint64_t rawBytes = 0;
+    uint64_t rawBlobs = 0;
+    double serverSeconds = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t tick = 0; tick < ticks; ++tick) {
+        if (tick == warmup) {
+            allocsAtWarmup = HeapAllocations();
+        }
+        const double now = static_cast<double>(tick) * dt;
+        for (size_t i = 0; i < clients.size(); ++i) {
+            ClientTick(clients[i], ScriptedInput(tick + i * 97), now);
+        }
+        auto s0 = std::chrono::steady_clock::now();
+        ServerTick(server, now);
+        serverSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - s0).count();
+        if (server.tick % static_cast<uint32_t>(server.snapshotInterval) == 0) {
+            rawBytes += server.history[server.tick % kNetHistory].size();
+            ++rawBlobs;
+        }
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const uint64_t allocs = HeapAllocations() - allocsAtWarmup;
+
+    // What each client last decoded must match what the server sent.
+    int joined = 0;
+    int mismatches = 0;
+    uint64_t down = 0;
+    uint64_t up = 0;
+    uint64_t snapshotBytes = 0;
+    uint64_t snapshots = 0;
+    uint64_t mispredictions = 0;
+    uint64_t predicted = 0;
+    float worst = 0.f;
+    for (size_t i = 0; i < clients.size(); ++i) {
+        const NetClient& c = clients[i];
+        joined += c.joined ? 1 : 0;
+        const uint32_t h = c.stateTick % kNetHistory;
+        if (!c.haveState || server.historyTick[h] != c.stateTick || server.history[h] != c.history[h]) {
+            ++mismatches;
+        }
+        down += c.traffic.bytesReceived;
+        up += c.traffic.bytesSent;
+        snapshotBytes += server.clients[i].snapshotBytes;
+        snapshots += server.clients[i].snapshots;
+        mispredictions += c.mispredictions;
+        predicted += c.seq;
+        worst = std::max(worst, c.worstMispredictionDeg);
+    }
+    const double gameSeconds = static_cast<double>(ticks) * dt;
+    const double perClient = gameSeconds * static_cast<double>(clientCount);
+    const double steps = static_cast<double>(std::max<uint64_t>(server.steps, 1));
+    std::printf("net:         %d clients over loopback, %.0f%% loss, snapshot every %d steps\n", clientCount,
+                loss * 100.f, server.snapshotInterval);
+    std::printf("joined:      %d/%d\n", joined, clientCount);
+    std::printf("ticks:       %llu (%.1f s of play) in %.3f s\n", static_cast<unsigned long long>(ticks), gameSeconds, seconds);
+    std::printf("server:      %.4f ms/tick (step %.4f, snapshots %.4f)\n", serverSeconds * 1e3 / steps,
+                server.stepSeconds * 1e3 / steps, server.snapshotSeconds * 1e3 / steps);
+    std::printf("traffic:     %.0f B/s down, %.0f B/s up per client\n", static_cast<double>(down) / perClient,
+                static_cast<double>(up) / perClient);
+    std::printf("snapshots:   %.1f B delta-coded vs %.1f B quantized\n",
+                static_cast<double>(snapshotBytes) / static_cast<double>(std::max<uint64_t>(snapshots, 1)),
+                static_cast<double>(rawBytes) / static_cast<double>(std::max<uint64_t>(rawBlobs, 1)));
+    std::printf("prediction:  %llu of %llu inputs corrected, worst %.2f deg\n",
+                static_cast<unsigned long long>(mispredictions), static_cast<unsigned long long>(predicted), worst);
+    std::printf("states:      %d of %d clients differ from the server\n", mismatches, clientCount);
+    std::printf("checksum:    %016llx\n", static_cast<unsigned long long>(WorldChecksum(server.world)));
+    std::printf("heap allocs: %llu after warmup\n", static_cast<unsigned long long>(allocs));
+
+    for (NetClient& c : clients) {
+        StopNetClient(c);
+    }
+    StopNetServer(server);
+    NetShutdown();
+    return joined == clientCount && mismatches == 0 && allocs == 0 ? 0 : 1;
+}
+
+// Dedicated server for up to `players` clients (the game's --connect),
+// stepping in real time for `ticks` steps and printing a status line every
+// five seconds.
+static int ServeNet(SimConfig cfg, uint32_t seed, uint16_t port, int players, uint64_t ticks) {
+    cfg.tankCount = players;
+    NetServer server;
+    if (!NetStartup() || !StartNetServer(server, cfg, seed, port, false)) {
+        std::fprintf(stderr, "failed to open UDP port %u\n", static_cast<unsigned>(port));
+        return 1;
+    }
+    std::printf("serving:     %d players on UDP port %u\n", players, static_cast<unsigned>(LocalPort(server.socket)));
+    std::fflush(stdout);
+    const auto step = std::chrono::duration<double>(1.0 / cfg.tickRateHz);
+    const auto start = std::chrono::steady_clock::now();
+    const uint64_t statusTicks = static_cast<uint64_t>(cfg.tickRateHz * 5.f);
+    uint64_t sentAtStatus = 0;
+    for (uint64_t tick = 0; tick < ticks; ++tick) {
+        const auto due = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(step * static_cast<double>(tick));
+        std::this_thread::sleep_until(due);
+        ServerTick(server, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        if ((tick + 1) % statusTicks == 0) {
+            uint64_t sent = 0;
+            for (const NetClientSlot& c : server.clients) {
+                sent += c.traffic.bytesSent;
+            }
+            const double steps = static_cast<double>(std::max<uint64_t>(server.steps, 1));
+            std::printf("tick %-8u %d connected, %.4f ms/tick, %.0f B/s out\n", server.tick, ConnectedClients(server),
+                        (server.stepSeconds + server.snapshotSeconds) * 1e3 / steps,
+                        static_cast<double>(sent - sentAtStatus) / 5.0);
+            std::fflush(stdout);
+            sentAtStatus = sent;
+        }
+    }
+    StopNetServer(server);
+    NetShutdown();
+    return 0;
+}
+
+static int Usage(const char* program) {
+    std::fprintf(stderr, "usage: %s [--ticks N] [--hz RATE] [--seed N] [--helis N] [--stress N] [--render] [--dirty] [--particles] [--dump PATH] [--aim]"
+                         " [--threaded] [--pace FPS] [--record PATH] [--keyframe N] [--replay PATH] [--seek TICK] [--trace PATH]"
+                         " [--particle-stress N] [--atlas PATH] [--net N] [--net-loss P] [--serve PORT] [--players N]"
+                         " [--rewind SECONDS] [--rewind-raw] [--ai-budget UNITS] [--taps N]\n", program);
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    uint64_t ticks = 5000000;
+    uint32_t seed = 1;
+    size_t stress = 0;
+    bool render = false;
+    bool dirty = false;
+    bool withParticles = false;
+    size_t particleStress = 0;
+    bool aimAssist = false;
+    bool threaded = false;
+    double paceHz = 0.0;
+    const char* dumpPath = nullptr;
+    const char* recordPath = nullptr;
+    const char* replayPath = nullptr;
+    uint64_t seekTick = 0;
+    uint32_t keyframeInterval = 1200;
+    const char* tracePath = nullptr;
+    const char* atlasPath = nullptr;
+    int netClients = 0;
+    float netLoss = 0.f;
+    int servePort = -1;
+    int players = 4;
+    double rewindSeconds = 0.0;
+    bool rewindRaw = false;
+    uint64_t taps = 0;
+    SimConfig cfg{};
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (std::strcmp(arg, "--ticks") == 0 && val) {
+            ticks = std::strtoull(val, nullptr, 10);
+            ++i;
+        } else if (std::strcmp(arg, "--hz") == 0 && val) {
+            cfg.tickRateHz = static_cast<float>(std::atof(val));
+            ++i;
+        } else if (std::strcmp(arg, "--seed") == 0 && val) {
+            seed = static_cast<uint32_t>(std::strtoul(val, nullptr, 10));
+            ++i;
+        } else if (std::strcmp(arg, "--helis") == 0 && val) {
+            cfg.helicopterCount = std::atoi(val);
+            ++i;
+        } else if (std::strcmp(arg, "--stress") == 0 && val) {
+            stress = static_cast<size_t>(std::strtoull(val, nullptr, 10));
+            ++i;
+        } else if (std::strcmp(arg, "--render") == 0) {
+            render = true;
+        } else if (std::strcmp(arg, "--dirty") == 0) {
+            render = true;
+            dirty = true;
+        } else if (std::strcmp(arg, "--particles") == 0) {
+            render = true;
+            withParticles = true;
+        } else if (std::strcmp(arg, "--particle-stress") == 0 && val) {
+            particleStress = static_cast<size_t>(std::strtoull(val, nullptr, 10));
+            ++i;
+        } else if (std::strcmp(arg, "--aim") == 0) {
+            aimAssist = true;
+        } else if (std::strcmp(arg, "--threaded") == 0) {
+            threaded = true;
+        } else if (std::strcmp(arg, "--pace") == 0 && val) {
+            paceHz = std::atof(val);
+            threaded = true;
+            render = true;
+            ++i;
+        } else if (std::strcmp(arg, "--dump") == 0 && val) {
+            dumpPath = val;
+            ++i;
+        } else if (std::strcmp(arg, "--record") == 0 && val) {
+            recordPath = val;
+            ++i;
+        } else if (std::strcmp(arg, "--keyframe") == 0 && val) {
+            keyframeInterval = static_cast<uint32_t>(std::strtoul(val, nullptr, 10));
+            ++i;
+        } else if (std::strcmp(arg, "--replay") == 0 && val) {
+            replayPath = val;
+            ++i;
+        } else if (std::strcmp(arg, "--trace") == 0 && val) {
+            tracePath = val;
+            ++i;
+        } else if (std::strcmp(arg, "--seek") == 0 && val) {
+            seekTick = std::strtoull(val, nullptr, 10);
+            ++i;
+        } else if (std::strcmp(arg, "--atlas") == 0 && val) {
+            atlasPath = val;
+            ++i;
+        } else if (std::strcmp(arg, "--rewind") == 0 && val) {
+            rewindSeconds = std::atof(val);
+            ++i;
+        } else if (std::strcmp(arg, "--rewind-raw") == 0) {
+            rewindRaw = true;
+        } else if (std::strcmp(arg, "--net") == 0 && val) {
+            netClients = std::atoi(val);
+            ++i;
+        } else if (std::strcmp(arg, "--net-loss") == 0 && val) {
+            netLoss = static_cast<float>(std::atof(val));
+            ++i;
+        } else if (std::strcmp(arg, "--serve") == 0 && val) {
+            servePort = std::atoi(val);
+            ++i;
+        } else if (std::strcmp(arg, "--players") == 0 && val) {
+            players = std::atoi(val);
+            ++i;
+        } else if (std::strcmp(arg, "--ai-budget") == 0 && val) {
+            cfg.aiBudget = std::atoi(val);
+            ++i;
+        } else if (std::strcmp(arg, "--taps") == 0 && val) {
+            taps = std::strtoull(val, nullptr, 10);
+            ++i;
+        } else {
+            return Usage(argv[0]);
+        }
+    }
+    // Every mode counts allocations from a warmup step, which a run needs
+    // at least one step to reach.
+    if (ticks == 0) {
+        std::fprintf(stderr, "--ticks must be at least 1\n");
+        return Usage(argv[0]);
+    }
+    if (stress > static_cast<size_t>(kMaxSimPoolSize) || !ValidSimConfig(cfg)) {
+        std::fprintf(stderr, "--hz, --helis, --stress or --ai-budget is out of range\n");
+        return Usage(argv[0]);
+    }
+
+    if (replayPath) {
+        return PlayReplay(replayPath, seekTick);
+    }
+    if (particleStress) {
+        return ParticleStress(particleStress, ticks);
+    }
+    if (taps) {
+        return TapBench(cfg, seed, taps);
+    }
+    if (rewindSeconds > 0.0) {
+        if (static_cast<size_t>(cfg.maxShells) < stress) {
+            cfg.maxShells = static_cast<int>(stress);
+        }
+        return RewindBench(cfg, seed, ticks, stress, rewindSeconds, !rewindRaw);
+    }
+    if (netClients > 0) {
+        if (netClients > 255) {
+            std::fprintf(stderr, "--net takes at most 255 clients\n");
+            return 2;
+        }
+        return NetLoopback(cfg, seed, netClients, ticks, netLoss);
+    }
+    if (servePort >= 0) {
+        if (servePort > 65535 || players < 1 || players > 255) {
+            std::fprintf(stderr, "--serve needs a port and 1 to 255 --players\n");
+            return 2;
+        }
+        return ServeNet(cfg, seed, static_cast<uint16_t>(servePort), players, ticks);
+    }
+    if (recordPath && stress) {
+        // Synthetic shells are not inputs, so the log could not reproduce them.
+        std::fprintf(stderr, "--record cannot be combined with --stress\n");
+        return 2;
+    }
+
+    if (static_cast<size_t>(cfg.maxShells) < stress) {
+        cfg.maxShells = static_cast<int>(stress);
+    }
+
+    Image tankBody;
+    Image tankBarrel;
+    if (atlasPath) {
+        auto a0 = std::chrono::steady_clock::now();
+        SpriteAtlas atlas;
+        if (!OpenSpriteAtlas(atlas, atlasPath)) {
+            std::fprintf(stderr, "failed to map %s\n", atlasPath);
+            return 1;
+        }
+        const uint32_t sprites = atlas.count;
+        const bool found = LoadAtlasImage(atlas, "Tank_Body", tankBody) && LoadAtlasImage(atlas, "Tank_Barrel", tankBarrel);
+        CloseSpriteAtlas(atlas);
+        if (!found) {
+            std::fprintf(stderr, "%s has no Tank_Body and Tank_Barrel sprites\n", atlasPath);
+            return 1;
+        }
+        const double atlasMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - a0).count();
+        std::printf("atlas:       %u sprites, loaded in %.3f ms\n", sprites, atlasMs);
+        FitTankToSprites(cfg, tankBody, tankBarrel);
+    }
+
+    HeadlessRun run;
+    run.cfg = cfg;
+    run.seed = seed;
+    run.stress = stress;
+    // Scratch buffers grow to their working size during the first ticks;
+    // allocations are only counted after that.
+    run.warmupTicks = ticks <= 1000 ? ticks / 2 : 1000;
+
+    SimThread sim;
+    World& world = sim.world;
+    InitWorld(world, cfg, seed);
+
+    ReplayRecorder recorder;
+    if (recordPath) {
+        if (!OpenReplayRecorder(recorder, recordPath, world, seed, keyframeInterval)) {
+            std::fprintf(stderr, "failed to write %s\n", recordPath);
+            return 1;
+        }
+        run.recorder = &recorder;
+    }
+
+    SoftRenderer renderer(static_cast<int>(cfg.screenWidth), static_cast<int>(cfg.screenHeight));
+    SceneAssets assets;
+    SpriteCache bodyFrames;
+    SpriteCache barrelFrames;
+    if (atlasPath) {
+        auto b0 = std::chrono::steady_clock::now();
+        BuildTankAssets(renderer, cfg, tankBody, tankBarrel, bodyFrames, barrelFrames, assets);
+        const double bakeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - b0).count();
+        std::printf("sprites:     baked in %.3f ms\n", bakeMs);
+    }
+    RenderState inlineState;
+    double renderSeconds = 0.0;
+    uint64_t frames = 0;
+    SceneLayers layers;
+    int64_t dirtyPixels = 0;
+    // Per-frame scratch for the dirty redraw, reset after every frame.
+    FrameArena frame;
+    InitFrameArena(frame, size_t(64) << 10);
+
+    // Effects for the hits in each consumed state, advanced by the
+    // simulation time since the previous one.
+    ParticleSystem particles;
+    InitParticleSystem(particles, 16384, 64);
+    uint64_t nextImpactTick = 0;
+    uint64_t particleTick = 0;
+    const ParticleSystem* drawnParticles = withParticles ? &particles : nullptr;
+
+    AimAssist aim;
+    InitAimAssist(aim, world, 0);
+    double aimSeconds = 0.0;
+    uint64_t aimTargets = 0;
+    uint64_t aimHits = 0;
+
+    // Aim solving and drawing for one state; inline after every step, or on
+    // this thread for whatever the simulation thread published last.
+    auto consume = [&](const RenderState& state) {
+        if (aimAssist) {
+            auto a0 = std::chrono::steady_clock::now();
+            UpdateAimAssist(aim, state.cfg, state.helicopters);
+            aimSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - a0).count();
+            aimTargets += aim.targets.size();
+            for (const AimSolution& sol : aim.solutions) {
+                aimHits += static_cast<uint64_t>(sol.count);
+            }
+        }
+        if (render) {
+            auto r0 = std::chrono::steady_clock::now();
+            if (withParticles) {
+                EmitNewImpacts(particles, state.impacts, nextImpactTick);
+                UpdateParticles(particles, static_cast<float>(state.tick - particleTick) / state.cfg.tickRateHz);
+                particleTick = state.tick;
+            }
+            if (dirty) {
+                DrawSceneDirty(renderer, layers, frame, state, 1.f, assets, aimAssist ? &aim : nullptr, drawnParticles, nullptr, 0);
+                ResetFrameArena(frame);
+                dirtyPixels += layers.dirtyPixels;
+            } else {
+                DrawScene(renderer, state, 1.f, assets, drawnParticles);
+                if (aimAssist) {
+                    DrawAimOverlay(renderer, state, 1.f, aim);
+                }
+            }
+            renderSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - r0).count();
+            ++frames;
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    double seconds = 0.0;
+    FramePacer pacer;
+    const std::clock_t cpuStart = std::clock();
+    if (threaded) {
+        sim.step = HeadlessStep;
+        sim.user = &run;
+        sim.paced = paceHz > 0.0;
+        sim.maxTicks = ticks;
+        if (paceHz > 0.0) {
+            InitFramePacer(pacer, paceHz);
+        }
+        if (aimAssist || render) {
+            // The first frame builds the background and sizes the scratch.
+            // This thread may draw only a few frames, so get it out of the
+            // way before the warmup count starts, and leave it out of the
+            // totals.
+            CaptureRenderState(world, inlineState);
+            consume(inlineState);
+            frames = 0;
+            renderSeconds = aimSeconds = 0.0;
+            aimTargets = aimHits = 0;
+            dirtyPixels = 0;
+        }
+        StartSimThread(sim);
+        while (!sim.finished.load(std::memory_order_acquire)) {
+            if (paceHz > 0.0) {
+                sim.states.Acquire();
+                consume(sim.states.Front());
+                PaceFrame(pacer);
+            } else if (sim.states.Acquire() && (aimAssist || render)) {
+                consume(sim.states.Front());
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        StopSimThread(sim);
+        sim.states.Acquire();
+        // The threads overlap, so the simulation gets the whole wall time.
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } else {
+        for (uint64_t t = 0; t < ticks; ++t) {
+            HeadlessStep(&run, world, t, 0.0);
+            if (aimAssist || render) {
+                CaptureRenderState(world, inlineState);
+                if (withParticles) {
+                    LogImpacts(sim.impactLog, world, t);
+                    CopyNewImpacts(inlineState.impacts, sim.impactLog);
+                    inlineState.tick = t + 1;
+                }
+                consume(inlineState);
+            }
+        }
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() - renderSeconds - aimSeconds;
+    }
+    const uint64_t steadyAllocs = HeapAllocations() - run.allocsAtWarmup;
+    const double cpuSeconds = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    CloseReplayRecorder(recorder);
+    double ticksPerSec = seconds > 0.0 ? static_cast<double>(ticks) / seconds : 0.0;
+
+    std::printf("kernel:      %s\n", BallisticKernelName());
+    std::printf("ticks:       %llu\n", static_cast<unsigned long long>(ticks));
+    std::printf("elapsed:     %.3f s\n", seconds);
+    std::printf("ticks/sec:   %.0f\n", ticksPerSec);
+    std::printf("ns/tick:     %.1f\n", seconds * 1e9 / static_cast<double>(ticks ? ticks : 1));
+    std::printf("games:       %llu\n", static_cast<unsigned long long>(run.games));
+    std::printf("score:       %llu\n", static_cast<unsigned long long>(run.totalScore + world.score));
+    std::printf("heap allocs: %llu after warmup\n", static_cast<unsigned long long>(steadyAllocs));
+    std::printf("checksum:    %016llx\n", static_cast<unsigned long long>(WorldChecksum(world)));
+    const double aiSteps = static_cast<double>(run.aiSteps ? run.aiSteps : 1);
+    std::printf("ai:          %.2f us/step, worst %.2f us, %u of %d units at most\n", static_cast<double>(run.aiNs) * 1e-3 / aiSteps,
+                static_cast<double>(run.aiMaxNs) * 1e-3, run.aiMaxUnits, cfg.aiBudget);
+    const double aiDecisions = static_cast<double>(run.aiDecisions ? run.aiDecisions : 1);
+    std::printf("             %.2f decisions/step (%.1f%% dodging, %.1f%% cut short), %u steps at most between decisions\n",
+                static_cast<double>(run.aiDecisions) / aiSteps, 100.0 * static_cast<double>(run.aiUrgent) / aiDecisions,
+                100.0 * static_cast<double>(run.aiCutShort) / aiDecisions, run.aiMaxWait);
+    if (aimAssist) {
+        std::printf("aim:         %.0f ns/target, %.2f solutions/target\n",
+                    aimSeconds * 1e9 / static_cast<double>(aimTargets ? aimTargets : 1),
+                    static_cast<double>(aimHits) / static_cast<double>(aimTargets ? aimTargets : 1));
+    }
+
+    if (render || dumpPath) {
+        // The last frame drawn may be from an older state when threaded.
+        CaptureRenderState(world, inlineState);
+        const size_t pixelCount = static_cast<size_t>(renderer.Width()) * static_cast<size_t>(renderer.Height());
+        if (dirty) {
+            // Whatever the dirty rectangles missed over the whole run is
+            // still on screen; a full redraw of the same state must match.
+            if (aimAssist) {
+                UpdateAimAssist(aim, inlineState.cfg, inlineState.helicopters);
+            }
+            DrawSceneDirty(renderer, layers, frame, inlineState, 1.f, assets, aimAssist ? &aim : nullptr, drawnParticles, nullptr, 0);
+            ResetFrameArena(frame);
+            SoftRenderer full(renderer.Width(), renderer.Height());
+            DrawScene(full, inlineState, 1.f, assets, drawnParticles);
+            if (aimAssist) {
+                DrawAimOverlay(full, inlineState, 1.f, aim);
+            }
+            const bool same = FrameChecksum(full.Pixels(), pixelCount) == FrameChecksum(renderer.Pixels(), pixelCount);
+            std::printf("dirty:       %.1f%% of the screen redrawn per frame, %s\n",
+                        100.0 * static_cast<double>(dirtyPixels) / (static_cast<double>(pixelCount) * static_cast<double>(frames ? frames : 1)),
+                        same ? "matches a full redraw" : "DIFFERS FROM A FULL REDRAW");
+            std::printf("arena:       %.1f KB at most per frame, %llu spills\n", static_cast<double>(frame.highWater) / 1024.0,
+                        static_cast<unsigned long long>(frame.spills));
+            if (!same) {
+                return 1;
+            }
+        } else {
+            DrawScene(renderer, inlineState, 1.f, assets, drawnParticles);
+        }
+        if (render) {
+            std::printf("render:      %.3f ms/frame, %llu frames\n", renderSeconds * 1e3 / static_cast<double>(frames ? frames : 1),
+                        static_cast<unsigned long long>(frames));
+        }
+        if (withParticles) {
+            std::printf("particles:   %zu live at the end\n", LiveParticles(particles));
+        }
+        std::printf("frame:       %016llx\n", static_cast<unsigned long long>(FrameChecksum(renderer.Pixels(), pixelCount)));
+    }
+    if (paceHz > 0.0) {
+        const FramePacerStats pace = GetFramePacerStats(pacer);
+        std::printf("pacing:      target %.2f ms, period %.2f ms, mean %.3f ms, jitter %.3f ms, worst %.3f ms\n",
+                    pace.targetMs, pace.periodMs, pace.meanMs, pace.jitterMs, pace.worstErrorMs);
+        std::printf("             work %.3f ms/frame, spin %.3f ms/frame, cpu %.1f%% of one core\n",
+                    pace.workMs, pace.spinMs, seconds > 0.0 ? 100.0 * cpuSeconds / seconds : 0.0);
+        DestroyFramePacer(pacer);
+    }
+#if CGAME_PROFILE
+    const ProfileZone zones[] = { ZoneStep, ZoneShells, ZoneBombs, ZoneAi, ZoneHelicopters, ZoneCollision, ZoneCompaction };
+    for (ProfileZone zone : zones) {
+        const ProfileStats stats = ProfileZoneStats(zone, 1024);
+        std::printf("%-12s p50 %.4f ms, p99 %.4f ms\n", ProfileZoneName(zone), stats.p50Ms, stats.p99Ms);
+    }
+    if (tracePath) {
+        if (!ExportChromeTrace(tracePath)) {
+            std::fprintf(stderr, "failed to write %s\n", tracePath);
+            return 1;
+        }
+        std::printf("trace:       %s\n", tracePath);
+    }
+#else
+    if (tracePath) {
+        std::fprintf(stderr, "--trace needs a build with -DCGAME_PROFILE=1\n");
+    }
+#endif
+    if (dumpPath) {
+        const size_t len = std::strlen(dumpPath);
+        const bool png = len >= 4 && std::strcmp(dumpPath + len - 4, ".png") == 0;
+        bool ok = png ? SaveFramePNG(dumpPath, renderer.Pixels(), renderer.Width(), renderer.Height())
+                      : SaveFramePPM(dumpPath, renderer.Pixels(), renderer.Width(), renderer.Height());
+        if (!ok) {
+            std::fprintf(stderr, "failed to write %s\n", dumpPath);
+            return 1;
+        }
+        std::printf("dumped:      %s\n", dumpPath);
+    }
+    // Steady-state steps and frames must not touch the heap.
+    return steadyAllocs == 0 ? 0 : 1;
+}
@@ -0,0 +1,71 @@
+#include "hud.h"
+
+#include <cmath>
+#include <cstdio>
+
+static const size_t kLabelTextReserve = 128;
+
+bool UpdateCachedLabel(Renderer& r, CachedLabel& cached, const SceneLabel& label) {
+    const int width = static_cast<int>(std::ceil(label.w));
+    const int height = static_cast<int>(std::ceil(label.h));
+    const bool resized = cached.texture == kNoTexture || width != cached.width || height != cached.height;
+    if (resized) {
+        Image blank;
+        blank.width = width;
+        blank.height = height;
+        blank.pixels.assign(static_cast<size_t>(width) * static_cast<size_t>(height), 0u);
+        cached.texture = r.CreateTexture(blank);
+        // Room for the text to get longer, e.g. the score gaining a digit.
+        cached.text.reserve(kLabelTextReserve);
+        cached.width = width;
+        cached.height = height;
+    }
+    const SceneLabel& old = cached.layout;
+    const bool restyled = label.sizePx != old.sizePx || label.color != old.color;
+    const bool moved = label.x != old.x || label.y != old.y || label.w != old.w || label.h != old.h;
+    if (!resized && !restyled && !moved && cached.text == label.text) {
+        return false;
+    }
+    if (resized || restyled || cached.text != label.text) {
+        cached.text = label.text;
+        r.RenderLabelTexture(cached.texture, cached.text.c_str(), label.sizePx, label.color);
+    }
+    cached.layout = label;
+    cached.layout.text = cached.text.c_str();
+    return true;
+}
+
+void DrawCachedLabel(Renderer& r, const CachedLabel& cached) {
+    r.BlitTexture(cached.texture, static_cast<int>(std::floor(cached.layout.x)), static_cast<int>(std::floor(cached.layout.y)));
+}
+
+void FormatHud(const RenderState& state, char* text, size_t size) {
+    std::snprintf(text, size, "Lives: %d   Score: %d   Angle: %d deg%s",
+                  state.lives, state.score, static_cast<int>(state.tanks[state.localTank].turretAngleDeg),
+                  state.gameOver ? "   GAME OVER" : "");
+}
+
+SceneLabel HudLayout(const SimConfig& cfg, const char* text) {
+    SceneLabel label;
+    label.text = text;
+    label.y = 10.f;
+    label.w = cfg.screenWidth;
+    label.h = 30.f;
+    label.sizePx = 18.f;
+    label.color = Argb(255, 255, 255, 255);
+    return label;
+}
+
+bool UpdateHud(Renderer& r, Hud& hud, const RenderState& state) {
+    const int angleDeg = static_cast<int>(state.tanks[state.localTank].turretAngleDeg);
+    if (hud.label.texture != kNoTexture && state.lives == hud.lives && state.score == hud.score &&
+        angleDeg == hud.angleDeg && state.gameOver == hud.gameOver) {
+        return false;
+    }
+    hud.lives = state.lives;
+    hud.score = state.score;
+    hud.angleDeg = angleDeg;
+    hud.gameOver = state.gameOver;
+    FormatHud(state, hud.text, sizeof(hud.text));
+    return UpdateCachedLabel(r, hud.label, HudLayout(state.cfg, hud.text));
+}
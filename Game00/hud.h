@@ -0,0 +1,56 @@
+#pragma once
+
+// Text overlays that are laid out once and then blitted. Text layout is one
+// of the most expensive calls a frame makes, while the lives, score and
+// angle change a few times a second at most, so each label lives in its own
+// texture that is redrawn only when its text changes.
+
+#include "render.h"
+#include "render_state.h"
+
+#include <string>
+
+// Single line of text, as Renderer::DrawLabel.
+struct SceneLabel {
+    const char* text = "";
+    float x = 0.f;
+    float y = 0.f;
+    float w = 0.f;
+    float h = 0.f;
+    float sizePx = 0.f;
+    uint32_t color = 0;
+};
+
+// A label rendered into a texture of its own size. It is blitted at whole
+// pixels, floor(x) and floor(y). layout.text points into `text`.
+struct CachedLabel {
+    SceneLabel layout;
+    std::string text;
+    TextureId texture = kNoTexture;
+    int width = 0;
+    int height = 0;
+};
+
+// Brings the cache up to date with `label` and returns true if it changed,
+// i.e. the old and new layout rectangles need redrawing. A new size creates
+// a new texture; the renderer keeps the old one, so sizes should be fixed.
+bool UpdateCachedLabel(Renderer& r, CachedLabel& cached, const SceneLabel& label);
+void DrawCachedLabel(Renderer& r, const CachedLabel& cached);
+
+// The lives / score / angle line along the top of the screen.
+void FormatHud(const RenderState& state, char* text, size_t size);
+SceneLabel HudLayout(const SimConfig& cfg, const char* text);
+
+// The HUD line, re-formatted and re-rendered only when one of its values
+// changes.
+struct Hud {
+    int lives = -1;
+    int score = -1;
+    int angleDeg = -1;
+    bool gameOver = false;
+    char text[128] = "";
+    CachedLabel label;
+};
+
+// Returns true when the HUD changed this frame.
+bool UpdateHud(Renderer& r, Hud& hud, const RenderState& state);
@@ -0,0 +1,214 @@
+#include "input.h"
+#include "sim_thread.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef _WIN32
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#endif
+
+bool PushInputEvent(InputQueue& queue, InputKey key, bool down, double seconds) {
+    const uint32_t tail = queue.tail.load(std::memory_order_relaxed);
+    if (tail - queue.head.load(std::memory_order_acquire) >= InputQueue::kCapacity) {
+        queue.dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    InputEvent& e = queue.events[tail % InputQueue::kCapacity];
+    e.seconds = seconds;
+    e.key = key;
+    e.down = down;
+    queue.tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+SimInput TakeStepInput(InputQueue& queue, InputTracker& tracker, double stepStart, double stepSeconds) {
+    const double stepEnd = stepStart + stepSeconds;
+    bool held[InputKeyCount];
+    std::copy(tracker.down, tracker.down + InputKeyCount, held);
+
+    uint32_t head = queue.head.load(std::memory_order_relaxed);
+    const uint32_t tail = queue.tail.load(std::memory_order_acquire);
+    for (; head != tail; ++head) {
+        const InputEvent& e = queue.events[head % InputQueue::kCapacity];
+        if (e.seconds >= stepEnd) {
+            break;
+        }
+        if (e.key >= InputKeyCount) {
+            continue;
+        }
+        // Key repeat sends more downs; only the first is a press.
+        if (e.down && !tracker.down[e.key]) {
+            held[e.key] = true;
+            if (e.key == InputFire && !tracker.pressPending) {
+                tracker.pressPending = true;
+                tracker.pressSeconds = e.seconds;
+            }
+        }
+        tracker.down[e.key] = e.down;
+    }
+    queue.head.store(head, std::memory_order_release);
+
+    SimInput input{};
+    input.left = held[InputLeft];
+    input.right = held[InputRight];
+    tracker.pressSent = false;
+    if (tracker.pressPending && !tracker.fireSent) {
+        const double phase = std::floor((tracker.pressSeconds - stepStart) / stepSeconds * kFirePhases);
+        input.fire = true;
+        input.firePhase = static_cast<uint8_t>(std::min(std::max(phase, 0.0), static_cast<double>(kFirePhases - 1)));
+        tracker.pressPending = false;
+        tracker.pressSent = true;
+        tracker.sentPressSeconds = tracker.pressSeconds;
+        tracker.sentShotSeconds = stepStart + stepSeconds * input.firePhase / kFirePhases;
+    } else {
+        // Still held from a press an earlier step took. A new press behind a
+        // release this step did not get to see goes to the next one.
+        input.fire = tracker.fireSent && tracker.down[InputFire] && !tracker.pressPending;
+    }
+    tracker.fireSent = input.fire;
+    return input;
+}
+
+void NoteStepFired(InputTracker& tracker, bool fired, double nowSeconds) {
+    if (!fired || !tracker.pressSent) {
+        return;
+    }
+    const double latency = nowSeconds - tracker.sentPressSeconds;
+    const double offset = std::fabs(tracker.sentShotSeconds - tracker.sentPressSeconds);
+    ++tracker.shots;
+    tracker.latencySum += latency;
+    tracker.latencyWorst = std::max(tracker.latencyWorst, latency);
+    tracker.offsetSum += offset;
+    tracker.offsetWorst = std::max(tracker.offsetWorst, offset);
+}
+
+int InputKeyForVirtualKey(unsigned virtualKey) {
+    switch (virtualKey) {
+    case 0x25: // VK_LEFT
+        return InputLeft;
+    case 0x27: // VK_RIGHT
+        return InputRight;
+    case 0x20: // VK_SPACE
+        return InputFire;
+    default:
+        return -1;
+    }
+}
+
+#ifdef _WIN32
+static const wchar_t* kCaptureClass = L"CGameInputCapture";
+
+struct CaptureStart {
+    InputCapture* capture;
+    HANDLE ready;
+    bool ok;
+};
+
+static LRESULT CALLBACK CaptureWndProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam) {
+    if (msg == WM_INPUT) {
+        // Stamped first thing; the thread does nothing else.
+        const double now = SteadySeconds();
+        RAWINPUT raw{};
+        UINT size = sizeof(raw);
+        InputQueue* queue = reinterpret_cast<InputQueue*>(GetWindowLongPtrW(hwnd, GWLP_USERDATA));
+        if (queue && GetRawInputData(reinterpret_cast<HRAWINPUT>(lparam), RID_INPUT, &raw, &size, sizeof(RAWINPUTHEADER)) != static_cast<UINT>(-1) &&
+            raw.header.dwType == RIM_TYPEKEYBOARD) {
+            const int key = InputKeyForVirtualKey(raw.data.keyboard.VKey);
+            if (key >= 0) {
+                PushInputEvent(*queue, static_cast<InputKey>(key), (raw.data.keyboard.Flags & RI_KEY_BREAK) == 0, now);
+            }
+        }
+    } else if (msg == WM_CLOSE) {
+        DestroyWindow(hwnd);
+        return 0;
+    } else if (msg == WM_DESTROY) {
+        PostQuitMessage(0);
+        return 0;
+    }
+    return DefWindowProcW(hwnd, msg, wparam, lparam);
+}
+
+static DWORD WINAPI CaptureThreadMain(void* param) {
+    CaptureStart& start = *static_cast<CaptureStart*>(param);
+    InputCapture& capture = *start.capture;
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+
+    WNDCLASSEXW wc{ sizeof(WNDCLASSEXW) };
+    wc.lpfnWndProc = CaptureWndProc;
+    wc.hInstance = GetModuleHandleW(nullptr);
+    wc.lpszClassName = kCaptureClass;
+    RegisterClassExW(&wc);
+    HWND hwnd = CreateWindowExW(0, kCaptureClass, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, nullptr, wc.hInstance, nullptr);
+    if (hwnd) {
+        SetWindowLongPtrW(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(capture.queue));
+        // Keyboard input whichever window has the focus, as
+        // GetAsyncKeyState reads it; legacy key messages still go to the
+        // game window.
+        RAWINPUTDEVICE device{};
+        device.usUsagePage = 0x01;
+        device.usUsage = 0x06;
+        device.dwFlags = RIDEV_INPUTSINK;
+        device.hwndTarget = hwnd;
+        if (!RegisterRawInputDevices(&device, 1, sizeof(device))) {
+            DestroyWindow(hwnd);
+            hwnd = nullptr;
+        }
+    }
+    capture.window = hwnd;
+    start.ok = hwnd != nullptr;
+    SetEvent(start.ready);
+    if (!hwnd) {
+        return 0;
+    }
+
+    MSG msg{};
+    while (GetMessageW(&msg, nullptr, 0, 0) > 0) {
+        DispatchMessageW(&msg);
+    }
+    return 0;
+}
+#endif
+
+bool StartInputCapture(InputCapture& capture, InputQueue& queue) {
+    capture.queue = &queue;
+#ifdef _WIN32
+    CaptureStart start{ &capture, CreateEventW(nullptr, TRUE, FALSE, nullptr), false };
+    if (!start.ready) {
+        return false;
+    }
+    HANDLE thread = CreateThread(nullptr, 0, CaptureThreadMain, &start, 0, nullptr);
+    if (thread) {
+        WaitForSingleObject(start.ready, INFINITE);
+    }
+    CloseHandle(start.ready);
+    if (!thread) {
+        return false;
+    }
+    if (!start.ok) {
+        WaitForSingleObject(thread, INFINITE);
+        CloseHandle(thread);
+        return false;
+    }
+    capture.thread = thread;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void StopInputCapture(InputCapture& capture) {
+#ifdef _WIN32
+    if (capture.thread) {
+        PostMessageW(static_cast<HWND>(capture.window), WM_CLOSE, 0, 0);
+        WaitForSingleObject(static_cast<HANDLE>(capture.thread), INFINITE);
+        CloseHandle(static_cast<HANDLE>(capture.thread));
+    }
+#endif
+    capture.thread = nullptr;
+    capture.window = nullptr;
+}
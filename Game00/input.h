@@ -0,0 +1,100 @@
+#pragma once
+
+// Event-driven keyboard input. The window side pushes every press and
+// release of the game keys, stamped with the steady clock (SteadySeconds)
+// as it arrives, into a lock-free queue; the simulation side drains it once
+// per step and turns the events that fall inside the step into a SimInput.
+// Polling key state once per step loses a tap shorter than a step and
+// cannot tell where in the step a press landed; with the events, a tap
+// always counts and a shot carries its press time as SimInput::firePhase.
+//
+// On Windows the events come from raw input on a thread of their own, which
+// blocks on its message queue and so stamps a key within microseconds of
+// the press, however long the frame loop sleeps. Where raw input is not
+// available, the window procedure pushes WM_KEYDOWN/WM_KEYUP instead; those
+// are stamped when the frame loop pumps messages, so they are only as
+// precise as the frame rate.
+
+#include "sim.h"
+
+#include <atomic>
+#include <cstdint>
+
+// The keys that drive SimInput.
+enum InputKey : uint8_t {
+    InputLeft,
+    InputRight,
+    InputFire,
+    InputKeyCount,
+};
+
+struct InputEvent {
+    double seconds = 0.0;
+    uint8_t key = 0;
+    bool down = false;
+};
+
+// Single producer, single consumer.
+struct InputQueue {
+    static const uint32_t kCapacity = 256;
+    InputEvent events[kCapacity];
+    std::atomic<uint32_t> head{ 0 };
+    std::atomic<uint32_t> tail{ 0 };
+    // Events pushed while the queue was full.
+    std::atomic<uint32_t> dropped{ 0 };
+};
+
+// Producer side. False, and counted as dropped, when the queue is full.
+bool PushInputEvent(InputQueue& queue, InputKey key, bool down, double seconds);
+
+// Consumer side: key state between steps, and what became of the presses.
+struct InputTracker {
+    bool down[InputKeyCount] = {};
+    // Fire as the last step saw it. A press that comes while the last step
+    // still saw fire down waits a step, so the simulation sees the release.
+    bool fireSent = false;
+    bool pressPending = false;
+    double pressSeconds = 0.0;
+
+    // The press handed to the last step, if any, and where in that step's
+    // slice of real time its shot was placed.
+    bool pressSent = false;
+    double sentPressSeconds = 0.0;
+    double sentShotSeconds = 0.0;
+
+    // Shots fired from queued presses: the real time from the press to the
+    // end of the step that fired it, and how far the shot's place in the
+    // step was from the press.
+    uint64_t shots = 0;
+    double latencySum = 0.0;
+    double latencyWorst = 0.0;
+    double offsetSum = 0.0;
+    double offsetWorst = 0.0;
+};
+
+// Drains the events stamped before the end of the step covering real time
+// [stepStart, stepStart + stepSeconds) and returns the step's input. A key
+// that was down at any point in the step counts as held for all of it, and
+// fire carries the phase of its press. Events stamped before stepStart
+// (they arrived after their step ran) count from the start of this one.
+SimInput TakeStepInput(InputQueue& queue, InputTracker& tracker, double stepStart, double stepSeconds);
+// Call after the step ran with whether it fired and the time it finished,
+// to record the shot's latency.
+void NoteStepFired(InputTracker& tracker, bool fired, double nowSeconds);
+
+// InputKey for a Windows virtual-key code, or -1 for keys the game does not
+// queue.
+int InputKeyForVirtualKey(unsigned virtualKey);
+
+// Raw keyboard input on a thread of its own, feeding a queue.
+struct InputCapture {
+    InputQueue* queue = nullptr;
+    // Message-only window and thread handles on Windows.
+    void* window = nullptr;
+    void* thread = nullptr;
+};
+
+// False where raw input is not available (and off Windows); the window
+// procedure should push key messages instead.
+bool StartInputCapture(InputCapture& capture, InputQueue& queue);
+void StopInputCapture(InputCapture& capture);
@@ -30,8 +30,15 @@
 #include <gdiplustypes.h>
 #pragma comment(lib, "gdiplus.lib")
 
+#include "grid.h"
+#include "frame_pacer.h"
+#include "present_surface.h"
+#include "render_gdiplus.h"
+#include "sprite_cache.h"
+
 LRESULT CALLBACK WndProc(HWND h, UINT m, WPARAM w, LPARAM l) {
     if (m == WM_DESTROY) { PostQuitMessage(0); return 0; }
+    HandlePresentSurfaceMessage(h, m, w, l);
     return DefWindowProc(h, m, w, l);
 }
 
@@ -43,6 +50,7 @@ int APIENTRY wWinMain(
 {
     const wchar_t* cls = L"CGameWnd";
     WNDCLASSEX wc{ sizeof(WNDCLASSEX) };
+    wc.style = CS_OWNDC; // PresentSurface caches the window DC
     wc.lpfnWndProc = WndProc;
     wc.hInstance = hInstance;
     wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
@@ -71,6 +79,13 @@ int APIENTRY wWinMain(
         return 0;
     }
 
+    PresentSurface surface;
+    if (!CreatePresentSurface(surface, wnd, RGB(30, 30, 40))) {
+        MessageBox(wnd, L"Failed to create the back buffer.", L"Error", MB_ICONERROR);
+        Gdiplus::GdiplusShutdown(gdiplusToken);
+        return 0;
+    }
+
     // Resolve sprite locations relative to the executable directory
     wchar_t exePath[MAX_PATH]{};
     DWORD exeLen = GetModuleFileNameW(nullptr, exePath, MAX_PATH);
@@ -90,13 +105,13 @@ int APIENTRY wWinMain(
         std::wstring tankBarrelPath = exeDir + L"Tank_Barrel.png";
         std::wstring tankBulletPath = exeDir + L"Tank_Bullet.png";
 
-        Gdiplus::Image tankBody(tankBodyPath.c_str());
-        Gdiplus::Image tankBarrel(tankBarrelPath.c_str());
-        Gdiplus::Image tankBullet(tankBulletPath.c_str());
+        Image tankBody;
+        Image tankBarrel;
+        Image tankBullet;
 
-        const bool bodyOk = tankBody.GetLastStatus() == Gdiplus::Ok;
-        const bool barrelOk = tankBarrel.GetLastStatus() == Gdiplus::Ok;
-        const bool bulletOk = tankBullet.GetLastStatus() == Gdiplus::Ok;
+        const bool bodyOk = LoadImageFile(tankBodyPath.c_str(), tankBody);
+        const bool barrelOk = LoadImageFile(tankBarrelPath.c_str(), tankBarrel);
+        const bool bulletOk = LoadImageFile(tankBulletPath.c_str(), tankBullet);
 
         if (!bodyOk || !barrelOk) {
             MessageBox(wnd, L"Tank sprites not found next to the executable.", L"Image Load Error", MB_ICONERROR);
@@ -115,6 +130,24 @@ int APIENTRY wWinMain(
             const int bulletDrawW = 16, bulletDrawH = 16; // draw size
             bool prevSpaceDown = false;
 
+            // Sprites are baked once: the body at its draw size, the barrel
+            // per degree of phi and the bullet every 2 degrees of heading.
+            GdiplusRenderer renderer(surface);
+            const float barrelW = 240.0f;
+            const float barrelH = 160.0f;
+            SpriteCache bodyFrames;
+            SpriteCache barrelFrames;
+            SpriteCache bulletFrames;
+            BuildSpriteCache(bodyFrames, tankBody, -wImg * 0.5f, -static_cast<float>(hImg), static_cast<float>(wImg), static_cast<float>(hImg), 0.f, 0.f, 1.f);
+            BuildSpriteCache(barrelFrames, tankBarrel, -barrelW * 0.5f, -barrelH, barrelW, barrelH, -90.f, 90.f, 1.f);
+            UploadSpriteCache(renderer, bodyFrames);
+            UploadSpriteCache(renderer, barrelFrames);
+            if (bulletOk) {
+                BuildSpriteCache(bulletFrames, tankBullet, -bulletDrawW * 0.5f, -bulletDrawH * 0.5f,
+                                 static_cast<float>(bulletDrawW), static_cast<float>(bulletDrawH), 0.f, 360.f, 2.f);
+                UploadSpriteCache(renderer, bulletFrames);
+            }
+
             std::random_device rd;
             std::mt19937 rng(rd());
             std::uniform_int_distribution<int> heliTopDist(100, 200);
@@ -127,6 +160,8 @@ int APIENTRY wWinMain(
 
             MSG msg{};
             bool running = true;
+            FramePacer pacer;
+            InitFramePacer(pacer, 120.0);
             while (running) {
                 while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
                     if (msg.message == WM_QUIT) running = false;
@@ -147,7 +182,7 @@ int APIENTRY wWinMain(
 
                 x += vx * dt; y += vy * dt;
 
-                RECT rc; GetClientRect(wnd, &rc);
+                RECT rc{ 0, 0, surface.width, surface.height };
                 if (x < 0) x = 0; if (y < 0) y = 0;
                 if (x > rc.right - wImg)  x = float(rc.right - wImg);
                 if (y > rc.bottom - hImg) y = float(rc.bottom - hImg);
@@ -175,6 +210,8 @@ int APIENTRY wWinMain(
                 prevSpaceDown = spaceDown;
 
                 // Update bullet physics
+                const float prevBulletX = bulletX;
+                const float prevBulletY = bulletY;
                 if (isBulletActive) {
                     bulletVy += gravity * dt;
                     bulletX += bulletVx * dt;
@@ -191,9 +228,12 @@ int APIENTRY wWinMain(
                     if (leftXHeli > rc.right || rightXHeli < rc.left) {
                         isHeliActive = false;
                     }
-                    if (isBulletActive && 
-                        leftXHeli <= bulletX && bulletX <= rightXHeli && 
-                        topYHeli <= bulletY && bulletY <= bottomYHeli) 
+                    // Swept test in the helicopter's frame: shift the bullet's
+                    // previous position by the helicopter's motion this frame.
+                    const AABB heliBox{ leftXHeli, topYHeli, rightXHeli, bottomYHeli };
+                    float toi = 0.f;
+                    if (isBulletActive &&
+                        SweepSegmentAABB(prevBulletX + VXHeli * dt, prevBulletY, bulletX, bulletY, heliBox, toi))
                     {
                         isHeliActive = false;
                         isBulletActive = false;
@@ -216,88 +256,43 @@ int APIENTRY wWinMain(
                     bottomYHeli = topYHeli + 20;
                 }
 
-                HDC hdc = GetDC(wnd);
-                HDC mdc = CreateCompatibleDC(hdc);
-                HBITMAP bmp = CreateCompatibleBitmap(hdc, rc.right, rc.bottom);
-                HGDIOBJ oldBmp = SelectObject(mdc, bmp);
-
-                HBRUSH bg = CreateSolidBrush(RGB(30, 30, 40));
-                FillRect(mdc, &rc, bg);
-                DeleteObject(bg);
-
-                {
-                    // Draw barrel + white dot (muzzle)
-                    Gdiplus::Graphics g(mdc);
-                    g.SetInterpolationMode(Gdiplus::InterpolationModeNearestNeighbor);
-                    g.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-
-                    const float barrelW = 240.0f;
-                    const float barrelH = 160.0f;
-
-                    g.TranslateTransform(pivotX, pivotY);
-                    g.RotateTransform(-phi * 180.0f / 3.14159265f + 90);
-                    g.DrawImage(&tankBarrel, Gdiplus::RectF(-barrelW * 0.5f, -barrelH, barrelW, barrelH));
-                    g.ResetTransform();
-                }
+                renderer.BeginFrame();
+                renderer.Clear(Argb(255, 30, 30, 40));
 
-                {
-                    // Draw tank body
-                    Gdiplus::Graphics g(mdc);
-                    g.SetInterpolationMode(Gdiplus::InterpolationModeHighQualityBicubic);
-                    g.DrawImage(&tankBody, (int)((rc.left + rc.right - wImg) / 2), (int)(rc.bottom - hImg), wImg, hImg);
-                }
+                // Barrel, then tank body
+                DrawCachedSprite(renderer, barrelFrames, -phi * 180.0f / 3.14159265f + 90, pivotX, pivotY);
+                DrawCachedSprite(renderer, bodyFrames, 0.f, (rc.left + rc.right) / 2.0f, static_cast<float>(rc.bottom));
 
                 // Draw bullet (on top)
                 if (isBulletActive) {
-                    Gdiplus::Graphics g(mdc);
                     if (bulletOk) {
-                        g.SetInterpolationMode(Gdiplus::InterpolationModeHighQualityBicubic);
-
-                        // Angle: atan2(y, x). y is negated because screen Y increases downward.
-                        float phiBullet = atan2f(bulletVy, bulletVx); 
+                        // Angle: atan2(y, x). +90 because the sprite's "up" is along +Y.
+                        float phiBullet = atan2f(bulletVy, bulletVx);
                         float angleDeg = phiBullet * 180.0f / 3.1415926f;
-
-                        // Move origin to bullet position, rotate around that origin,
-                        // then draw the image centered at (0,0).
-                        g.TranslateTransform(bulletX, bulletY);
-                        g.RotateTransform(angleDeg + 90.0f); // +90 if your sprite's "up" is along +Y
-
-                        g.DrawImage(&tankBullet, Gdiplus::RectF(
-                            -bulletDrawW * 0.5f,
-                            -bulletDrawH * 0.5f,
-                            static_cast<Gdiplus::REAL>(bulletDrawW),
-                            static_cast<Gdiplus::REAL>(bulletDrawH)
-                        ));
-
-                        // Restore to identity so subsequent drawing isn't affected
-                        g.ResetTransform();
+                        DrawCachedSprite(renderer, bulletFrames, angleDeg + 90.0f, bulletX, bulletY);
                     } else {
                         // fallback small white circle if bullet image missing
-                        HBRUSH bbr = CreateSolidBrush(RGB(255, 255, 255));
-                        HGDIOBJ old = SelectObject(mdc, bbr);
-                        Ellipse(mdc, int(bulletX - 4), int(bulletY - 4), int(bulletX + 4), int(bulletY + 4));
-                        SelectObject(mdc, old);
-                        DeleteObject(bbr);
+                        renderer.FillCircle(bulletX, bulletY, 4.f, Argb(255, 255, 255, 255));
                     }
                 }
 
-                {
-
-                    if (isHeliActive) {
-                        Rectangle(mdc, leftXHeli, topYHeli, rightXHeli, bottomYHeli);
-                    }
+                if (isHeliActive) {
+                    // White box with a 1px black outline, like GDI Rectangle()
+                    const int l = static_cast<int>(leftXHeli), t = static_cast<int>(topYHeli);
+                    const int r = static_cast<int>(rightXHeli), b = static_cast<int>(bottomYHeli);
+                    renderer.FillRectangle(float(l), float(t), float(r - l), float(b - t), Argb(255, 0, 0, 0));
+                    renderer.FillRectangle(float(l + 1), float(t + 1), float(r - l - 2), float(b - t - 2), Argb(255, 255, 255, 255));
                 }
 
-                BitBlt(hdc, 0, 0, rc.right, rc.bottom, mdc, 0, 0, SRCCOPY);
-                SelectObject(mdc, oldBmp);
-                DeleteObject(bmp);
-                DeleteDC(mdc);
-                ReleaseDC(wnd, hdc);
+                renderer.EndFrame();
 
-                Sleep(1);
+                PaceFrame(pacer);
             }
+            DestroyFramePacer(pacer);
         }
     }
+    DestroyPresentSurface(surface);
+
     // GDI+ shutdown
     if (gdiplusToken) Gdiplus::GdiplusShutdown(gdiplusToken);
     return 0;
@@ -18,6 +18,7 @@
 
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#include <mmsystem.h>
 #include <objidl.h>
 #include <gdiplus.h>
 #include <vector>
@@ -25,72 +26,134 @@
 #include <algorithm>
 #include <string>
 #include <memory>
+#include <atomic>
 #include <cmath>
+#include <cstdio>
+#include <cwchar>
+
+#include "sim.h"
+#include "atlas.h"
+#include "present_surface.h"
+#include "render_gdiplus.h"
+#include "scene.h"
+#include "particles.h"
+#include "sim_thread.h"
+#include "replay.h"
+#include "profile.h"
+#include "frame_pacer.h"
+#include "net.h"
+#include "rewind.h"
+#include "snapshot.h"
+#include "frame_arena.h"
+#include "alloc_count.h"
+#include "input.h"
 
 #pragma comment(lib, "gdiplus.lib")
-
-struct Vec2 {
-    float x = 0.f;
-    float y = 0.f;
+#pragma comment(lib, "winmm.lib")
+
+// Left, right and fire arrive as timestamped events (input.h), from the raw
+// input thread or, without it, from WndProc.
+static InputQueue gInputQueue;
+static bool gQueueKeyMessages = false;
+
+// Everything the simulation thread's step uses besides the world.
+struct LocalSession {
+    // Consumed by whichever thread steps: the simulation thread offline, the
+    // frame loop online.
+    InputTracker input;
+    // Mean and worst time from a press to the end of the step that fired
+    // it, for the timing line.
+    std::atomic<uint32_t> fireLatencyUs{ 0 };
+    std::atomic<uint32_t> fireWorstUs{ 0 };
+    ReplayRecorder recorder;
+    RewindBuffer rewind;
+    // F9 loads into this and swaps it in, so a bad file leaves the game
+    // as it was.
+    World loaded;
+    std::vector<uint8_t> saveScratch;
+    bool saveKeyWasDown = false;
+    bool loadKeyWasDown = false;
 };
 
-static Vec2 operator+(const Vec2& a, const Vec2& b) {
-    return { a.x + b.x, a.y + b.y };
-}
-
-static Vec2 operator-(const Vec2& a, const Vec2& b) {
-    return { a.x - b.x, a.y - b.y };
-}
+static const char* kQuickSavePath = "quicksave.cgs";
 
-static Vec2 operator*(const Vec2& v, float s) {
-    return { v.x * s, v.y * s };
+static SimInput QueuedInput(InputTracker& tracker, double stepStart, double stepSeconds) {
+    CGAME_PROFILE_SCOPE(ZoneInput);
+    return TakeStepInput(gInputQueue, tracker, stepStart, stepSeconds);
 }
 
-static Vec2 operator*(float s, const Vec2& v) {
-    return v * s;
-}
-template <typename T>
-static T ClampValue(T value, T minValue, T maxValue) {
-    if (value < minValue) return minValue;
-    if (value > maxValue) return maxValue;
-    return value;
+// Runs on the simulation thread once per fixed step, so input is taken at
+// the tick rate whatever the frame rate is, with each shot placed at its
+// press within the step. Every step goes into the session log, which
+// `headless --replay` plays back, and the rewind buffer. Holding Backspace
+// plays the last 10 s backwards, F5 saves and F9 loads. Inputs cannot
+// reproduce a rewound or loaded game, so the log stops at the first of
+// either.
+static void StepFromKeyboard(void* user, World& world, uint64_t, double startSeconds) {
+    LocalSession& session = *static_cast<LocalSession*>(user);
+    // Drained while rewinding too, so presses do not pile up.
+    const SimInput input = QueuedInput(session.input, startSeconds, 1.0 / world.cfg.tickRateHz);
+    if ((GetAsyncKeyState(VK_BACK) & 0x8000) != 0) {
+        if (RewindStep(session.rewind, world)) {
+            CloseReplayRecorder(session.recorder);
+        }
+        return;
+    }
+    const bool saveKeyDown = (GetAsyncKeyState(VK_F5) & 0x8000) != 0;
+    if (saveKeyDown && !session.saveKeyWasDown) {
+        SaveSnapshotFile(kQuickSavePath, world, session.saveScratch);
+    }
+    session.saveKeyWasDown = saveKeyDown;
+    const bool loadKeyDown = (GetAsyncKeyState(VK_F9) & 0x8000) != 0;
+    if (loadKeyDown && !session.loadKeyWasDown && LoadSnapshotFile(kQuickSavePath, session.loaded, session.saveScratch)) {
+        std::swap(world, session.loaded);
+        ResetRewind(session.rewind, world);
+        CloseReplayRecorder(session.recorder);
+    }
+    session.loadKeyWasDown = loadKeyDown;
+
+    RecordTick(session.recorder, world, input);
+    StepWorld(world, 1.f / world.cfg.tickRateHz, input);
+    CaptureRewind(session.rewind, world);
+    const uint64_t shots = session.input.shots;
+    NoteStepFired(session.input, world.tanks[0].fired, SteadySeconds());
+    if (session.input.shots != shots) {
+        session.fireLatencyUs.store(static_cast<uint32_t>(session.input.latencySum * 1e6 / static_cast<double>(session.input.shots)),
+                                    std::memory_order_relaxed);
+        session.fireWorstUs.store(static_cast<uint32_t>(session.input.latencyWorst * 1e6), std::memory_order_relaxed);
+    }
 }
 
-
-struct Projectile {
-    Vec2 pos;
-    Vec2 vel;
-    bool active = true;
-};
-
-struct Bomb {
-    Vec2 pos;
-    Vec2 vel;
-    bool active = true;
-};
-
-struct Helicopter {
-    Vec2 pos;
-    float speed = 0.f;
-    int dir = 1; // +1 = left to right, -1 = right to left
-    float dropCooldown = 0.f;
-};
+// Frames only present what changed, so anything that exposes or resizes the
+// window asks for one full frame.
+static bool gFullRedraw = true;
 
 LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam) {
     if (msg == WM_DESTROY) {
         PostQuitMessage(0);
         return 0;
     }
+    if (msg == WM_PAINT || msg == WM_SIZE) {
+        gFullRedraw = true;
+    }
+    if (gQueueKeyMessages && (msg == WM_KEYDOWN || msg == WM_KEYUP)) {
+        const int key = InputKeyForVirtualKey(static_cast<unsigned>(wparam));
+        if (key >= 0) {
+            PushInputEvent(gInputQueue, static_cast<InputKey>(key), msg == WM_KEYDOWN, SteadySeconds());
+        }
+    }
+    HandlePresentSurfaceMessage(hwnd, msg, wparam, lparam);
     return DefWindowProc(hwnd, msg, wparam, lparam);
 }
 
 int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
                       _In_opt_ HINSTANCE,
-                      _In_ LPWSTR,
+                      _In_ LPWSTR cmdLine,
                       _In_ int nCmdShow) {
     const wchar_t* cls = L"CGameWnd_1";
 
     WNDCLASSEX wc{ sizeof(WNDCLASSEX) };
+    wc.style = CS_OWNDC; // PresentSurface caches the window DC
     wc.lpfnWndProc = WndProc;
     wc.hInstance = hInstance;
     wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
@@ -104,11 +167,6 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
     ShowWindow(wnd, nCmdShow);
     UpdateWindow(wnd);
 
-    LARGE_INTEGER freq{};
-    LARGE_INTEGER prev{};
-    QueryPerformanceFrequency(&freq);
-    QueryPerformanceCounter(&prev);
-
     ULONG_PTR gdiplusToken = 0;
     Gdiplus::GdiplusStartupInput gsi{};
     gsi.GdiplusVersion = 1;
@@ -117,6 +175,13 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
         return 0;
     }
 
+    PresentSurface surface;
+    if (!CreatePresentSurface(surface, wnd, RGB(18, 26, 36))) {
+        MessageBox(wnd, L"Failed to create the back buffer.", L"Error", MB_ICONERROR);
+        Gdiplus::GdiplusShutdown(gdiplusToken);
+        return 0;
+    }
+
     MSG msg{};
     bool running = true;
 
@@ -125,55 +190,6 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
     const float screenWidth = static_cast<float>(rcClient.right);
     const float screenHeight = static_cast<float>(rcClient.bottom);
 
-    Vec2 tankCenter{ screenWidth * 0.5f, screenHeight - 40.f };
-    const float tankWidth = 140.f;
-    const float tankHeight = 40.f;
-    const float turretLength = 150.f;
-    const float turretMinAngleDeg = 10.f;
-    const float turretMaxAngleDeg = 170.f;
-    float turretAngleDeg = 55.f;
-    float fireCooldown = 0.f;
-    bool spaceWasDown = false;
-    int lives = 3;
-    int score = 0;
-    bool gameOver = false;
-
-    std::vector<Projectile> shells;
-    std::vector<Bomb> bombs;
-    std::vector<Helicopter> helicopters;
-
-    std::random_device rd;
-    std::mt19937 rng(rd());
-    std::uniform_real_distribution<float> heliAlt(90.f, 240.f);
-    std::uniform_real_distribution<float> heliSpeed(90.f, 160.f);
-    std::uniform_int_distribution<int> heliDir(0, 1);
-
-    const float gravity = 900.f;
-    const float projectileSpeed = 800.f;
-    const float bombRadius = 12.f;
-    const float helicopterWidth = 120.f;
-    const float helicopterHeight = 40.f;
-
-    auto resetHelicopter = [&](Helicopter& h, int forceDir) {
-        h.dir = forceDir;
-        h.speed = heliSpeed(rng);
-        h.pos.y = heliAlt(rng);
-        h.dropCooldown = 0.f;
-        if (h.dir > 0) {
-            h.pos.x = -helicopterWidth;
-        } else {
-            h.pos.x = screenWidth + helicopterWidth;
-        }
-    };
-
-    for (int i = 0; i < 3; ++i) {
-        Helicopter h{};
-        int dir = heliDir(rng) ? 1 : -1;
-        resetHelicopter(h, dir);
-        h.pos.y += i * 30.f;
-        helicopters.push_back(h);
-    }
-
     
     std::wstring exeDir;
     {
@@ -190,239 +206,272 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
         }
     }
 
-    std::wstring tankBodyPath = exeDir + L"Tank_Body.png";
-    std::wstring tankBarrelPath = exeDir + L"Tank_Barrel.png";
-
-    std::unique_ptr<Gdiplus::Image> tankBodyImg;
-    std::unique_ptr<Gdiplus::Image> tankBarrelImg;
+    // The packed atlas (atlas_pack.cpp) is mapped with no decoding. The
+    // loose PNGs are the fallback while editing art; without either the tank
+    // is drawn as plain shapes.
+    Image tankBodyImg;
+    Image tankBarrelImg;
     bool spritesLoaded = false;
-    tankBodyImg.reset(new Gdiplus::Image(tankBodyPath.c_str()));
-    tankBarrelImg.reset(new Gdiplus::Image(tankBarrelPath.c_str()));
-    if (tankBodyImg->GetLastStatus() == Gdiplus::Ok && tankBarrelImg->GetLastStatus() == Gdiplus::Ok) {
-        spritesLoaded = true;
-    } else {
-        MessageBox(wnd, L"Tank sprites not found next to the executable.", L"Image Load", MB_ICONWARNING);
+    SpriteAtlas atlas;
+    if (OpenSpriteAtlas(atlas, (exeDir + L"sprites.cga").c_str())) {
+        spritesLoaded = LoadAtlasImage(atlas, "Tank_Body", tankBodyImg) && LoadAtlasImage(atlas, "Tank_Barrel", tankBarrelImg);
+        CloseSpriteAtlas(atlas);
+    }
+    if (!spritesLoaded) {
+        spritesLoaded = LoadImageFile((exeDir + L"Tank_Body.png").c_str(), tankBodyImg) &&
+                        LoadImageFile((exeDir + L"Tank_Barrel.png").c_str(), tankBarrelImg);
+    }
+    if (!spritesLoaded) {
+        OutputDebugStringW(L"Tank sprites not found next to the executable; drawing shapes.\n");
     }
-    const float tankSpriteScale = spritesLoaded ? (1.f / 3.f) : 1.f;
-    while (running) {
-        while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
-            if (msg.message == WM_QUIT) {
-                running = false;
-                break;
-            }
-            TranslateMessage(&msg);
-            DispatchMessage(&msg);
-        }
-        if (!running) {
-            break;
-        }
-
-        LARGE_INTEGER now{};
-        QueryPerformanceCounter(&now);
-        double dtRaw = static_cast<double>(now.QuadPart - prev.QuadPart) / static_cast<double>(freq.QuadPart);
-        prev = now;
-        float dt = static_cast<float>(dtRaw);
-        dt = ClampValue(dt, 0.f, 0.05f);
 
-        fireCooldown = std::max(0.f, fireCooldown - dt);
+    SimConfig cfg{};
+    cfg.screenWidth = screenWidth;
+    cfg.screenHeight = screenHeight;
+    if (spritesLoaded) {
+        FitTankToSprites(cfg, tankBodyImg, tankBarrelImg);
+    }
 
-        if (GetAsyncKeyState(VK_LEFT) & 0x8000) {
-            turretAngleDeg = ClampValue(turretAngleDeg + 60.f * dt, turretMinAngleDeg, turretMaxAngleDeg);
+    // --connect HOST:PORT joins a `headless --serve` co-op game instead of
+    // running the simulation here.
+    NetClient client;
+    bool online = false;
+    if (const wchar_t* connect = cmdLine ? wcsstr(cmdLine, L"--connect ") : nullptr) {
+        char host[64] = {};
+        const wchar_t* at = connect + 10;
+        for (size_t i = 0; i + 1 < sizeof(host) && at[i] > L' ' && at[i] < 0x80; ++i) {
+            host[i] = static_cast<char>(at[i]);
         }
-        if (GetAsyncKeyState(VK_RIGHT) & 0x8000) {
-            turretAngleDeg = ClampValue(turretAngleDeg - 60.f * dt, turretMinAngleDeg, turretMaxAngleDeg);
+        NetAddress server;
+        if (!ParseNetAddress(host, server) || !NetStartup() || !StartNetClient(client, server)) {
+            MessageBox(wnd, L"Could not connect; expected --connect a.b.c.d:port.", L"Error", MB_ICONERROR);
+            DestroyPresentSurface(surface);
+            Gdiplus::GdiplusShutdown(gdiplusToken);
+            return 0;
         }
+        online = true;
+    }
 
-        float tankVisualWidth = spritesLoaded ? static_cast<float>(tankBodyImg->GetWidth()) * tankSpriteScale : tankWidth;
-        float tankVisualHeight = spritesLoaded ? static_cast<float>(tankBodyImg->GetHeight()) * tankSpriteScale : tankHeight;
-        Vec2 turretBase{ tankCenter.x, tankCenter.y - tankVisualHeight };
-        float turretRad = turretAngleDeg * 3.14159265f / 180.f;
-        Vec2 turretDir{ std::cos(turretRad), -std::sin(turretRad) };
-        float effectiveTurretLength = spritesLoaded ? static_cast<float>(tankBarrelImg->GetHeight()) * tankSpriteScale * 0.85f : turretLength;
-        Vec2 turretTip = turretBase + turretDir * effectiveTurretLength;
-
-        bool spaceDown = (GetAsyncKeyState(VK_SPACE) & 0x8000) != 0;
-        if (spaceDown && !spaceWasDown && fireCooldown <= 0.f && !gameOver) {
-            Projectile shell{};
-            shell.pos = turretTip;
-            shell.vel = turretDir * projectileSpeed;
-            shells.push_back(shell);
-            fireCooldown = 0.35f;
-        }
-        spaceWasDown = spaceDown;
+    std::random_device rd;
+    const uint32_t seed = rd();
+    SimThread sim;
+    InitWorld(sim.world, cfg, seed);
+
+    // Keyframe every 10 s of play. A missing log is not worth stopping for.
+    // Online the server owns the world, so there is nothing to record.
+    LocalSession session;
+    if (!online) {
+        OpenReplayRecorder(session.recorder, "last_session.cgr", sim.world, seed,
+                           static_cast<uint32_t>(cfg.tickRateHz * 10.f));
+        // 10 s of rewind; a frame is typically under 100 bytes.
+        InitRewindBuffer(session.rewind, cfg, static_cast<size_t>(cfg.tickRateHz * 10.f), size_t(16) << 20);
+        CaptureRewind(session.rewind, sim.world);
+    }
+    sim.step = StepFromKeyboard;
+    sim.user = &session;
+
+    // Toggled with A: predicted arc and firing solutions for every helicopter.
+    AimAssist aim;
+    InitAimAssist(aim, sim.world, 0);
+    bool showAim = false;
+    bool aimKeyWasDown = false;
+
+    std::unique_ptr<GdiplusRenderer> renderer(new GdiplusRenderer(surface));
+    SceneAssets assets;
+    SpriteCache bodyFrames;
+    SpriteCache barrelFrames;
+    if (spritesLoaded) {
+        BuildTankAssets(*renderer, cfg, tankBodyImg, tankBarrelImg, bodyFrames, barrelFrames, assets);
+    }
 
-        for (auto& shell : shells) {
-            if (!shell.active) {
-                continue;
-            }
-            shell.vel.y += gravity * dt;
-            shell.pos = shell.pos + shell.vel * dt;
-            if (shell.pos.y > screenHeight || shell.pos.x < -50.f || shell.pos.x > screenWidth + 50.f) {
-                shell.active = false;
-            }
-        }
+    // Without raw input the window's key messages feed the queue, stamped
+    // when the frame loop pumps them.
+    InputCapture capture;
+    gQueueKeyMessages = !StartInputCapture(capture, gInputQueue);
 
-        for (auto& b : bombs) {
-            if (!b.active) {
-                continue;
-            }
-            b.vel.y += gravity * dt;
-            b.pos = b.pos + b.vel * dt;
-            if (b.pos.y > screenHeight + 50.f) {
-                b.active = false;
-            }
-        }
+    // The simulation thread sleeps between steps; ask for 1 ms timer
+    // resolution so it wakes close to on time.
+    timeBeginPeriod(1);
+    if (!online) {
+        StartSimThread(sim);
+    }
+    // Online, the client steps at the server's tick rate on this thread:
+    // each step takes the queued input, predicts the turret and sends it.
+    FixedStepper netStepper;
 
-        for (auto& h : helicopters) {
-            h.pos.x += h.speed * h.dir * dt;
-            h.dropCooldown = std::max(0.f, h.dropCooldown - dt);
-
-            float heliCenterX = h.pos.x + helicopterWidth * 0.5f;
-            if (!gameOver && h.dropCooldown <= 0.f && std::abs(heliCenterX - tankCenter.x) < tankVisualWidth * 0.35f) {
-                Bomb bomb{};
-                bomb.pos = { heliCenterX, h.pos.y + helicopterHeight };
-                bomb.vel = { h.speed * 0.2f * h.dir, 0.f };
-                bombs.push_back(bomb);
-                h.dropCooldown = 2.2f;
-            }
+    bool gameOver = false;
+    double renderMs = 0.0;
+    char timing[192] = "";
+    // The timing line is refreshed four times a second rather than every
+    // frame, so it does not keep its strip of the window dirty.
+    double timingUpdated = 0.0;
+    SceneLayers layers;
+    FrameArena frameArena;
+    InitFrameArena(frameArena, size_t(64) << 10);
+    // Heap allocations on any thread once play has settled, shown with the
+    // timing; steady play should leave it at zero.
+    const double allocWarmupEnd = SteadySeconds() + 2.0;
+    bool allocsCounted = false;
+    uint64_t allocsAtWarmup = 0;
+    ParticleSystem particles;
+    InitParticleSystem(particles, 16384, 64);
+    uint64_t nextImpactTick = 0;
+    double lastFrameStart = SteadySeconds();
+    SceneLabel labels[2];
+    int labelCount = 1;
+
+    // Frame rate cap, 120 unless given as --fps N.
+    double targetFps = 120.0;
+    if (const wchar_t* fps = cmdLine ? wcsstr(cmdLine, L"--fps ") : nullptr) {
+        targetFps = std::max(_wtof(fps + 6), 1.0);
+    }
+    FramePacer pacer;
+    InitFramePacer(pacer, targetFps);
+#if CGAME_PROFILE
+    char profileText[96] = "";
+    bool traceKeyWasDown = false;
+#endif
 
-            if (h.dir > 0 && h.pos.x > screenWidth + helicopterWidth) {
-                resetHelicopter(h, -1);
-            } else if (h.dir < 0 && h.pos.x + helicopterWidth < -helicopterWidth) {
-                resetHelicopter(h, 1);
+    while (running) {
+        CGAME_PROFILE_SCOPE(ZoneFrame);
+        {
+            CGAME_PROFILE_SCOPE(ZoneMessagePump);
+            while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+                if (msg.message == WM_QUIT) {
+                    running = false;
+                    break;
+                }
+                TranslateMessage(&msg);
+                DispatchMessage(&msg);
             }
         }
+        if (!running) {
+            break;
+        }
 
-        if (!gameOver) {
-            for (auto& h : helicopters) {
-                Gdiplus::RectF heliRect(h.pos.x, h.pos.y, helicopterWidth, helicopterHeight);
-                for (auto& shell : shells) {
-                    if (!shell.active) {
-                        continue;
-                    }
-                    if (heliRect.Contains(shell.pos.x, shell.pos.y)) {
-                        shell.active = false;
-                        score += 10;
-                        resetHelicopter(h, h.dir > 0 ? -1 : 1);
-                        break;
-                    }
+        const double frameStart = SteadySeconds();
+        const RenderState* latest = nullptr;
+        if (online) {
+            if (client.joined) {
+                // The tick rate comes from the Welcome, so it is set here
+                // rather than when the stepper is made.
+                netStepper.stepSeconds = 1.0 / client.cfg.tickRateHz;
+                const double step = netStepper.stepSeconds;
+                for (int due = TakeDueSteps(netStepper, frameStart - lastFrameStart); due > 0; --due) {
+                    const double stepStart = frameStart - netStepper.accumulator - due * step;
+                    ClientTick(client, QueuedInput(session.input, stepStart, step), frameStart);
                 }
+            } else {
+                // Sends the Join and waits for the Welcome.
+                ClientTick(client, SimInput{}, frameStart);
             }
-
-            float tankLeft = tankCenter.x - tankVisualWidth * 0.5f;
-            float tankRight = tankCenter.x + tankVisualWidth * 0.5f;
-            float tankTop = tankCenter.y - tankVisualHeight;
-            float tankBottom = tankCenter.y;
-
-            for (auto& b : bombs) {
-                if (!b.active) {
-                    continue;
-                }
-                if (b.pos.x >= tankLeft && b.pos.x <= tankRight &&
-                    b.pos.y + bombRadius >= tankTop && b.pos.y <= tankBottom) {
-                    b.active = false;
-                    lives -= 1;
-                    if (lives <= 0) {
-                        gameOver = true;
-                    }
-                }
+            if (client.rejected) {
+                MessageBox(wnd, L"The server is full.", L"Error", MB_ICONERROR);
+                break;
             }
-        }
-
-        shells.erase(std::remove_if(shells.begin(), shells.end(), [](const Projectile& p) { return !p.active; }), shells.end());
-        bombs.erase(std::remove_if(bombs.begin(), bombs.end(), [](const Bomb& b) { return !b.active; }), bombs.end());
-        HDC hdc = GetDC(wnd);
-        RECT rc{};
-        GetClientRect(wnd, &rc);
-        HDC mdc = CreateCompatibleDC(hdc);
-        HBITMAP bmp = CreateCompatibleBitmap(hdc, rc.right, rc.bottom);
-        HGDIOBJ oldBmp = SelectObject(mdc, bmp);
-
-        HBRUSH bg = CreateSolidBrush(RGB(18, 26, 36));
-        FillRect(mdc, &rc, bg);
-        DeleteObject(bg);
-
-        Gdiplus::Graphics g(mdc);
-        g.SetSmoothingMode(Gdiplus::SmoothingModeHighQuality);
-        g.SetInterpolationMode(Gdiplus::InterpolationModeHighQualityBilinear);
-
-        Gdiplus::SolidBrush groundBrush(Gdiplus::Color(255, 40, 70, 50));
-        g.FillRectangle(&groundBrush, 0.f, tankCenter.y - tankVisualHeight * 0.5f + 20.f, screenWidth, screenHeight);
-
-        if (spritesLoaded) {
-            g.SetInterpolationMode(Gdiplus::InterpolationModeNearestNeighbor);
-            g.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
-
-            const float barrelDrawWidth = static_cast<float>(tankBarrelImg->GetWidth()) * tankSpriteScale;
-            const float barrelDrawHeight = static_cast<float>(tankBarrelImg->GetHeight()) * tankSpriteScale;
-            g.TranslateTransform(turretBase.x, turretBase.y);
-            g.RotateTransform(90.f - turretAngleDeg);
-            g.DrawImage(tankBarrelImg.get(), Gdiplus::RectF(-barrelDrawWidth * 0.5f, -barrelDrawHeight, barrelDrawWidth, barrelDrawHeight));
-            g.ResetTransform();
-
-            const float bodyDrawWidth = static_cast<float>(tankBodyImg->GetWidth()) * tankSpriteScale;
-            const float bodyDrawHeight = static_cast<float>(tankBodyImg->GetHeight()) * tankSpriteScale;
-            const float bodyX = tankCenter.x - bodyDrawWidth * 0.5f;
-            const float bodyY = tankCenter.y - bodyDrawHeight;
-            g.DrawImage(tankBodyImg.get(), Gdiplus::RectF(bodyX, bodyY, bodyDrawWidth, bodyDrawHeight));
-
-            g.SetPixelOffsetMode(Gdiplus::PixelOffsetModeDefault);
-            g.SetInterpolationMode(Gdiplus::InterpolationModeHighQualityBilinear);
+            if (!client.haveState) {
+                lastFrameStart = frameStart;
+                PaceFrame(pacer);
+                continue;
+            }
+            latest = &ClientRenderState(client);
         } else {
-            Gdiplus::SolidBrush tankBrush(Gdiplus::Color(255, 70, 120, 60));
-            Gdiplus::RectF tankRect(tankCenter.x - tankVisualWidth * 0.5f, tankCenter.y - tankVisualHeight, tankVisualWidth, tankVisualHeight);
-            g.FillRectangle(&tankBrush, tankRect);
-
-            Gdiplus::Pen turretPen(Gdiplus::Color(255, 180, 220, 200), 10.f);
-            g.DrawLine(&turretPen, turretBase.x, turretBase.y, turretTip.x, turretTip.y);
+            sim.states.Acquire();
+            latest = &sim.states.Front();
         }
-
-        Gdiplus::SolidBrush heliBrush(Gdiplus::Color(255, 180, 60, 60));
-        for (const auto& h : helicopters) {
-            g.FillRectangle(&heliBrush, h.pos.x, h.pos.y, helicopterWidth, helicopterHeight);
-            g.FillRectangle(&heliBrush, h.pos.x - 15.f, h.pos.y + helicopterHeight * 0.5f - 5.f, helicopterWidth + 30.f, 10.f);
+        const RenderState& state = *latest;
+        // Snapshots are drawn as they arrive; the local turret is predicted
+        // every step, so it needs no blending either.
+        const float alpha = online ? 1.f : RenderAlpha(state, frameStart);
+
+        const bool aimKeyDown = (GetAsyncKeyState('A') & 0x8000) != 0;
+        if (aimKeyDown && !aimKeyWasDown) {
+            showAim = !showAim;
         }
-
-        Gdiplus::SolidBrush projectileBrush(Gdiplus::Color(255, 240, 240, 200));
-        for (const auto& shell : shells) {
-            g.FillEllipse(&projectileBrush, shell.pos.x - 6.f, shell.pos.y - 6.f, 12.f, 12.f);
+        aimKeyWasDown = aimKeyDown;
+
+        // Particles move in wall-clock time; a long stall (a dragged window)
+        // is not replayed.
+        EmitNewImpacts(particles, state.impacts, nextImpactTick);
+        UpdateParticles(particles, static_cast<float>(std::min(frameStart - lastFrameStart, 0.1)));
+        lastFrameStart = frameStart;
+
+#if CGAME_PROFILE
+        // P writes the profiler rings as a chrome://tracing file.
+        const bool traceKeyDown = (GetAsyncKeyState('P') & 0x8000) != 0;
+        if (traceKeyDown && !traceKeyWasDown) {
+            ExportChromeTrace("profile_trace.json");
         }
+        traceKeyWasDown = traceKeyDown;
+#endif
 
-        Gdiplus::SolidBrush bombBrush(Gdiplus::Color(255, 200, 80, 30));
-        for (const auto& b : bombs) {
-            g.FillEllipse(&bombBrush, b.pos.x - bombRadius, b.pos.y - bombRadius, bombRadius * 2.f, bombRadius * 2.f);
+        {
+            CGAME_PROFILE_SCOPE(ZoneDraw);
+            renderer->BeginFrame();
+            if (showAim) {
+                UpdateAimAssist(aim, state.cfg, state.helicopters);
+            }
+            if (!allocsCounted && frameStart >= allocWarmupEnd) {
+                allocsCounted = true;
+                allocsAtWarmup = HeapAllocations();
+            }
+            if (frameStart - timingUpdated >= 0.25) {
+                timingUpdated = frameStart;
+                const FramePacerStats pace = GetFramePacerStats(pacer);
+                const uint64_t allocs = allocsCounted ? HeapAllocations() - allocsAtWarmup : 0;
+                std::snprintf(timing, sizeof(timing),
+                              "sim %.3f ms/step  ai %.1f us, wait %u  render %.2f ms/frame  frame %.2f ms  jitter %.2f ms  fire %.1f ms (worst %.1f)  allocs %llu",
+                              state.simStepMs, state.aiStepUs, state.aiMaxWait, renderMs, pace.meanMs, pace.jitterMs,
+                              session.fireLatencyUs.load(std::memory_order_relaxed) * 1e-3,
+                              session.fireWorstUs.load(std::memory_order_relaxed) * 1e-3, static_cast<unsigned long long>(allocs));
+#if CGAME_PROFILE
+                const ProfileStats frame = ProfileZoneStats(ZoneFrame, 240);
+                const ProfileStats step = ProfileZoneStats(ZoneStep, 240);
+                std::snprintf(profileText, sizeof(profileText), "frame p50 %.2f p99 %.2f ms   step p50 %.3f p99 %.3f ms",
+                              frame.p50Ms, frame.p99Ms, step.p50Ms, step.p99Ms);
+#endif
+            }
+            labels[0] = SceneLabel{ timing, 0.f, state.cfg.screenHeight - 18.f, state.cfg.screenWidth, 16.f, 11.f, Argb(160, 200, 210, 220) };
+#if CGAME_PROFILE
+            labels[1] = SceneLabel{ profileText, 0.f, 36.f, state.cfg.screenWidth, 20.f, 13.f, Argb(220, 255, 230, 140) };
+            labelCount = 2;
+#endif
+            if (gFullRedraw) {
+                layers.full = true;
+                gFullRedraw = false;
+            }
+            DrawSceneDirty(*renderer, layers, frameArena, state, alpha, assets, showAim ? &aim : nullptr, &particles, labels, labelCount);
         }
-
-        std::wstring overlay = L"Lives: " + std::to_wstring(lives) +
-            L"   Score: " + std::to_wstring(score) +
-            L"   Angle: " + std::to_wstring(static_cast<int>(turretAngleDeg)) + L" deg";
-        if (gameOver) {
-            overlay += L"   GAME OVER";
+        {
+            CGAME_PROFILE_SCOPE(ZonePresent);
+            renderer->EndFrameRects(layers.dirty.data(), static_cast<int>(layers.dirty.size()));
         }
+        ResetFrameArena(frameArena);
+        renderMs = (SteadySeconds() - frameStart) * 1e3;
 
-        Gdiplus::SolidBrush textBrush(Gdiplus::Color(255, 255, 255, 255));
-        Gdiplus::Font font(L"Segoe UI", 18.f, Gdiplus::FontStyleRegular, Gdiplus::UnitPixel);
-        Gdiplus::StringFormat fmt;
-        fmt.SetAlignment(Gdiplus::StringAlignmentCenter);
-        Gdiplus::RectF textRect(0.f, 10.f, screenWidth, 30.f);
-        g.DrawString(overlay.c_str(), -1, &font, textRect, &fmt, &textBrush);
-
-        BitBlt(hdc, 0, 0, rc.right, rc.bottom, mdc, 0, 0, SRCCOPY);
-        SelectObject(mdc, oldBmp);
-        DeleteObject(bmp);
-        DeleteDC(mdc);
-        ReleaseDC(wnd, hdc);
-
-        if (gameOver) {
+        if (state.gameOver) {
+            gameOver = true;
             Sleep(1000);
             running = false;
         }
 
-        Sleep(1);
+        CGAME_PROFILE_SCOPE(ZoneSleep);
+        PaceFrame(pacer);
+    }
+
+    if (online) {
+        StopNetClient(client);
+        NetShutdown();
+    } else {
+        StopSimThread(sim);
     }
+    StopInputCapture(capture);
+    DestroyFramePacer(pacer);
+    CloseReplayRecorder(session.recorder);
+    timeEndPeriod(1);
 
-    tankBarrelImg.reset();
-    tankBodyImg.reset();
+    renderer.reset();
+    DestroyPresentSurface(surface);
 
     if (gdiplusToken) {
         Gdiplus::GdiplusShutdown(gdiplusToken);
@@ -29,8 +29,12 @@
 #include <gdiplustypes.h>
 #pragma comment(lib, "gdiplus.lib")
 
+#include "frame_pacer.h"
+#include "present_surface.h"
+
 LRESULT CALLBACK WndProc(HWND h, UINT m, WPARAM w, LPARAM l) {
     if (m == WM_DESTROY) { PostQuitMessage(0); return 0; }
+    HandlePresentSurfaceMessage(h, m, w, l);
     return DefWindowProc(h, m, w, l);
 }
 
@@ -42,6 +46,7 @@ int APIENTRY wWinMain(
 {
     const wchar_t* cls = L"CGameWnd";
     WNDCLASSEX wc{ sizeof(WNDCLASSEX) };
+    wc.style = CS_OWNDC; // PresentSurface caches the window DC
     wc.lpfnWndProc = WndProc;
     wc.hInstance = hInstance;
     wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
@@ -69,10 +74,19 @@ int APIENTRY wWinMain(
         MessageBox(wnd, L"GDI+ failed to start.", L"Error", MB_ICONERROR);
         return 0;
     }
+
+    PresentSurface surface;
+    if (!CreatePresentSurface(surface, wnd, RGB(30, 30, 40))) {
+        MessageBox(wnd, L"Failed to create the back buffer.", L"Error", MB_ICONERROR);
+        Gdiplus::GdiplusShutdown(gdiplusToken);
+        return 0;
+    }
     {
         double phi = 0;
         MSG msg{};
         bool running = true;
+        FramePacer pacer;
+        InitFramePacer(pacer, 120.0);
         while (running) {
             while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
                 if (msg.message == WM_QUIT) running = false;
@@ -85,16 +99,8 @@ int APIENTRY wWinMain(
             float dt = float(double(now.QuadPart - prev.QuadPart) / double(freq.QuadPart));
             prev = now;
 
-            RECT rc; GetClientRect(wnd, &rc);
-
-            HDC hdc = GetDC(wnd);
-            HDC mdc = CreateCompatibleDC(hdc);
-            HBITMAP bmp = CreateCompatibleBitmap(hdc, rc.right, rc.bottom);
-            HGDIOBJ oldBmp = SelectObject(mdc, bmp);
-
-            HBRUSH bg = CreateSolidBrush(RGB(30, 30, 40));
-            FillRect(mdc, &rc, bg);
-            DeleteObject(bg);
+            ClearPresentSurface(surface);
+            HDC mdc = surface.memDC;
 
             int ecx = 400;
 			int ecy = 320;
@@ -115,15 +121,14 @@ int APIENTRY wWinMain(
                 g.SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
             }
 
-            BitBlt(hdc, 0, 0, rc.right, rc.bottom, mdc, 0, 0, SRCCOPY);
-            SelectObject(mdc, oldBmp);
-            DeleteObject(bmp);
-            DeleteDC(mdc);
-            ReleaseDC(wnd, hdc);
+            PresentToWindow(surface);
 
-            Sleep(1);
+            PaceFrame(pacer);
         }
+        DestroyFramePacer(pacer);
     }
+    DestroyPresentSurface(surface);
+
     // GDI+ shutdown
     if (gdiplusToken) Gdiplus::GdiplusShutdown(gdiplusToken);
     return 0;
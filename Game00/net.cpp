@@ -0,0 +1,792 @@
+#include "net.h"
+
+#include "delta.h"
+#include "replay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#ifdef _WIN32
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  define WIN32_LEAN_AND_MEAN
+#  include <winsock2.h>
+#  include <ws2tcpip.h>
+#  pragma comment(lib, "ws2_32.lib")
+#else
+#  include <arpa/inet.h>
+#  include <cerrno>
+#  include <fcntl.h>
+#  include <netinet/in.h>
+#  include <sys/socket.h>
+#  include <unistd.h>
+#endif
+
+static const uint8_t kNetMagic[3] = { 'C', 'G', 'N' };
+static const uint32_t kNetVersion = 3;
+
+enum PacketType : uint8_t {
+    PacketJoin = 1,    // client: u32 version
+    PacketLeave,       // client: nothing
+    PacketInput,       // client: u8 hasAck, u32 ackTick, u32 firstSeq, u8 count, count packed inputs
+    PacketWelcome,     // server: u8 tank, SimConfig
+    PacketFull,        // server: nothing
+    PacketSnapshot,    // server: u32 tick, u8 hasBase, u32 baseTick, u32 appliedSeq, delta
+};
+
+// Inputs queued past this many are dropped, oldest first, so a burst after
+// a stall cannot leave a client permanently behind.
+static const uint32_t kMaxInputBacklog = 8;
+static const double kJoinRetrySeconds = 0.5;
+// Quantization: positions in 1/8 px, angles in 1/100 degree.
+static const float kPositionScale = 8.f;
+static const float kAngleScale = 100.f;
+static const float kMispredictionDeg = 0.05f;
+// lives, score, gameOver, and the tank, helicopter, impact, shell and bomb counts.
+static const size_t kStateHeaderBytes = 2 + 4 + 1 + 1 + 1 + 1 + 2 + 2;
+static const size_t kTankBytes = 2;
+static const size_t kHelicopterBytes = 5;
+static const size_t kImpactBytes = 9;
+static const size_t kProjectileBytes = 4;
+
+static double NowSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#ifdef _WIN32
+typedef SOCKET NativeSocket;
+static const NativeSocket kNoSocket = INVALID_SOCKET;
+#else
+typedef int NativeSocket;
+static const NativeSocket kNoSocket = -1;
+#endif
+
+static NativeSocket Native(const NetSocket& sock) {
+    return static_cast<NativeSocket>(sock.handle);
+}
+
+bool NetStartup() {
+#ifdef _WIN32
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+    return true;
+#endif
+}
+
+void NetShutdown() {
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+bool OpenUdpSocket(NetSocket& sock, uint16_t port, bool loopbackOnly) {
+    CloseUdpSocket(sock);
+    const NativeSocket s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == kNoSocket) {
+        return false;
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(loopbackOnly ? INADDR_LOOPBACK : INADDR_ANY);
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    // Without this a send to a closed port makes the next receive fail
+    // with WSAECONNRESET.
+    BOOL reportReset = FALSE;
+    DWORD unused = 0;
+    WSAIoctl(s, _WSAIOW(IOC_VENDOR, 12), &reportReset, sizeof(reportReset), nullptr, 0, &unused, nullptr, nullptr);
+    const bool ok = ioctlsocket(s, FIONBIO, &nonBlocking) == 0 &&
+                    bind(s, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0;
+    if (!ok) {
+        closesocket(s);
+        return false;
+    }
+#else
+    const int flags = fcntl(s, F_GETFL, 0);
+    const bool ok = flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0 &&
+                    bind(s, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0;
+    if (!ok) {
+        close(s);
+        return false;
+    }
+#endif
+    sock.handle = static_cast<intptr_t>(s);
+    SeedPcg32(sock.lossRng, LocalPort(sock));
+    return true;
+}
+
+void CloseUdpSocket(NetSocket& sock) {
+    if (sock.handle == -1) {
+        return;
+    }
+#ifdef _WIN32
+    closesocket(Native(sock));
+#else
+    close(Native(sock));
+#endif
+    sock.handle = -1;
+}
+
+uint16_t LocalPort(const NetSocket& sock) {
+    sockaddr_in addr{};
+#ifdef _WIN32
+    int len = sizeof(addr);
+#else
+    socklen_t len = sizeof(addr);
+#endif
+    if (getsockname(Native(sock), reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+        return 0;
+    }
+    return ntohs(addr.sin_port);
+}
+
+bool SendPacket(NetSocket& sock, const NetAddress& to, const uint8_t* data, size_t size) {
+    if (sock.lossRate > 0.f && UniformFloat(sock.lossRng, 0.f, 1.f) < sock.lossRate) {
+        return true;
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(to.port);
+    addr.sin_addr.s_addr = htonl(to.ip);
+    const auto sent = sendto(Native(sock), reinterpret_cast<const char*>(data), static_cast<int>(size), 0,
+                             reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+    return sent >= 0 && static_cast<size_t>(sent) == size;
+}
+
+int ReceivePacket(NetSocket& sock, NetAddress& from, uint8_t* buffer, size_t capacity) {
+    for (;;) {
+        sockaddr_in addr{};
+#ifdef _WIN32
+        int len = sizeof(addr);
+#else
+        socklen_t len = sizeof(addr);
+#endif
+        const auto got = recvfrom(Native(sock), reinterpret_cast<char*>(buffer), static_cast<int>(capacity), 0,
+                                  reinterpret_cast<sockaddr*>(&addr), &len);
+        if (got >= 0) {
+            from.ip = ntohl(addr.sin_addr.s_addr);
+            from.port = ntohs(addr.sin_port);
+            return static_cast<int>(got);
+        }
+        // An oversized datagram or an ICMP error only loses that packet;
+        // anything else means nothing is waiting.
+#ifdef _WIN32
+        const int error = WSAGetLastError();
+        if (error != WSAECONNRESET && error != WSAEMSGSIZE) {
+            return -1;
+        }
+#else
+        if (errno != EINTR && errno != ECONNREFUSED && errno != EMSGSIZE) {
+            return -1;
+        }
+#endif
+    }
+}
+
+bool ParseNetAddress(const char* text, NetAddress& out) {
+    NetAddress addr;
+    addr.port = kNetDefaultPort;
+    const char* at = text;
+    if (std::strncmp(at, "localhost", 9) == 0) {
+        addr.ip = 0x7f000001;
+        at += 9;
+    } else {
+        for (int part = 0; part < 4; ++part) {
+            if (part > 0 && *at++ != '.') {
+                return false;
+            }
+            uint32_t value = 0;
+            int digits = 0;
+            while (*at >= '0' && *at <= '9' && digits < 3) {
+                value = value * 10 + static_cast<uint32_t>(*at++ - '0');
+                ++digits;
+            }
+            if (digits == 0 || value > 255) {
+                return false;
+            }
+            addr.ip = (addr.ip << 8) | value;
+        }
+    }
+    if (*at == ':') {
+        ++at;
+        uint32_t port = 0;
+        int digits = 0;
+        while (*at >= '0' && *at <= '9' && digits < 5) {
+            port = port * 10 + static_cast<uint32_t>(*at++ - '0');
+            ++digits;
+        }
+        if (digits == 0 || port == 0 || port > 65535) {
+            return false;
+        }
+        addr.port = static_cast<uint16_t>(port);
+    }
+    if (*at != '\0') {
+        return false;
+    }
+    out = addr;
+    return true;
+}
+
+static void PutU8(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+static void PutU16(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(static_cast<uint8_t>(v));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+}
+
+static void PutU32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+}
+
+static void PutI16(std::vector<uint8_t>& out, float v) {
+    const float clamped = ClampValue(std::round(v), -32768.f, 32767.f);
+    PutU16(out, static_cast<uint16_t>(static_cast<int16_t>(clamped)));
+}
+
+static void PutHeader(std::vector<uint8_t>& out, PacketType type) {
+    out.clear();
+    out.insert(out.end(), kNetMagic, kNetMagic + sizeof(kNetMagic));
+    out.push_back(type);
+}
+
+struct NetReader {
+    const uint8_t* at;
+    const uint8_t* end;
+    bool ok;
+};
+
+static uint32_t GetBytes(NetReader& r, int n) {
+    if (!r.ok || r.end - r.at < n) {
+        r.ok = false;
+        return 0;
+    }
+    uint32_t v = 0;
+    for (int i = 0; i < n; ++i) {
+        v |= static_cast<uint32_t>(*r.at++) << (8 * i);
+    }
+    return v;
+}
+
+static uint32_t GetU8(NetReader& r) { return GetBytes(r, 1); }
+static uint32_t GetU16(NetReader& r) { return GetBytes(r, 2); }
+static uint32_t GetU32(NetReader& r) { return GetBytes(r, 4); }
+
+static float GetI16(NetReader& r) {
+    return static_cast<float>(static_cast<int16_t>(static_cast<uint16_t>(GetBytes(r, 2))));
+}
+
+// Checks the magic and returns the packet type, or 0.
+static uint8_t ReadHeader(NetReader& r) {
+    if (r.end - r.at < 4 || std::memcmp(r.at, kNetMagic, sizeof(kNetMagic)) != 0) {
+        return 0;
+    }
+    r.at += 4;
+    return r.at[-1];
+}
+
+static bool SameAddress(const NetAddress& a, const NetAddress& b) {
+    return a.ip == b.ip && a.port == b.port;
+}
+
+static void Send(NetSocket& sock, NetTraffic& traffic, const NetAddress& to, const std::vector<uint8_t>& packet) {
+    SendPacket(sock, to, packet.data(), packet.size());
+    traffic.bytesSent += packet.size();
+    ++traffic.packetsSent;
+}
+
+void QuantizeWorld(const World& world, const ImpactLog& impacts, std::vector<uint8_t>& out) {
+    const size_t tanks = std::min<size_t>(world.tanks.size(), 255);
+    const size_t impactCount = std::min(impacts.count, kNetImpacts);
+    size_t room = kNetMaxStateBytes - kStateHeaderBytes - tanks * kTankBytes - impactCount * kImpactBytes;
+    const size_t helis = std::min<size_t>(std::min<size_t>(world.helicopters.size(), 255), room / kHelicopterBytes);
+    room -= helis * kHelicopterBytes;
+    // Bombs before shells: a missing bomb is a hit the player never saw coming.
+    const size_t bombs = std::min(world.bombs.count, room / kProjectileBytes);
+    room -= bombs * kProjectileBytes;
+    const size_t shells = std::min(world.shells.count, room / kProjectileBytes);
+
+    out.clear();
+    PutU16(out, static_cast<uint16_t>(static_cast<int16_t>(world.lives)));
+    PutU32(out, static_cast<uint32_t>(world.score));
+    PutU8(out, world.gameOver ? 1 : 0);
+    PutU8(out, static_cast<uint32_t>(tanks));
+    PutU8(out, static_cast<uint32_t>(helis));
+    PutU8(out, static_cast<uint32_t>(impactCount));
+    PutU16(out, static_cast<uint32_t>(shells));
+    PutU16(out, static_cast<uint32_t>(bombs));
+    for (size_t i = 0; i < tanks; ++i) {
+        PutU16(out, static_cast<uint32_t>(std::lround(world.tanks[i].turretAngleDeg * kAngleScale)));
+    }
+    for (size_t k = 0; k < helis; ++k) {
+        const Helicopter h = HelicopterAt(world, k);
+        PutI16(out, h.pos.x * kPositionScale);
+        PutI16(out, h.pos.y * kPositionScale);
+        PutU8(out, static_cast<uint32_t>(static_cast<int8_t>(h.dir)));
+    }
+    for (size_t i = impacts.count - impactCount; i < impacts.count; ++i) {
+        const ImpactEvent& e = ImpactAt(impacts, i);
+        PutU8(out, static_cast<uint32_t>(e.impact.kind));
+        PutI16(out, e.impact.x * kPositionScale);
+        PutI16(out, e.impact.y * kPositionScale);
+        PutU32(out, static_cast<uint32_t>(e.tick));
+    }
+    for (size_t i = 0; i < shells; ++i) {
+        PutI16(out, world.shells.x[i] * kPositionScale);
+        PutI16(out, world.shells.y[i] * kPositionScale);
+    }
+    for (size_t i = 0; i < bombs; ++i) {
+        PutI16(out, world.bombs.x[i] * kPositionScale);
+        PutI16(out, world.bombs.y[i] * kPositionScale);
+    }
+}
+
+static void GetProjectiles(NetReader& r, size_t count, std::vector<Vec2>& prev, std::vector<Vec2>& pos) {
+    prev.resize(count);
+    pos.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const float x = GetI16(r) / kPositionScale;
+        const float y = GetI16(r) / kPositionScale;
+        pos[i] = prev[i] = { x, y };
+    }
+}
+
+bool DequantizeState(const uint8_t* data, size_t size, const SimConfig& cfg, RenderState& state) {
+    NetReader r{ data, data + size, true };
+    const int lives = static_cast<int16_t>(static_cast<uint16_t>(GetU16(r)));
+    const int score = static_cast<int32_t>(GetU32(r));
+    const bool gameOver = GetU8(r) != 0;
+    const size_t tanks = GetU8(r);
+    const size_t helis = GetU8(r);
+    const size_t impactCount = GetU8(r);
+    const size_t shells = GetU16(r);
+    const size_t bombs = GetU16(r);
+    if (!r.ok || size != kStateHeaderBytes + tanks * kTankBytes + helis * kHelicopterBytes +
+                              impactCount * kImpactBytes + (shells + bombs) * kProjectileBytes) {
+        return false;
+    }
+    // The sizes add up, so nothing below can run past the end.
+    state.cfg = cfg;
+    state.lives = lives;
+    state.score = score;
+    state.gameOver = gameOver;
+    state.tanks.resize(tanks);
+    for (size_t i = 0; i < tanks; ++i) {
+        Tank& t = state.tanks[i];
+        t.center = TankHome(cfg, static_cast<int>(i));
+        t.turretAngleDeg = t.prevTurretAngleDeg = static_cast<float>(GetU16(r)) / kAngleScale;
+    }
+    // Helicopters keep their slots between snapshots, so the old position
+    // is the one to interpolate from unless the count changed.
+    const bool sameHelis = state.helicopters.size() == helis;
+    state.helicopters.resize(helis);
+    for (size_t k = 0; k < helis; ++k) {
+        Helicopter& h = state.helicopters[k];
+        const Vec2 old = h.pos;
+        h.pos.x = GetI16(r) / kPositionScale;
+        h.pos.y = GetI16(r) / kPositionScale;
+        h.prevPos = sameHelis ? old : h.pos;
+        h.dir = static_cast<int8_t>(GetU8(r)) < 0 ? -1 : 1;
+    }
+    ClearImpactLog(state.impacts);
+    for (size_t i = 0; i < impactCount; ++i) {
+        ImpactEvent e;
+        e.impact.kind = static_cast<ImpactKind>(GetU8(r));
+        e.impact.x = GetI16(r) / kPositionScale;
+        e.impact.y = GetI16(r) / kPositionScale;
+        e.impact.time = 0.f;
+        e.tick = GetU32(r);
+        PushImpact(state.impacts, e);
+    }
+    GetProjectiles(r, shells, state.shellPrev, state.shellPos);
+    GetProjectiles(r, bombs, state.bombPrev, state.bombPos);
+    return r.ok;
+}
+
+bool StartNetServer(NetServer& server, const SimConfig& cfg, uint32_t seed, uint16_t port, bool loopbackOnly) {
+    if (cfg.tankCount < 1 || cfg.tankCount > 255 || !OpenUdpSocket(server.socket, port, loopbackOnly)) {
+        return false;
+    }
+    InitWorld(server.world, cfg, seed);
+    server.tick = 0;
+    server.clients.assign(static_cast<size_t>(cfg.tankCount), NetClientSlot{});
+    server.stepInputs.assign(static_cast<size_t>(cfg.tankCount), SimInput{});
+    ClearImpactLog(server.impactLog);
+    for (uint32_t i = 0; i < kNetHistory; ++i) {
+        server.history[i].clear();
+        server.history[i].reserve(kNetMaxStateBytes);
+        server.historyTick[i] = 0;
+    }
+    server.packet.reserve(kNetMaxPacket);
+    server.stepSeconds = server.snapshotSeconds = 0.0;
+    server.steps = 0;
+    return true;
+}
+
+void StopNetServer(NetServer& server) {
+    CloseUdpSocket(server.socket);
+    server.clients.clear();
+}
+
+int ConnectedClients(const NetServer& server) {
+    int n = 0;
+    for (const NetClientSlot& c : server.clients) {
+        n += c.connected ? 1 : 0;
+    }
+    return n;
+}
+
+static NetClientSlot* FindSlot(NetServer& server, const NetAddress& from) {
+    for (NetClientSlot& c : server.clients) {
+        if (c.connected && SameAddress(c.address, from)) {
+            return &c;
+        }
+    }
+    return nullptr;
+}
+
+static void SendWelcome(NetServer& server, NetClientSlot& slot) {
+    PutHeader(server.packet, PacketWelcome);
+    PutU8(server.packet, static_cast<uint32_t>(&slot - server.clients.data()));
+    const uint8_t* cfg = reinterpret_cast<const uint8_t*>(&server.world.cfg);
+    server.packet.insert(server.packet.end(), cfg, cfg + sizeof(SimConfig));
+    Send(server.socket, slot.traffic, slot.address, server.packet);
+}
+
+static void HandleJoin(NetServer& server, const NetAddress& from, NetReader& r, double now) {
+    if (GetU32(r) != kNetVersion || !r.ok) {
+        return;
+    }
+    // A repeated Join means the Welcome was lost.
+    NetClientSlot* slot = FindSlot(server, from);
+    if (!slot) {
+        for (NetClientSlot& c : server.clients) {
+            if (!c.connected) {
+                c = NetClientSlot{};
+                c.connected = true;
+                c.address = from;
+                slot = &c;
+                break;
+            }
+        }
+    }
+    if (!slot) {
+        PutHeader(server.packet, PacketFull);
+        SendPacket(server.socket, from, server.packet.data(), server.packet.size());
+        return;
+    }
+    slot->lastHeardSeconds = now;
+    SendWelcome(server, *slot);
+}
+
+static void HandleInput(NetServer& server, NetClientSlot& slot, NetReader& r) {
+    const bool hasAck = GetU8(r) != 0;
+    const uint32_t ackTick = GetU32(r);
+    const uint32_t firstSeq = GetU32(r);
+    const uint32_t count = GetU8(r);
+    if (!r.ok || count > kNetInputWindow || static_cast<size_t>(r.end - r.at) < count || firstSeq == 0) {
+        return;
+    }
+    // Only move the baseline forward, and only to a blob still kept.
+    const uint32_t h = ackTick % kNetHistory;
+    if (hasAck && (!slot.acked || ackTick > slot.ackTick) && server.historyTick[h] == ackTick &&
+        !server.history[h].empty()) {
+        slot.ackTick = ackTick;
+        slot.acked = true;
+    }
+    // The client resends everything the server has not applied, so a gap
+    // before firstSeq means those inputs fell out of its window for good.
+    if (firstSeq > slot.appliedSeq + 1) {
+        slot.appliedSeq = firstSeq - 1;
+        slot.receivedSeq = std::max(slot.receivedSeq, slot.appliedSeq);
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t seq = firstSeq + i;
+        if (seq > slot.appliedSeq) {
+            slot.inputs[seq % kNetInputWindow] = r.at[i];
+            slot.receivedSeq = std::max(slot.receivedSeq, seq);
+        }
+    }
+}
+
+static void ReadServerPackets(NetServer& server, double now) {
+    NetAddress from;
+    int size;
+    while ((size = ReceivePacket(server.socket, from, server.receiveBuffer, sizeof(server.receiveBuffer))) >= 0) {
+        NetReader r{ server.receiveBuffer, server.receiveBuffer + size, true };
+        const uint8_t type = ReadHeader(r);
+        if (type == PacketJoin) {
+            HandleJoin(server, from, r, now);
+            continue;
+        }
+        NetClientSlot* slot = FindSlot(server, from);
+        if (!slot) {
+            continue;
+        }
+        slot->lastHeardSeconds = now;
+        slot->traffic.bytesReceived += static_cast<uint64_t>(size);
+        ++slot->traffic.packetsReceived;
+        if (type == PacketInput) {
+            HandleInput(server, *slot, r);
+        } else if (type == PacketLeave) {
+            slot->connected = false;
+        }
+    }
+}
+
+static void SendSnapshots(NetServer& server) {
+    const uint32_t h = server.tick % kNetHistory;
+    std::vector<uint8_t>& blob = server.history[h];
+    QuantizeWorld(server.world, server.impactLog, blob);
+    server.historyTick[h] = server.tick;
+
+    for (NetClientSlot& slot : server.clients) {
+        if (!slot.connected) {
+            continue;
+        }
+        const uint32_t b = slot.ackTick % kNetHistory;
+        const bool hasBase = slot.acked && server.tick - slot.ackTick < kNetHistory &&
+                             server.historyTick[b] == slot.ackTick;
+        PutHeader(server.packet, PacketSnapshot);
+        PutU32(server.packet, server.tick);
+        PutU8(server.packet, hasBase ? 1 : 0);
+        PutU32(server.packet, hasBase ? slot.ackTick : 0);
+        PutU32(server.packet, slot.appliedSeq);
+        const size_t header = server.packet.size();
+        if (hasBase) {
+            EncodeDelta(server.history[b].data(), server.history[b].size(), blob.data(), blob.size(), server.packet);
+        } else {
+            EncodeDelta(nullptr, 0, blob.data(), blob.size(), server.packet);
+        }
+        slot.snapshotBytes += server.packet.size() - header;
+        ++slot.snapshots;
+        Send(server.socket, slot.traffic, slot.address, server.packet);
+    }
+}
+
+void ServerTick(NetServer& server, double nowSeconds) {
+    ReadServerPackets(server, nowSeconds);
+
+    for (size_t i = 0; i < server.clients.size(); ++i) {
+        NetClientSlot& slot = server.clients[i];
+        if (slot.connected && nowSeconds - slot.lastHeardSeconds > server.timeoutSeconds) {
+            slot.connected = false;
+        }
+        if (!slot.connected) {
+            server.stepInputs[i] = SimInput{};
+            continue;
+        }
+        if (slot.receivedSeq - slot.appliedSeq > kMaxInputBacklog) {
+            slot.appliedSeq = slot.receivedSeq - kMaxInputBacklog;
+        }
+        // Starved: hold the last input, which is what the player most
+        // likely still has pressed.
+        if (slot.receivedSeq > slot.appliedSeq) {
+            ++slot.appliedSeq;
+            slot.lastInput = UnpackInput(slot.inputs[slot.appliedSeq % kNetInputWindow]);
+        }
+        server.stepInputs[i] = slot.lastInput;
+    }
+
+    const double t0 = NowSeconds();
+    StepWorld(server.world, 1.f / server.world.cfg.tickRateHz, server.stepInputs.data(), server.stepInputs.size());
+    LogImpacts(server.impactLog, server.world, server.tick);
+    ++server.tick;
+    ++server.steps;
+    const double t1 = NowSeconds();
+    server.stepSeconds += t1 - t0;
+
+    if (server.snapshotInterval > 0 && server.tick % static_cast<uint32_t>(server.snapshotInterval) == 0) {
+        SendSnapshots(server);
+        server.snapshotSeconds += NowSeconds() - t1;
+    }
+}
+
+bool StartNetClient(NetClient& client, const NetAddress& server) {
+    if (!OpenUdpSocket(client.socket, 0, false)) {
+        return false;
+    }
+    client.server = server;
+    client.joined = client.rejected = false;
+    client.lastJoinSeconds = -1.0;
+    client.tank = -1;
+    client.seq = client.ackedSeq = 0;
+    client.haveState = false;
+    client.stateTick = 0;
+    for (uint32_t i = 0; i < kNetHistory; ++i) {
+        client.history[i].clear();
+        client.history[i].reserve(kNetMaxStateBytes);
+        client.historyTick[i] = 0;
+    }
+    client.packet.reserve(kNetMaxPacket);
+    client.decoded.reserve(kNetMaxStateBytes);
+    // As many of each as a snapshot can hold, so decoding never grows them.
+    const size_t projectiles = kNetMaxStateBytes / kProjectileBytes;
+    client.state.shellPrev.reserve(projectiles);
+    client.state.shellPos.reserve(projectiles);
+    client.state.bombPrev.reserve(projectiles);
+    client.state.bombPos.reserve(projectiles);
+    client.state.helicopters.reserve(kNetMaxStateBytes / kHelicopterBytes);
+    client.state.tanks.reserve(kNetMaxStateBytes / kTankBytes);
+    return true;
+}
+
+void StopNetClient(NetClient& client) {
+    if (client.joined && client.socket.handle != -1) {
+        // Frees the tank at once instead of after the server's timeout.
+        // Sent without the loss simulation; it is only a courtesy.
+        const float loss = client.socket.lossRate;
+        client.socket.lossRate = 0.f;
+        PutHeader(client.packet, PacketLeave);
+        Send(client.socket, client.traffic, client.server, client.packet);
+        client.socket.lossRate = loss;
+    }
+    CloseUdpSocket(client.socket);
+    client.joined = false;
+}
+
+static void HandleWelcome(NetClient& client, NetReader& r) {
+    const uint32_t tank = GetU8(r);
+    if (!r.ok || client.joined || static_cast<size_t>(r.end - r.at) != sizeof(SimConfig)) {
+        return;
+    }
+    // The client steps its turret at the server's rate and within its
+    // limits; a Welcome it cannot run with is ignored like a malformed one.
+    SimConfig cfg;
+    std::memcpy(&cfg, r.at, sizeof(SimConfig));
+    if (!ValidSimConfig(cfg) || static_cast<int>(tank) >= cfg.tankCount) {
+        return;
+    }
+    client.cfg = cfg;
+    client.joined = true;
+    client.tank = static_cast<int>(tank);
+    client.turretDeg = client.prevTurretDeg = client.cfg.turretStartAngleDeg;
+}
+
+// Restarts the predicted turret from the server's angle after input
+// `appliedSeq` and replays the inputs sent since.
+static void Reconcile(NetClient& client, uint32_t appliedSeq) {
+    if (client.tank < 0 || static_cast<size_t>(client.tank) >= client.state.tanks.size() || appliedSeq > client.seq) {
+        return;
+    }
+    client.ackedSeq = std::max(client.ackedSeq, appliedSeq);
+    const float serverDeg = client.state.tanks[static_cast<size_t>(client.tank)].turretAngleDeg;
+    if (client.seq - appliedSeq >= kNetInputWindow) {
+        client.turretDeg = serverDeg;
+        return;
+    }
+    if (appliedSeq > 0) {
+        const float error = std::fabs(client.predictedDeg[appliedSeq % kNetInputWindow] - serverDeg);
+        if (error > kMispredictionDeg) {
+            ++client.mispredictions;
+            client.worstMispredictionDeg = std::max(client.worstMispredictionDeg, error);
+        }
+    }
+    const float dt = 1.f / client.cfg.tickRateHz;
+    float angle = serverDeg;
+    for (uint32_t s = appliedSeq + 1; s <= client.seq; ++s) {
+        angle = TurnTurret(client.cfg, angle, UnpackInput(client.inputs[s % kNetInputWindow]), dt);
+        client.predictedDeg[s % kNetInputWindow] = angle;
+    }
+    client.turretDeg = angle;
+}
+
+static void HandleSnapshot(NetClient& client, NetReader& r) {
+    const uint32_t tick = GetU32(r);
+    const bool hasBase = GetU8(r) != 0;
+    const uint32_t baseTick = GetU32(r);
+    const uint32_t appliedSeq = GetU32(r);
+    if (!r.ok || !client.joined || (client.haveState && tick <= client.stateTick)) {
+        return;
+    }
+    const std::vector<uint8_t>* base = nullptr;
+    if (hasBase) {
+        base = &client.history[baseTick % kNetHistory];
+        if (client.historyTick[baseTick % kNetHistory] != baseTick || base->empty()) {
+            return;
+        }
+    }
+    if (!DecodeDelta(base ? base->data() : nullptr, base ? base->size() : 0, r.at, static_cast<size_t>(r.end - r.at),
+                     kNetMaxStateBytes, client.decoded) ||
+        !DequantizeState(client.decoded.data(), client.decoded.size(), client.cfg, client.state)) {
+        return;
+    }
+    client.history[tick % kNetHistory] = client.decoded;
+    client.historyTick[tick % kNetHistory] = tick;
+    client.haveState = true;
+    client.stateTick = tick;
+    client.state.tick = tick;
+    ++client.snapshots;
+    Reconcile(client, appliedSeq);
+}
+
+static void SendInputs(NetClient& client) {
+    // Everything the server has not applied yet, up to the window.
+    const uint32_t first = std::max(client.ackedSeq + 1, client.seq + 1 - std::min(client.seq, kNetInputWindow));
+    PutHeader(client.packet, PacketInput);
+    PutU8(client.packet, client.haveState ? 1 : 0);
+    PutU32(client.packet, client.stateTick);
+    PutU32(client.packet, first);
+    PutU8(client.packet, client.seq + 1 - first);
+    for (uint32_t s = first; s <= client.seq; ++s) {
+        PutU8(client.packet, client.inputs[s % kNetInputWindow]);
+    }
+    Send(client.socket, client.traffic, client.server, client.packet);
+}
+
+void ClientTick(NetClient& client, const SimInput& input, double nowSeconds) {
+    if (!client.joined && !client.rejected &&
+        (client.lastJoinSeconds < 0.0 || nowSeconds - client.lastJoinSeconds >= kJoinRetrySeconds)) {
+        PutHeader(client.packet, PacketJoin);
+        PutU32(client.packet, kNetVersion);
+        Send(client.socket, client.traffic, client.server, client.packet);
+        client.lastJoinSeconds = nowSeconds;
+    }
+
+    NetAddress from;
+    int size;
+    while ((size = ReceivePacket(client.socket, from, client.receiveBuffer, sizeof(client.receiveBuffer))) >= 0) {
+        if (!SameAddress(from, client.server)) {
+            continue;
+        }
+        client.traffic.bytesReceived += static_cast<uint64_t>(size);
+        ++client.traffic.packetsReceived;
+        NetReader r{ client.receiveBuffer, client.receiveBuffer + size, true };
+        const uint8_t type = ReadHeader(r);
+        if (type == PacketWelcome) {
+            HandleWelcome(client, r);
+        } else if (type == PacketFull) {
+            client.rejected = !client.joined;
+        } else if (type == PacketSnapshot) {
+            HandleSnapshot(client, r);
+        }
+    }
+
+    if (!client.joined) {
+        return;
+    }
+    ++client.seq;
+    client.inputs[client.seq % kNetInputWindow] = PackInput(input);
+    client.prevTurretDeg = client.turretDeg;
+    client.turretDeg = TurnTurret(client.cfg, client.turretDeg, input, 1.f / client.cfg.tickRateHz);
+    client.predictedDeg[client.seq % kNetInputWindow] = client.turretDeg;
+    SendInputs(client);
+}
+
+const RenderState& ClientRenderState(NetClient& client) {
+    RenderState& state = client.state;
+    if (client.tank >= 0 && static_cast<size_t>(client.tank) < state.tanks.size()) {
+        state.localTank = client.tank;
+        state.tanks[static_cast<size_t>(client.tank)].turretAngleDeg = client.turretDeg;
+        state.tanks[static_cast<size_t>(client.tank)].prevTurretAngleDeg = client.prevTurretDeg;
+    }
+    return state;
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+// Co-op over UDP. The server owns the World and runs it with one tank per
+// client (SimConfig::tankCount); clients only send their input and draw
+// what the server sends back.
+//
+// Upstream, every client step sends an Input packet carrying the inputs
+// the server has not acknowledged yet, so a lost packet is covered by the
+// next one. The server applies one input per client per step.
+//
+// Downstream, every snapshotInterval steps the server quantizes the world
+// (1/8 px positions, 1/100 degree turret angles, the last few hits) into a
+// fixed-layout byte blob and sends each client that blob delta-coded
+// (delta.h) against the last one the client acknowledged. The server keeps
+// the blobs it sent for a while and the client keeps the ones it received,
+// so both sides have the baseline. A client that has acknowledged nothing
+// yet gets the blob coded against zeros.
+//
+// Clients predict their own turret: each input is applied locally at once
+// with the same TurnTurret as the server, and when a snapshot says which
+// input the server got to, the turret restarts from the server's angle and
+// replays the inputs after it.
+//
+// Packets are little-endian except the SimConfig in Welcome, which is sent
+// as the host lays it out; client and server must be the same build.
+
+#include "render_state.h"
+#include "rng.h"
+#include "sim.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const uint16_t kNetDefaultPort = 27600;
+// Snapshots are kept under a common path MTU; projectiles past what fits
+// are left out of the snapshot (not the simulation).
+const size_t kNetMaxPacket = 1200;
+const size_t kNetMaxStateBytes = 1100;
+// Snapshots kept as delta baselines, and inputs kept for resending and
+// prediction. Both are powers of two.
+const uint32_t kNetHistory = 64;
+const uint32_t kNetInputWindow = 32;
+// Hits carried in every snapshot, so a client that missed some still sees
+// them.
+const size_t kNetImpacts = 8;
+
+// IPv4 address and port in host byte order.
+struct NetAddress {
+    uint32_t ip = 0;
+    uint16_t port = 0;
+};
+
+struct NetSocket {
+    intptr_t handle = -1;
+    // Drops this fraction of outgoing packets, for testing over loopback.
+    float lossRate = 0.f;
+    Pcg32 lossRng;
+};
+
+// Winsock setup on Windows; nothing elsewhere.
+bool NetStartup();
+void NetShutdown();
+
+// Non-blocking UDP socket bound to `port` (0 picks one) on every interface,
+// or only on 127.0.0.1 when `loopbackOnly`.
+bool OpenUdpSocket(NetSocket& sock, uint16_t port, bool loopbackOnly);
+void CloseUdpSocket(NetSocket& sock);
+// The port the socket ended up bound to.
+uint16_t LocalPort(const NetSocket& sock);
+bool SendPacket(NetSocket& sock, const NetAddress& to, const uint8_t* data, size_t size);
+// Size of the packet read, or -1 when none is waiting.
+int ReceivePacket(NetSocket& sock, NetAddress& from, uint8_t* buffer, size_t capacity);
+// "a.b.c.d:port" or "localhost:port"; the port is optional.
+bool ParseNetAddress(const char* text, NetAddress& out);
+
+// Traffic counters, in payload bytes (no UDP/IP headers).
+struct NetTraffic {
+    uint64_t bytesSent = 0;
+    uint64_t bytesReceived = 0;
+    uint64_t packetsSent = 0;
+    uint64_t packetsReceived = 0;
+};
+
+struct NetClientSlot {
+    bool connected = false;
+    NetAddress address;
+    double lastHeardSeconds = 0.0;
+    // Inputs by sequence number, mod kNetInputWindow. received is the
+    // newest that arrived, applied the newest the server stepped with.
+    uint8_t inputs[kNetInputWindow] = {};
+    uint32_t receivedSeq = 0;
+    uint32_t appliedSeq = 0;
+    SimInput lastInput;
+    // Newest snapshot tick the client confirmed; its baseline.
+    uint32_t ackTick = 0;
+    bool acked = false;
+    NetTraffic traffic;
+    uint64_t snapshotBytes = 0;
+    uint64_t snapshots = 0;
+};
+
+struct NetServer {
+    NetSocket socket;
+    World world;
+    uint32_t tick = 0;
+    int snapshotInterval = 2;
+    // Seconds without a packet before a client's tank is freed.
+    double timeoutSeconds = 5.0;
+    // One slot per tank.
+    std::vector<NetClientSlot> clients;
+    std::vector<SimInput> stepInputs;
+    ImpactLog impactLog;
+    // Blobs sent, by tick mod kNetHistory.
+    std::vector<uint8_t> history[kNetHistory];
+    uint32_t historyTick[kNetHistory] = {};
+    std::vector<uint8_t> packet;
+    uint8_t receiveBuffer[kNetMaxPacket];
+
+    // Time spent in StepWorld and in building and sending snapshots.
+    double stepSeconds = 0.0;
+    double snapshotSeconds = 0.0;
+    uint64_t steps = 0;
+};
+
+// Binds `port` and starts a world for cfg.tankCount players.
+bool StartNetServer(NetServer& server, const SimConfig& cfg, uint32_t seed, uint16_t port, bool loopbackOnly);
+void StopNetServer(NetServer& server);
+// Reads every waiting packet, steps the world once with each client's next
+// input and sends snapshots when one is due. `nowSeconds` is only used for
+// timeouts.
+void ServerTick(NetServer& server, double nowSeconds);
+int ConnectedClients(const NetServer& server);
+
+struct NetClient {
+    NetSocket socket;
+    NetAddress server;
+    bool joined = false;
+    bool rejected = false;
+    double lastJoinSeconds = -1.0;
+    int tank = -1;
+    SimConfig cfg;
+
+    // Inputs sent, by sequence number mod kNetInputWindow. seq is the
+    // newest; ackedSeq the newest the server has stepped with.
+    uint8_t inputs[kNetInputWindow] = {};
+    uint32_t seq = 0;
+    uint32_t ackedSeq = 0;
+    // The predicted angle of the local turret after each input, by
+    // sequence, to measure how often prediction was wrong.
+    float predictedDeg[kNetInputWindow] = {};
+    float turretDeg = 0.f;
+    float prevTurretDeg = 0.f;
+
+    // Blobs received, by tick mod kNetHistory, and the newest one decoded.
+    std::vector<uint8_t> history[kNetHistory];
+    uint32_t historyTick[kNetHistory] = {};
+    bool haveState = false;
+    uint32_t stateTick = 0;
+    // The newest snapshot as the scene draws it. Helicopters keep their
+    // previous snapshot position for interpolation.
+    RenderState state;
+
+    std::vector<uint8_t> packet;
+    std::vector<uint8_t> decoded;
+    uint8_t receiveBuffer[kNetMaxPacket];
+    NetTraffic traffic;
+    uint64_t snapshots = 0;
+    uint64_t mispredictions = 0;
+    float worstMispredictionDeg = 0.f;
+};
+
+bool StartNetClient(NetClient& client, const NetAddress& server);
+void StopNetClient(NetClient& client);
+// Joins if not joined yet, reads every waiting packet, then applies `input`
+// to the predicted turret and sends it. Call once per simulation step.
+void ClientTick(NetClient& client, const SimInput& input, double nowSeconds);
+// The newest snapshot with the local turret at its predicted angle.
+const RenderState& ClientRenderState(NetClient& client);
+
+// The quantized world the server sends. Exposed for tests and tools.
+void QuantizeWorld(const World& world, const ImpactLog& impacts, std::vector<uint8_t>& out);
+bool DequantizeState(const uint8_t* data, size_t size, const SimConfig& cfg, RenderState& state);
@@ -0,0 +1,275 @@
+#include "particles.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Motion and color shared by every particle of a kind.
+struct ParticleLook {
+    // Pixels per second squared, down.
+    float gravity;
+    // Fraction of the velocity lost per second.
+    float drag;
+    // Radius change in pixels per second.
+    float growth;
+    uint32_t color;
+};
+
+static const ParticleLook kLooks[kParticleKinds] = {
+    // Debris: hot fragments that arc down and shrink.
+    { 520.f, 0.8f, -1.2f, Argb(255, 255, 150, 60) },
+    // Smoke: rises, slows and spreads. Many small puffs rather than a few
+    // big ones, since drawing cost goes with covered area.
+    { -40.f, 1.5f, 2.f, Argb(255, 70, 70, 76) },
+    // Flash: a short bright disc that swells.
+    { 0.f, 0.f, 90.f, Argb(255, 255, 235, 190) },
+};
+
+static void InitPool(ParticlePool& p, size_t capacity) {
+    p.x.assign(capacity, 0.f);
+    p.y.assign(capacity, 0.f);
+    p.vx.assign(capacity, 0.f);
+    p.vy.assign(capacity, 0.f);
+    p.size.assign(capacity, 0.f);
+    p.age.assign(capacity, 0.f);
+    p.ageRate.assign(capacity, 0.f);
+    p.count = 0;
+    p.capacity = capacity;
+}
+
+void InitParticleSystem(ParticleSystem& ps, size_t capacityPerKind, size_t maxEmitters) {
+    for (ParticlePool& pool : ps.pools) {
+        InitPool(pool, capacityPerKind);
+    }
+    InitPool(ps.scratch, capacityPerKind);
+    ps.emitters.assign(maxEmitters, ParticleEmitter{});
+    ps.emitterCount = 0;
+}
+
+void ClearParticles(ParticleSystem& ps) {
+    for (ParticlePool& pool : ps.pools) {
+        pool.count = 0;
+    }
+    ps.emitterCount = 0;
+}
+
+static void SpawnParticle(ParticlePool& p, float x, float y, float vx, float vy, float size, float lifeSeconds) {
+    if (p.count == p.capacity) {
+        return;
+    }
+    const size_t i = p.count++;
+    p.x[i] = x;
+    p.y[i] = y;
+    p.vx[i] = vx;
+    p.vy[i] = vy;
+    p.size[i] = size;
+    p.age[i] = 0.f;
+    p.ageRate[i] = 1.f / lifeSeconds;
+}
+
+void EmitBurst(ParticleSystem& ps, ParticleKind kind, float x, float y, int count) {
+    ParticlePool& pool = ps.pools[kind];
+    Pcg32& rng = ps.rng;
+    for (int n = 0; n < count && pool.count < pool.capacity; ++n) {
+        const float angle = UniformFloat(rng, 0.f, 6.2831853f);
+        const float dirX = std::cos(angle);
+        const float dirY = std::sin(angle);
+        switch (kind) {
+        case ParticleDebris: {
+            const float speed = UniformFloat(rng, 60.f, 280.f);
+            SpawnParticle(pool, x, y, dirX * speed, dirY * speed - 80.f, UniformFloat(rng, 1.5f, 3.f), UniformFloat(rng, 0.5f, 1.1f));
+            break;
+        }
+        case ParticleSmoke: {
+            const float speed = UniformFloat(rng, 5.f, 30.f);
+            SpawnParticle(pool, x, y, dirX * speed, dirY * speed - 20.f, UniformFloat(rng, 1.5f, 3.f), UniformFloat(rng, 0.8f, 1.4f));
+            break;
+        }
+        default:
+            SpawnParticle(pool, x + dirX * 4.f, y + dirY * 4.f, 0.f, 0.f, UniformFloat(rng, 8.f, 14.f), UniformFloat(rng, 0.08f, 0.15f));
+            break;
+        }
+    }
+}
+
+static void StartEmitter(ParticleSystem& ps, ParticleKind kind, float x, float y, float perSecond, float seconds) {
+    if (ps.emitterCount == ps.emitters.size()) {
+        return;
+    }
+    ParticleEmitter& e = ps.emitters[ps.emitterCount++];
+    e.kind = kind;
+    e.x = x;
+    e.y = y;
+    e.perSecond = perSecond;
+    e.secondsLeft = seconds;
+    e.carry = 0.f;
+}
+
+void EmitImpact(ParticleSystem& ps, const Impact& impact) {
+    const bool tank = impact.kind == ImpactBombTank;
+    EmitBurst(ps, ParticleDebris, impact.x, impact.y, tank ? 64 : 48);
+    EmitBurst(ps, ParticleFlash, impact.x, impact.y, tank ? 4 : 3);
+    StartEmitter(ps, ParticleSmoke, impact.x, impact.y, tank ? 90.f : 70.f, tank ? 1.f : 0.6f);
+}
+
+void EmitNewImpacts(ParticleSystem& ps, const ImpactLog& events, uint64_t& nextTick) {
+    for (size_t i = 0; i < events.count; ++i) {
+        const ImpactEvent& e = ImpactAt(events, i);
+        if (e.tick >= nextTick) {
+            EmitImpact(ps, e.impact);
+        }
+    }
+    if (events.count > 0) {
+        nextTick = std::max(nextTick, ImpactAt(events, events.count - 1).tick + 1);
+    }
+}
+
+static void RunEmitters(ParticleSystem& ps, float dt) {
+    size_t i = 0;
+    while (i < ps.emitterCount) {
+        ParticleEmitter& e = ps.emitters[i];
+        e.carry += e.perSecond * dt;
+        const int n = static_cast<int>(e.carry);
+        e.carry -= static_cast<float>(n);
+        EmitBurst(ps, e.kind, e.x, e.y, n);
+        e.secondsLeft -= dt;
+        if (e.secondsLeft <= 0.f) {
+            e = ps.emitters[--ps.emitterCount];
+        } else {
+            ++i;
+        }
+    }
+}
+
+static void IntegrateRange(ParticlePool& p, size_t i, size_t n, const ParticleLook& look, float dt) {
+    const float damp = std::max(0.f, 1.f - look.drag * dt);
+    const float gdt = look.gravity * dt;
+    const float grow = look.growth * dt;
+    for (; i < n; ++i) {
+        p.vx[i] *= damp;
+        p.vy[i] = p.vy[i] * damp + gdt;
+        p.x[i] += p.vx[i] * dt;
+        p.y[i] += p.vy[i] * dt;
+        p.size[i] = std::max(p.size[i] + grow, 0.f);
+        p.age[i] += p.ageRate[i] * dt;
+    }
+}
+
+// Same arithmetic as IntegrateRange, so every kernel gives the same result.
+static void IntegratePool(ParticlePool& p, const ParticleLook& look, float dt) {
+    const size_t n = p.count;
+    size_t i = 0;
+
+#if defined(CGAME_SIMD_AVX2)
+    const __m256 damp = _mm256_set1_ps(std::max(0.f, 1.f - look.drag * dt));
+    const __m256 gdt = _mm256_set1_ps(look.gravity * dt);
+    const __m256 grow = _mm256_set1_ps(look.growth * dt);
+    const __m256 vdt = _mm256_set1_ps(dt);
+    const __m256 zero = _mm256_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+        const __m256 vx = _mm256_mul_ps(_mm256_loadu_ps(&p.vx[i]), damp);
+        const __m256 vy = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&p.vy[i]), damp), gdt);
+        _mm256_storeu_ps(&p.vx[i], vx);
+        _mm256_storeu_ps(&p.vy[i], vy);
+        _mm256_storeu_ps(&p.x[i], _mm256_add_ps(_mm256_loadu_ps(&p.x[i]), _mm256_mul_ps(vx, vdt)));
+        _mm256_storeu_ps(&p.y[i], _mm256_add_ps(_mm256_loadu_ps(&p.y[i]), _mm256_mul_ps(vy, vdt)));
+        _mm256_storeu_ps(&p.size[i], _mm256_max_ps(_mm256_add_ps(_mm256_loadu_ps(&p.size[i]), grow), zero));
+        _mm256_storeu_ps(&p.age[i], _mm256_add_ps(_mm256_loadu_ps(&p.age[i]), _mm256_mul_ps(_mm256_loadu_ps(&p.ageRate[i]), vdt)));
+    }
+#elif defined(CGAME_SIMD_SSE2)
+    const __m128 damp = _mm_set1_ps(std::max(0.f, 1.f - look.drag * dt));
+    const __m128 gdt = _mm_set1_ps(look.gravity * dt);
+    const __m128 grow = _mm_set1_ps(look.growth * dt);
+    const __m128 vdt = _mm_set1_ps(dt);
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        const __m128 vx = _mm_mul_ps(_mm_loadu_ps(&p.vx[i]), damp);
+        const __m128 vy = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&p.vy[i]), damp), gdt);
+        _mm_storeu_ps(&p.vx[i], vx);
+        _mm_storeu_ps(&p.vy[i], vy);
+        _mm_storeu_ps(&p.x[i], _mm_add_ps(_mm_loadu_ps(&p.x[i]), _mm_mul_ps(vx, vdt)));
+        _mm_storeu_ps(&p.y[i], _mm_add_ps(_mm_loadu_ps(&p.y[i]), _mm_mul_ps(vy, vdt)));
+        _mm_storeu_ps(&p.size[i], _mm_max_ps(_mm_add_ps(_mm_loadu_ps(&p.size[i]), grow), zero));
+        _mm_storeu_ps(&p.age[i], _mm_add_ps(_mm_loadu_ps(&p.age[i]), _mm_mul_ps(_mm_loadu_ps(&p.ageRate[i]), vdt)));
+    }
+#endif
+
+    IntegrateRange(p, i, n, look, dt);
+}
+
+static int BandOf(float y) {
+    const int band = static_cast<int>(y) / kParticleBandHeight;
+    return std::min(std::max(band, 0), kParticleBands - 1);
+}
+
+// Drops the particles that lived out their lifetime and counting-sorts the
+// rest by band into the scratch pool, which then becomes the live one.
+static void SortPool(ParticlePool& p, ParticlePool& scratch, uint32_t* bandStart) {
+    std::fill(bandStart, bandStart + kParticleBands + 1, 0u);
+    for (size_t i = 0; i < p.count; ++i) {
+        if (p.age[i] < 1.f) {
+            ++bandStart[BandOf(p.y[i]) + 1];
+        }
+    }
+    for (int b = 0; b < kParticleBands; ++b) {
+        bandStart[b + 1] += bandStart[b];
+    }
+    const size_t live = bandStart[kParticleBands];
+    for (size_t i = 0; i < p.count; ++i) {
+        if (p.age[i] >= 1.f) {
+            continue;
+        }
+        const uint32_t j = bandStart[BandOf(p.y[i])]++;
+        scratch.x[j] = p.x[i];
+        scratch.y[j] = p.y[i];
+        scratch.vx[j] = p.vx[i];
+        scratch.vy[j] = p.vy[i];
+        scratch.size[j] = p.size[i];
+        scratch.age[j] = p.age[i];
+        scratch.ageRate[j] = p.ageRate[i];
+    }
+    scratch.count = live;
+    std::swap(p, scratch);
+}
+
+void UpdateParticles(ParticleSystem& ps, float dt) {
+    RunEmitters(ps, dt);
+    for (int k = 0; k < kParticleKinds; ++k) {
+        IntegratePool(ps.pools[k], kLooks[k], dt);
+        SortPool(ps.pools[k], ps.scratch, ps.bandStart);
+    }
+}
+
+size_t LiveParticles(const ParticleSystem& ps) {
+    size_t n = 0;
+    for (const ParticlePool& pool : ps.pools) {
+        n += pool.count;
+    }
+    return n;
+}
+
+IRect ParticleBounds(const ParticlePool& pool, size_t i) {
+    IRect b;
+    b.x = static_cast<int>(std::floor(pool.x[i] - pool.size[i])) - 1;
+    b.y = static_cast<int>(std::floor(pool.y[i] - pool.size[i])) - 1;
+    b.w = static_cast<int>(std::ceil(pool.x[i] + pool.size[i])) + 1 - b.x;
+    b.h = static_cast<int>(std::ceil(pool.y[i] + pool.size[i])) + 1 - b.y;
+    return b;
+}
+
+void DrawParticles(Renderer& r, const ParticleSystem& ps) {
+    for (int kind = 0; kind < kParticleKinds; ++kind) {
+        const ParticlePool& pool = ps.pools[kind];
+        if (pool.count == 0) {
+            continue;
+        }
+        ParticleBatch batch;
+        batch.x = pool.x.data();
+        batch.y = pool.y.data();
+        batch.size = pool.size.data();
+        batch.age = pool.age.data();
+        batch.count = pool.count;
+        batch.color = kLooks[kind].color;
+        r.DrawParticlesAdditive(batch);
+    }
+}
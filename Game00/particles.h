@@ -0,0 +1,99 @@
+#pragma once
+
+// CPU particle effects for hits: debris, smoke and a flash.
+//
+// Particles are visual only and never feed back into the simulation, so they
+// run on the render side at the frame rate and may use their own random
+// stream. Each kind has its own structure-of-arrays pool, so the motion
+// constants are uniform across a pool and one SIMD kernel (simd.h) updates
+// it four or eight particles at a time. Pools and the emitter pool are sized
+// once by InitParticleSystem; spawns past capacity are dropped, so nothing
+// is allocated per particle.
+//
+// Each kind is drawn as one additive batch (Renderer::DrawParticlesAdditive).
+// Drawing is bound by scattered framebuffer writes rather than arithmetic,
+// so every update also sorts each pool by 32 px horizontal band while it
+// drops the dead particles: consecutive particles then land on rows that
+// are already in cache. Saturating adds give the same pixels in any order.
+
+#include "render.h"
+#include "render_state.h"
+#include "rng.h"
+
+#include <cstddef>
+#include <vector>
+
+enum ParticleKind {
+    ParticleDebris,
+    ParticleSmoke,
+    ParticleFlash,
+    kParticleKinds,
+};
+
+struct ParticlePool {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> vx;
+    std::vector<float> vy;
+    // Disc radius in pixels.
+    std::vector<float> size;
+    // Fraction of the lifetime used up, 0 to 1, and how fast it grows
+    // (1 / lifetime in seconds). The particle dies at 1.
+    std::vector<float> age;
+    std::vector<float> ageRate;
+    size_t count = 0;
+    size_t capacity = 0;
+};
+
+// Keeps spawning particles of one kind at a fixed point for a while, e.g.
+// the smoke that rises after an explosion.
+struct ParticleEmitter {
+    ParticleKind kind = ParticleSmoke;
+    float x = 0.f;
+    float y = 0.f;
+    float perSecond = 0.f;
+    float secondsLeft = 0.f;
+    // Fractional particle carried over to the next update.
+    float carry = 0.f;
+};
+
+const int kParticleBandHeight = 32;
+// Particles below the last band are sorted into it.
+const int kParticleBands = 64;
+
+struct ParticleSystem {
+    ParticlePool pools[kParticleKinds];
+    // Sort target, swapped with each pool in turn.
+    ParticlePool scratch;
+    uint32_t bandStart[kParticleBands + 1] = {};
+    // Live emitters are [0, emitterCount); the rest are spare slots.
+    std::vector<ParticleEmitter> emitters;
+    size_t emitterCount = 0;
+    Pcg32 rng;
+};
+
+// Sizes every pool for `capacityPerKind` particles and the emitter pool for
+// `maxEmitters`.
+void InitParticleSystem(ParticleSystem& ps, size_t capacityPerKind, size_t maxEmitters);
+void ClearParticles(ParticleSystem& ps);
+
+// `count` particles of one kind thrown out from (x, y).
+void EmitBurst(ParticleSystem& ps, ParticleKind kind, float x, float y, int count);
+// Debris, a flash and a smoke emitter at the hit, scaled by its kind.
+void EmitImpact(ParticleSystem& ps, const Impact& impact);
+// Emits every impact in `events` from step `nextTick` on and advances
+// nextTick past them, so a state seen twice or a skipped state neither
+// repeats nor loses a hit.
+void EmitNewImpacts(ParticleSystem& ps, const ImpactLog& events, uint64_t& nextTick);
+
+// Runs the emitters, moves every particle, removes the ones that died and
+// sorts the rest by band.
+void UpdateParticles(ParticleSystem& ps, float dt);
+
+size_t LiveParticles(const ParticleSystem& ps);
+
+// Pixel bounds of particle i of the pool, for dirty-rectangle tracking.
+IRect ParticleBounds(const ParticlePool& pool, size_t i);
+
+// One additive batch per kind.
+void DrawParticles(Renderer& r, const ParticleSystem& ps);
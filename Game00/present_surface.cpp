@@ -0,0 +1,124 @@
+#ifndef NOMINMAX
+#  define NOMINMAX
+#endif
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include "present_surface.h"
+
+static void ReleaseBackBuffer(PresentSurface& s) {
+    if (s.memDC && s.oldBitmap) {
+        SelectObject(s.memDC, s.oldBitmap);
+        s.oldBitmap = nullptr;
+    }
+    if (s.dib) {
+        DeleteObject(s.dib);
+        s.dib = nullptr;
+    }
+    s.bits = nullptr;
+}
+
+static bool AllocBackBuffer(PresentSurface& s, int width, int height) {
+    BITMAPINFO bmi{};
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = width;
+    bmi.bmiHeader.biHeight = -height; // top-down
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    void* bits = nullptr;
+    HBITMAP dib = CreateDIBSection(s.windowDC, &bmi, DIB_RGB_COLORS, &bits, nullptr, 0);
+    if (!dib) {
+        return false;
+    }
+    s.dib = dib;
+    s.bits = bits;
+    s.oldBitmap = SelectObject(s.memDC, dib);
+    s.width = width;
+    s.height = height;
+    return true;
+}
+
+bool CreatePresentSurface(PresentSurface& s, HWND wnd, COLORREF background) {
+    s.wnd = wnd;
+    s.windowDC = GetDC(wnd);
+    s.memDC = CreateCompatibleDC(s.windowDC);
+    s.background = CreateSolidBrush(background);
+    if (!s.windowDC || !s.memDC || !s.background) {
+        DestroyPresentSurface(s);
+        return false;
+    }
+
+    RECT rc{};
+    GetClientRect(wnd, &rc);
+    if (!AllocBackBuffer(s, rc.right > 0 ? rc.right : 1, rc.bottom > 0 ? rc.bottom : 1)) {
+        DestroyPresentSurface(s);
+        return false;
+    }
+
+    SetWindowLongPtr(wnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(&s));
+    return true;
+}
+
+void DestroyPresentSurface(PresentSurface& s) {
+    if (s.wnd && IsWindow(s.wnd)) {
+        SetWindowLongPtr(s.wnd, GWLP_USERDATA, 0);
+    }
+    ReleaseBackBuffer(s);
+    if (s.memDC) {
+        DeleteDC(s.memDC);
+        s.memDC = nullptr;
+    }
+    if (s.background) {
+        DeleteObject(s.background);
+        s.background = nullptr;
+    }
+    if (s.windowDC) {
+        ReleaseDC(s.wnd, s.windowDC);
+        s.windowDC = nullptr;
+    }
+    s.width = 0;
+    s.height = 0;
+}
+
+void ResizePresentSurface(PresentSurface& s, int width, int height) {
+    if (!s.memDC || width <= 0 || height <= 0) {
+        return;
+    }
+    if (width == s.width && height == s.height) {
+        return;
+    }
+    ReleaseBackBuffer(s);
+    AllocBackBuffer(s, width, height);
+}
+
+void HandlePresentSurfaceMessage(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam) {
+    if (msg != WM_SIZE || wparam == SIZE_MINIMIZED) {
+        return;
+    }
+    auto* s = reinterpret_cast<PresentSurface*>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
+    if (s) {
+        ResizePresentSurface(*s, LOWORD(lparam), HIWORD(lparam));
+    }
+}
+
+void ClearPresentSurface(PresentSurface& s) {
+    RECT rc{ 0, 0, s.width, s.height };
+    FillRect(s.memDC, &rc, s.background);
+}
+
+void PresentToWindow(PresentSurface& s) {
+    if (!s.dib) {
+        return;
+    }
+    BitBlt(s.windowDC, 0, 0, s.width, s.height, s.memDC, 0, 0, SRCCOPY);
+}
+
+void PresentRectToWindow(PresentSurface& s, int x, int y, int w, int h) {
+    if (!s.dib) {
+        return;
+    }
+    BitBlt(s.windowDC, x, y, w, h, s.memDC, x, y, SRCCOPY);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+// Back buffer that lives across frames: one memory DC with a 32-bit DIB
+// section selected into it, created up front and recreated only on WM_SIZE.
+// The window DC is fetched once and cached, which is only valid for windows
+// whose class has CS_OWNDC.
+//
+// Include after <windows.h>.
+
+struct PresentSurface {
+    HWND wnd = nullptr;
+    HDC windowDC = nullptr;
+    HDC memDC = nullptr;
+    HBITMAP dib = nullptr;
+    HGDIOBJ oldBitmap = nullptr;
+    HBRUSH background = nullptr;
+    // Top-down BGRA pixels of the DIB, width * height * 4 bytes.
+    void* bits = nullptr;
+    int width = 0;
+    int height = 0;
+};
+
+bool CreatePresentSurface(PresentSurface& s, HWND wnd, COLORREF background);
+void DestroyPresentSurface(PresentSurface& s);
+
+// Reallocates the DIB for the new client size. A 0x0 size (minimized) keeps
+// the old buffer.
+void ResizePresentSurface(PresentSurface& s, int width, int height);
+
+// Call from WndProc before DefWindowProc. Handles WM_SIZE for the surface
+// registered on the window with SetWindowLongPtr(GWLP_USERDATA).
+void HandlePresentSurfaceMessage(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam);
+
+void ClearPresentSurface(PresentSurface& s);
+void PresentToWindow(PresentSurface& s);
+// Copies just one rectangle of the back buffer to the window.
+void PresentRectToWindow(PresentSurface& s, int x, int y, int w, int h);
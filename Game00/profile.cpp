@@ -0,0 +1,146 @@
+#include "profile.h"
+
+#if CGAME_PROFILE
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+static const size_t kRingSize = size_t(1) << 15;
+static const size_t kRingMask = kRingSize - 1;
+// Events this close to being overwritten are not read.
+static const size_t kRingGuard = 1024;
+static const int kMaxThreads = 4;
+static const size_t kMaxWindow = 1024;
+
+// Event i is start[i] plus meta[i] = durationNs << 32 | zone.
+struct ProfileRing {
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> start[kRingSize];
+    std::atomic<uint64_t> meta[kRingSize];
+};
+
+static ProfileRing gRings[kMaxThreads];
+static std::atomic<int> gRingCount{ 0 };
+static thread_local int tRing = -1;
+
+static const char* const kZoneNames[ZoneCount] = {
+    "frame", "message pump", "input", "step", "shells", "bombs", "ai", "helicopters",
+    "collision", "compaction", "draw", "present", "sleep",
+};
+
+const char* ProfileZoneName(ProfileZone zone) {
+    return zone < ZoneCount ? kZoneNames[zone] : "?";
+}
+
+uint64_t ProfileNowNs() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void ProfileRecord(ProfileZone zone, uint64_t startNs, uint64_t endNs) {
+    if (tRing < 0) {
+        tRing = std::min(gRingCount.fetch_add(1, std::memory_order_relaxed), kMaxThreads);
+    }
+    if (tRing >= kMaxThreads) {
+        return;
+    }
+    ProfileRing& ring = gRings[tRing];
+    const uint64_t head = ring.head.load(std::memory_order_relaxed);
+    const uint64_t duration = std::min<uint64_t>(endNs - startNs, 0xFFFFFFFFu);
+    ring.start[head & kRingMask].store(startNs, std::memory_order_relaxed);
+    ring.meta[head & kRingMask].store(duration << 32 | zone, std::memory_order_relaxed);
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+// Calls fn(start, durationNs, zone) for the readable events of one ring,
+// newest first, until it returns false.
+template <typename Fn>
+static void ForEachEvent(const ProfileRing& ring, Fn&& fn) {
+    const uint64_t head = ring.head.load(std::memory_order_acquire);
+    const uint64_t oldest = head > kRingSize - kRingGuard ? head - (kRingSize - kRingGuard) : 0;
+    for (uint64_t i = head; i > oldest; --i) {
+        const uint64_t meta = ring.meta[(i - 1) & kRingMask].load(std::memory_order_relaxed);
+        const uint64_t start = ring.start[(i - 1) & kRingMask].load(std::memory_order_relaxed);
+        if (!fn(start, static_cast<uint32_t>(meta >> 32), static_cast<ProfileZone>(meta & 0xFFFF))) {
+            return;
+        }
+    }
+}
+
+static int RingCount() {
+    return std::min(gRingCount.load(std::memory_order_relaxed), kMaxThreads);
+}
+
+ProfileStats ProfileZoneStats(ProfileZone zone, size_t window) {
+    // Only called from the render thread, so the scratch needs no locking.
+    static float samples[kMaxWindow];
+    window = std::min(window, kMaxWindow);
+    size_t n = 0;
+    for (int r = 0; r < RingCount() && n < window; ++r) {
+        ForEachEvent(gRings[r], [&](uint64_t, uint32_t durationNs, ProfileZone z) {
+            if (z == zone) {
+                samples[n++] = static_cast<float>(durationNs) * 1e-6f;
+            }
+            return n < window;
+        });
+    }
+
+    ProfileStats stats;
+    stats.samples = static_cast<uint32_t>(n);
+    if (n == 0) {
+        return stats;
+    }
+    float* p50 = samples + n / 2;
+    std::nth_element(samples, p50, samples + n);
+    stats.p50Ms = *p50;
+    float* p99 = samples + std::min(n - 1, n * 99 / 100);
+    std::nth_element(samples, p99, samples + n);
+    stats.p99Ms = *p99;
+    return stats;
+}
+
+bool ExportChromeTrace(const char* path) {
+    struct Event {
+        uint64_t start;
+        uint32_t durationNs;
+        ProfileZone zone;
+        int thread;
+    };
+    std::vector<Event> events;
+    for (int r = 0; r < RingCount(); ++r) {
+        ForEachEvent(gRings[r], [&](uint64_t start, uint32_t durationNs, ProfileZone zone) {
+            events.push_back({ start, durationNs, zone, r });
+            return true;
+        });
+    }
+
+    FILE* f = std::fopen(path, "w");
+    if (!f) {
+        return false;
+    }
+    uint64_t base = ~0ull;
+    for (const Event& e : events) {
+        base = std::min(base, e.start);
+    }
+    std::fprintf(f, "{\"traceEvents\":[");
+    const char* sep = "\n";
+    for (int r = 0; r < RingCount(); ++r) {
+        std::fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}", sep, r, r);
+        sep = ",\n";
+    }
+    // The rings were read newest first; write each one oldest first.
+    for (size_t i = events.size(); i-- > 0;) {
+        const Event& e = events[i];
+        std::fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", sep,
+                     ProfileZoneName(e.zone), e.thread, static_cast<double>(e.start - base) * 1e-3,
+                     static_cast<double>(e.durationNs) * 1e-3);
+        sep = ",\n";
+    }
+    std::fprintf(f, "\n]}\n");
+    return std::fclose(f) == 0;
+}
+
+#endif
@@ -0,0 +1,85 @@
+#pragma once
+
+// Scoped phase timers. CGAME_PROFILE_SCOPE(zone) times the rest of the
+// enclosing block and appends {zone, start, duration} to a per-thread ring
+// buffer; the render thread reads the rings for the HUD percentiles and
+// ExportChromeTrace writes them as chrome://tracing JSON.
+//
+// Profiling is on in debug builds (_DEBUG) and off otherwise; build with
+// CGAME_PROFILE=1 or 0 to override. When it is off the macro expands to
+// nothing and none of the functions below exist, so callers outside hot
+// loops guard their use with #if CGAME_PROFILE.
+//
+// Each thread writes only its own ring, with relaxed atomic stores and a
+// release store of the head, so recording never locks or waits. Readers
+// skip the oldest part of each ring, which is the part a writer may be
+// overwriting while they read.
+
+#ifndef CGAME_PROFILE
+#  if defined(_DEBUG)
+#    define CGAME_PROFILE 1
+#  else
+#    define CGAME_PROFILE 0
+#  endif
+#endif
+
+#if CGAME_PROFILE
+
+#include <cstddef>
+#include <cstdint>
+
+enum ProfileZone : uint16_t {
+    ZoneFrame,
+    ZoneMessagePump,
+    ZoneInput,
+    ZoneStep,
+    ZoneShells,
+    ZoneBombs,
+    ZoneAi,
+    ZoneHelicopters,
+    ZoneCollision,
+    ZoneCompaction,
+    ZoneDraw,
+    ZonePresent,
+    ZoneSleep,
+    ZoneCount
+};
+
+const char* ProfileZoneName(ProfileZone zone);
+
+uint64_t ProfileNowNs();
+// Threads past the fourth to record anything are ignored.
+void ProfileRecord(ProfileZone zone, uint64_t startNs, uint64_t endNs);
+
+struct ProfileScope {
+    explicit ProfileScope(ProfileZone zone) : zone(zone), startNs(ProfileNowNs()) {}
+    ~ProfileScope() { ProfileRecord(zone, startNs, ProfileNowNs()); }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+    ProfileZone zone;
+    uint64_t startNs;
+};
+
+#define CGAME_PROFILE_CONCAT2(a, b) a##b
+#define CGAME_PROFILE_CONCAT(a, b) CGAME_PROFILE_CONCAT2(a, b)
+#define CGAME_PROFILE_SCOPE(zone) ProfileScope CGAME_PROFILE_CONCAT(profileScope, __LINE__)(zone)
+
+struct ProfileStats {
+    uint32_t samples = 0;
+    float p50Ms = 0.f;
+    float p99Ms = 0.f;
+};
+
+// Percentiles over the most recent `window` (at most 1024) recordings of
+// `zone`, from whichever threads recorded it.
+ProfileStats ProfileZoneStats(ProfileZone zone, size_t window);
+
+// Writes every event still in the rings. False if the file cannot be written.
+bool ExportChromeTrace(const char* path);
+
+#else
+
+#define CGAME_PROFILE_SCOPE(zone) ((void)0)
+
+#endif
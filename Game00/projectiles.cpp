@@ -0,0 +1,217 @@
+#include "projectiles.h"
+
+#include <algorithm>
+
+#include "simd.h"
+
+static size_t LiveWords(size_t count) {
+    return (count + 63) / 64;
+}
+
+void InitProjectilePool(ProjectileSoA& p, size_t capacity) {
+    if (capacity != p.capacity || p.slotGeneration.size() != capacity) {
+        p.capacity = capacity;
+        p.x.assign(capacity, 0.f);
+        p.y.assign(capacity, 0.f);
+        p.vx.assign(capacity, 0.f);
+        p.vy.assign(capacity, 0.f);
+        p.prevX.assign(capacity, 0.f);
+        p.prevY.assign(capacity, 0.f);
+        p.live.assign(LiveWords(capacity), 0);
+        p.denseSlot.assign(capacity, 0);
+        p.slotDense.assign(capacity, 0);
+        p.slotGeneration.assign(capacity, 1u);
+        p.freeSlots.reserve(capacity);
+        p.count = 0;
+    }
+    // Same capacity: keep the generations so handles from before stay dead.
+    ClearProjectiles(p);
+}
+
+void ClearProjectiles(ProjectileSoA& p) {
+    for (size_t i = 0; i < p.count; ++i) {
+        ++p.slotGeneration[p.denseSlot[i]];
+    }
+    p.count = 0;
+    std::fill(p.live.begin(), p.live.end(), 0);
+    // Pop order hands out slot 0 first.
+    p.freeSlots.resize(p.capacity);
+    for (size_t s = 0; s < p.capacity; ++s) {
+        p.freeSlots[s] = static_cast<uint32_t>(p.capacity - 1 - s);
+    }
+}
+
+ProjectileHandle SpawnProjectile(ProjectileSoA& p, float x, float y, float vx, float vy) {
+    if (p.count == p.capacity) {
+        return ProjectileHandle{};
+    }
+    uint32_t slot = p.freeSlots.back();
+    p.freeSlots.pop_back();
+
+    size_t i = p.count++;
+    p.x[i] = x;
+    p.y[i] = y;
+    p.vx[i] = vx;
+    p.vy[i] = vy;
+    p.prevX[i] = x;
+    p.prevY[i] = y;
+    p.live[i >> 6] |= uint64_t(1) << (i & 63);
+    p.denseSlot[i] = slot;
+    p.slotDense[slot] = static_cast<uint32_t>(i);
+    return ProjectileHandle{ slot, p.slotGeneration[slot] };
+}
+
+bool LookupProjectile(const ProjectileSoA& p, ProjectileHandle h, size_t& index) {
+    if (h.slot >= p.capacity || p.slotGeneration[h.slot] != h.generation) {
+        return false;
+    }
+    index = p.slotDense[h.slot];
+    return true;
+}
+
+ProjectileHandle HandleAt(const ProjectileSoA& p, size_t index) {
+    uint32_t slot = p.denseSlot[index];
+    return ProjectileHandle{ slot, p.slotGeneration[slot] };
+}
+
+void RemoveProjectile(ProjectileSoA& p, size_t index) {
+    const size_t last = p.count - 1;
+    const uint32_t slot = p.denseSlot[index];
+    ++p.slotGeneration[slot];
+    p.freeSlots.push_back(slot);
+
+    if (index != last) {
+        p.x[index] = p.x[last];
+        p.y[index] = p.y[last];
+        p.vx[index] = p.vx[last];
+        p.vy[index] = p.vy[last];
+        p.prevX[index] = p.prevX[last];
+        p.prevY[index] = p.prevY[last];
+        const bool lastLive = IsLive(p, last);
+        if (lastLive) {
+            p.live[index >> 6] |= uint64_t(1) << (index & 63);
+        } else {
+            KillProjectile(p, index);
+        }
+        const uint32_t movedSlot = p.denseSlot[last];
+        p.denseSlot[index] = movedSlot;
+        p.slotDense[movedSlot] = static_cast<uint32_t>(index);
+    }
+    KillProjectile(p, last);
+    p.count = last;
+}
+
+size_t CountLive(const ProjectileSoA& p) {
+    size_t n = 0;
+    for (uint64_t word : p.live) {
+        while (word) {
+            word &= word - 1;
+            ++n;
+        }
+    }
+    return n;
+}
+
+// Scalar body, also used for the tail the vector loop does not cover.
+static void IntegrateRange(ProjectileSoA& p, size_t begin, size_t end, float gravity, float dt, const CullBounds& bounds) {
+    float* x = p.x.data();
+    float* y = p.y.data();
+    float* vx = p.vx.data();
+    float* vy = p.vy.data();
+    for (size_t i = begin; i < end; ++i) {
+        p.prevX[i] = x[i];
+        p.prevY[i] = y[i];
+        vy[i] += gravity * dt;
+        x[i] = x[i] + vx[i] * dt;
+        y[i] = y[i] + vy[i] * dt;
+        bool inside = x[i] >= bounds.minX && x[i] <= bounds.maxX && y[i] <= bounds.maxY;
+        if (!inside) {
+            KillProjectile(p, i);
+        }
+    }
+}
+
+void IntegrateBallistic(ProjectileSoA& p, float gravity, float dt, const CullBounds& bounds) {
+    const size_t n = p.count;
+    size_t i = 0;
+
+#if defined(CGAME_SIMD_AVX2)
+    const __m256 g = _mm256_set1_ps(gravity * dt);
+    const __m256 vdt = _mm256_set1_ps(dt);
+    const __m256 minX = _mm256_set1_ps(bounds.minX);
+    const __m256 maxX = _mm256_set1_ps(bounds.maxX);
+    const __m256 maxY = _mm256_set1_ps(bounds.maxY);
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(&p.x[i]);
+        __m256 y = _mm256_loadu_ps(&p.y[i]);
+        __m256 vx = _mm256_loadu_ps(&p.vx[i]);
+        __m256 vy = _mm256_loadu_ps(&p.vy[i]);
+        _mm256_storeu_ps(&p.prevX[i], x);
+        _mm256_storeu_ps(&p.prevY[i], y);
+        vy = _mm256_add_ps(vy, g);
+        x = _mm256_add_ps(x, _mm256_mul_ps(vx, vdt));
+        y = _mm256_add_ps(y, _mm256_mul_ps(vy, vdt));
+        _mm256_storeu_ps(&p.vy[i], vy);
+        _mm256_storeu_ps(&p.x[i], x);
+        _mm256_storeu_ps(&p.y[i], y);
+        __m256 inside = _mm256_and_ps(
+            _mm256_and_ps(_mm256_cmp_ps(x, minX, _CMP_GE_OQ), _mm256_cmp_ps(x, maxX, _CMP_LE_OQ)),
+            _mm256_cmp_ps(y, maxY, _CMP_LE_OQ));
+        uint64_t dead = static_cast<uint64_t>(~_mm256_movemask_ps(inside) & 0xFF);
+        p.live[i >> 6] &= ~(dead << (i & 63));
+    }
+#elif defined(CGAME_SIMD_SSE2)
+    const __m128 g = _mm_set1_ps(gravity * dt);
+    const __m128 vdt = _mm_set1_ps(dt);
+    const __m128 minX = _mm_set1_ps(bounds.minX);
+    const __m128 maxX = _mm_set1_ps(bounds.maxX);
+    const __m128 maxY = _mm_set1_ps(bounds.maxY);
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(&p.x[i]);
+        __m128 y = _mm_loadu_ps(&p.y[i]);
+        __m128 vx = _mm_loadu_ps(&p.vx[i]);
+        __m128 vy = _mm_loadu_ps(&p.vy[i]);
+        _mm_storeu_ps(&p.prevX[i], x);
+        _mm_storeu_ps(&p.prevY[i], y);
+        vy = _mm_add_ps(vy, g);
+        x = _mm_add_ps(x, _mm_mul_ps(vx, vdt));
+        y = _mm_add_ps(y, _mm_mul_ps(vy, vdt));
+        _mm_storeu_ps(&p.vy[i], vy);
+        _mm_storeu_ps(&p.x[i], x);
+        _mm_storeu_ps(&p.y[i], y);
+        __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(x, minX), _mm_cmple_ps(x, maxX)), _mm_cmple_ps(y, maxY));
+        uint64_t dead = static_cast<uint64_t>(~_mm_movemask_ps(inside) & 0xF);
+        p.live[i >> 6] &= ~(dead << (i & 63));
+    }
+#endif
+
+    IntegrateRange(p, i, n, gravity, dt, bounds);
+}
+
+void CompactProjectiles(ProjectileSoA& p) {
+    // Walk from the back so the element swapped into a hole has already been
+    // visited and is known to be alive. Fully live words are skipped whole.
+    size_t i = p.count;
+    while (i > 0) {
+        const size_t word = (i - 1) >> 6;
+        const size_t wordStart = word << 6;
+        if (i - wordStart == 64 && p.live[word] == ~uint64_t(0)) {
+            i = wordStart;
+            continue;
+        }
+        --i;
+        if (!IsLive(p, i)) {
+            RemoveProjectile(p, i);
+        }
+    }
+}
+
+const char* BallisticKernelName() {
+#if defined(CGAME_SIMD_AVX2)
+    return "avx2";
+#elif defined(CGAME_SIMD_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
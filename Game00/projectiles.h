@@ -0,0 +1,90 @@
+#pragma once
+
+// Structure-of-arrays storage for shells and bombs plus the ballistic
+// integration kernel shared by both.
+//
+// The storage is a fixed-capacity pool: every array is sized once by
+// InitProjectilePool, live projectiles are packed densely in [0, count), and
+// removal swaps the last one into the hole. Stable references go through
+// generational handles, which stop resolving once their projectile is gone.
+//
+// The kernel is picked at compile time (simd.h): AVX2 (8 lanes) when the
+// compiler targets it, SSE2 (4 lanes) on any x86-64 build, scalar otherwise.
+// Define CGAME_NO_SIMD to force the scalar path.
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+struct ProjectileHandle {
+    uint32_t slot = 0xFFFFFFFFu;
+    uint32_t generation = 0;
+};
+
+struct ProjectileSoA {
+    // Dense arrays, indexed by position in [0, count).
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> vx;
+    std::vector<float> vy;
+    // Position at the start of the last step, for render interpolation.
+    std::vector<float> prevX;
+    std::vector<float> prevY;
+    // Bit (i % 64) of word (i / 64) is set while dense position i is alive.
+    std::vector<uint64_t> live;
+    // Handle slot owning each dense position.
+    std::vector<uint32_t> denseSlot;
+    size_t count = 0;
+
+    // Per handle slot: current dense position and generation. Generations
+    // start at 1, so a default-constructed handle never resolves.
+    std::vector<uint32_t> slotDense;
+    std::vector<uint32_t> slotGeneration;
+    std::vector<uint32_t> freeSlots;
+    size_t capacity = 0;
+};
+
+// A projectile stays alive while minX <= x <= maxX and y <= maxY.
+struct CullBounds {
+    float minX;
+    float maxX;
+    float maxY;
+};
+
+// Allocates every array for `capacity` projectiles. Reinitializing with the
+// same capacity reuses the memory.
+void InitProjectilePool(ProjectileSoA& p, size_t capacity);
+// Removes everything and invalidates all outstanding handles.
+void ClearProjectiles(ProjectileSoA& p);
+// Returns an invalid handle (and spawns nothing) when the pool is full.
+ProjectileHandle SpawnProjectile(ProjectileSoA& p, float x, float y, float vx, float vy);
+
+inline bool IsFull(const ProjectileSoA& p) {
+    return p.count == p.capacity;
+}
+
+// Dense position of the projectile behind `h`, or false if it is gone.
+bool LookupProjectile(const ProjectileSoA& p, ProjectileHandle h, size_t& index);
+ProjectileHandle HandleAt(const ProjectileSoA& p, size_t index);
+// O(1) swap-remove of the projectile at dense position `index`.
+void RemoveProjectile(ProjectileSoA& p, size_t index);
+
+inline bool IsLive(const ProjectileSoA& p, size_t i) {
+    return (p.live[i >> 6] >> (i & 63)) & 1u;
+}
+
+inline void KillProjectile(ProjectileSoA& p, size_t i) {
+    p.live[i >> 6] &= ~(uint64_t(1) << (i & 63));
+}
+
+size_t CountLive(const ProjectileSoA& p);
+
+// prev = pos; vy += gravity * dt; pos += vel * dt; then clears the live bit of
+// every projectile that left the bounds. Runs over all slots without branching.
+void IntegrateBallistic(ProjectileSoA& p, float gravity, float dt, const CullBounds& bounds);
+
+// Swap-removes every projectile whose live bit was cleared this step.
+void CompactProjectiles(ProjectileSoA& p);
+
+// Name of the kernel compiled into this build ("avx2", "sse2" or "scalar").
+const char* BallisticKernelName();
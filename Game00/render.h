@@ -0,0 +1,102 @@
+#pragma once
+
+// Render backend interface. The scene code in scene.cpp draws through this,
+// GdiplusRenderer (render_gdiplus.cpp) puts it on a window and SoftRenderer
+// (render_soft.cpp) rasterizes it on the CPU with no platform dependencies.
+//
+// Coordinates are window pixels, y down. Colors are straight-alpha 0xAARRGGBB,
+// like Gdiplus::Color.
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+inline uint32_t Argb(uint32_t a, uint32_t r, uint32_t g, uint32_t b) {
+    return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+// Pixels are premultiplied 0xAARRGGBB, row-major, no padding.
+struct Image {
+    int width = 0;
+    int height = 0;
+    std::vector<uint32_t> pixels;
+};
+
+// Integer pixel rectangle, top-left plus size.
+struct IRect {
+    int x = 0;
+    int y = 0;
+    int w = 0;
+    int h = 0;
+};
+
+typedef int TextureId;
+const TextureId kNoTexture = -1;
+
+// Draws a texture into the local rectangle (x, y, w, h), rotated clockwise
+// by rotationDeg about the local origin, which is placed at (originX,
+// originY). Same as TranslateTransform + RotateTransform + DrawImage in GDI+.
+struct SpriteDraw {
+    float originX = 0.f;
+    float originY = 0.f;
+    float rotationDeg = 0.f;
+    float x = 0.f;
+    float y = 0.f;
+    float w = 0.f;
+    float h = 0.f;
+};
+
+// Discs of radius size[i] centered on (x[i], y[i]), all of one color. Each
+// is scaled by 1 - age[i] and added to the target with per-channel
+// saturation, so overlapping particles brighten rather than cover.
+struct ParticleBatch {
+    const float* x = nullptr;
+    const float* y = nullptr;
+    const float* size = nullptr;
+    const float* age = nullptr;
+    size_t count = 0;
+    uint32_t color = 0;
+};
+
+class Renderer {
+public:
+    virtual ~Renderer() {}
+
+    virtual int Width() const = 0;
+    virtual int Height() const = 0;
+
+    virtual void BeginFrame() = 0;
+    virtual void EndFrame() = 0;
+    // Ends the frame like EndFrame, but only the given rectangles changed
+    // since the last one, so only they are presented.
+    virtual void EndFrameRects(const IRect* rects, int count) = 0;
+
+    // Every draw call, Clear included, only touches pixels inside the clip
+    // rectangle until ResetClip.
+    virtual void SetClipRect(const IRect& rect) = 0;
+    virtual void ResetClip() = 0;
+
+    virtual void Clear(uint32_t color) = 0;
+    virtual void FillRectangle(float x, float y, float w, float h, uint32_t color) = 0;
+    virtual void FillCircle(float cx, float cy, float radius, uint32_t color) = 0;
+    virtual void DrawLine(float x0, float y0, float x1, float y1, float width, uint32_t color) = 0;
+    virtual void DrawParticlesAdditive(const ParticleBatch& batch) = 0;
+
+    // Textures are uploaded once and referenced by id afterwards.
+    virtual TextureId CreateTexture(const Image& image) = 0;
+    virtual void DrawSprite(TextureId texture, const SpriteDraw& draw) = 0;
+    // Unscaled, unrotated draw with the texture's top-left at (x, y).
+    virtual void BlitTexture(TextureId texture, int x, int y) = 0;
+    // Copies the texture's pixels inside `rect` to the same place on the
+    // target, replacing what is there rather than blending over it.
+    virtual void CopyTextureRect(TextureId texture, const IRect& rect) = 0;
+
+    // Single line of ASCII text, centered horizontally in the rectangle and
+    // aligned to its top. sizePx is the em height.
+    virtual void DrawLabel(const char* text, float x, float y, float w, float h, float sizePx, uint32_t color) = 0;
+    // Redraws the texture as transparent pixels with DrawLabel(text, 0, 0,
+    // width, height, ...) on them, so text that rarely changes is laid out
+    // once and blitted after that. Blitting the result at (x, y) looks the
+    // same as DrawLabel at whole-pixel (x, y).
+    virtual void RenderLabelTexture(TextureId texture, const char* text, float sizePx, uint32_t color) = 0;
+};
@@ -0,0 +1,227 @@
+#ifndef NOMINMAX
+#  define NOMINMAX
+#endif
+
+#ifndef UNICODE
+#  define UNICODE
+#endif
+#ifndef _UNICODE
+#  define _UNICODE
+#endif
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <objidl.h>
+#include <gdiplus.h>
+
+#include "render_gdiplus.h"
+#include "render_soft.h"
+
+#include <algorithm>
+#include <cstring>
+
+static Gdiplus::Color ToColor(uint32_t argb) {
+    return Gdiplus::Color(static_cast<Gdiplus::ARGB>(argb));
+}
+
+GdiplusRenderer::GdiplusRenderer(PresentSurface& surface)
+    : surface_(surface), brush_(Gdiplus::Color(255, 255, 255, 255)), pen_(Gdiplus::Color(255, 255, 255, 255), 1.f) {
+    labelFormat_.SetAlignment(Gdiplus::StringAlignmentCenter);
+}
+
+GdiplusRenderer::~GdiplusRenderer() {
+    delete graphics_;
+}
+
+void GdiplusRenderer::BeginFrame() {
+    delete graphics_;
+    graphics_ = new Gdiplus::Graphics(surface_.memDC);
+    graphics_->SetSmoothingMode(Gdiplus::SmoothingModeHighQuality);
+}
+
+void GdiplusRenderer::EndFrame() {
+    delete graphics_;
+    graphics_ = nullptr;
+    PresentToWindow(surface_);
+}
+
+void GdiplusRenderer::EndFrameRects(const IRect* rects, int count) {
+    delete graphics_;
+    graphics_ = nullptr;
+    for (int i = 0; i < count; ++i) {
+        PresentRectToWindow(surface_, rects[i].x, rects[i].y, rects[i].w, rects[i].h);
+    }
+}
+
+void GdiplusRenderer::SetClipRect(const IRect& rect) {
+    graphics_->SetClip(Gdiplus::Rect(rect.x, rect.y, rect.w, rect.h));
+    clip_.x = std::max(rect.x, 0);
+    clip_.y = std::max(rect.y, 0);
+    clip_.w = std::max(std::min(rect.x + rect.w, surface_.width) - clip_.x, 0);
+    clip_.h = std::max(std::min(rect.y + rect.h, surface_.height) - clip_.y, 0);
+    clipped_ = true;
+}
+
+void GdiplusRenderer::ResetClip() {
+    graphics_->ResetClip();
+    clipped_ = false;
+}
+
+void GdiplusRenderer::Clear(uint32_t color) {
+    graphics_->Clear(ToColor(color));
+}
+
+void GdiplusRenderer::FillRectangle(float x, float y, float w, float h, uint32_t color) {
+    brush_.SetColor(ToColor(color));
+    graphics_->FillRectangle(&brush_, x, y, w, h);
+}
+
+void GdiplusRenderer::FillCircle(float cx, float cy, float radius, uint32_t color) {
+    brush_.SetColor(ToColor(color));
+    graphics_->FillEllipse(&brush_, cx - radius, cy - radius, radius * 2.f, radius * 2.f);
+}
+
+void GdiplusRenderer::DrawLine(float x0, float y0, float x1, float y1, float width, uint32_t color) {
+    pen_.SetColor(ToColor(color));
+    pen_.SetWidth(width);
+    graphics_->DrawLine(&pen_, x0, y0, x1, y1);
+}
+
+void GdiplusRenderer::DrawParticlesAdditive(const ParticleBatch& batch) {
+    if (!surface_.bits) {
+        return;
+    }
+    // GDI+ has no additive compositing, so finish what it has queued and
+    // add the particles straight into the back buffer.
+    graphics_->Flush(Gdiplus::FlushIntentionSync);
+    GdiFlush();
+    const IRect clip = clipped_ ? clip_ : IRect{ 0, 0, surface_.width, surface_.height };
+    AddParticles(static_cast<uint32_t*>(surface_.bits), surface_.width, clip, batch);
+}
+
+TextureId GdiplusRenderer::CreateTexture(const Image& image) {
+    std::unique_ptr<Gdiplus::Bitmap> bmp(new Gdiplus::Bitmap(image.width, image.height, PixelFormat32bppPARGB));
+    Gdiplus::Rect rect(0, 0, image.width, image.height);
+    Gdiplus::BitmapData data{};
+    if (bmp->LockBits(&rect, Gdiplus::ImageLockModeWrite, PixelFormat32bppPARGB, &data) != Gdiplus::Ok) {
+        return kNoTexture;
+    }
+    for (int y = 0; y < image.height; ++y) {
+        std::memcpy(static_cast<uint8_t*>(data.Scan0) + static_cast<size_t>(y) * data.Stride,
+                    image.pixels.data() + static_cast<size_t>(y) * image.width,
+                    static_cast<size_t>(image.width) * 4);
+    }
+    bmp->UnlockBits(&data);
+    textures_.push_back(std::move(bmp));
+    cached_.emplace_back();
+    return static_cast<TextureId>(textures_.size() - 1);
+}
+
+void GdiplusRenderer::DrawSprite(TextureId texture, const SpriteDraw& draw) {
+    if (texture < 0 || texture >= static_cast<TextureId>(textures_.size())) {
+        return;
+    }
+    graphics_->SetInterpolationMode(Gdiplus::InterpolationModeNearestNeighbor);
+    graphics_->SetPixelOffsetMode(Gdiplus::PixelOffsetModeHalf);
+    graphics_->TranslateTransform(draw.originX, draw.originY);
+    graphics_->RotateTransform(draw.rotationDeg);
+    graphics_->DrawImage(textures_[texture].get(), Gdiplus::RectF(draw.x, draw.y, draw.w, draw.h));
+    graphics_->ResetTransform();
+    graphics_->SetPixelOffsetMode(Gdiplus::PixelOffsetModeDefault);
+}
+
+void GdiplusRenderer::BlitTexture(TextureId texture, int x, int y) {
+    if (texture < 0 || texture >= static_cast<TextureId>(textures_.size())) {
+        return;
+    }
+    std::unique_ptr<Gdiplus::CachedBitmap>& cached = cached_[texture];
+    if (!cached) {
+        cached.reset(new Gdiplus::CachedBitmap(textures_[texture].get(), graphics_));
+    }
+    if (graphics_->DrawCachedBitmap(cached.get(), x, y) != Gdiplus::Ok) {
+        // The display format changed since the copy was made.
+        cached.reset(new Gdiplus::CachedBitmap(textures_[texture].get(), graphics_));
+        graphics_->DrawCachedBitmap(cached.get(), x, y);
+    }
+}
+
+void GdiplusRenderer::CopyTextureRect(TextureId texture, const IRect& rect) {
+    if (texture < 0 || texture >= static_cast<TextureId>(textures_.size())) {
+        return;
+    }
+    graphics_->SetCompositingMode(Gdiplus::CompositingModeSourceCopy);
+    graphics_->DrawImage(textures_[texture].get(), Gdiplus::Rect(rect.x, rect.y, rect.w, rect.h),
+                         rect.x, rect.y, rect.w, rect.h, Gdiplus::UnitPixel);
+    graphics_->SetCompositingMode(Gdiplus::CompositingModeSourceOver);
+}
+
+Gdiplus::Font* GdiplusRenderer::FontFor(float sizePx) {
+    for (auto& font : fonts_) {
+        if (font.first == sizePx) {
+            return font.second.get();
+        }
+    }
+    fonts_.emplace_back(sizePx, std::unique_ptr<Gdiplus::Font>(
+                                    new Gdiplus::Font(L"Segoe UI", sizePx, Gdiplus::FontStyleRegular, Gdiplus::UnitPixel)));
+    return fonts_.back().second.get();
+}
+
+static int Widen(const char* text, wchar_t (&wide)[256]) {
+    int n = 0;
+    for (; text[n] && n < 255; ++n) {
+        wide[n] = static_cast<wchar_t>(static_cast<unsigned char>(text[n]));
+    }
+    wide[n] = L'\0';
+    return n;
+}
+
+void GdiplusRenderer::DrawLabel(const char* text, float x, float y, float w, float h, float sizePx, uint32_t color) {
+    wchar_t wide[256];
+    const int n = Widen(text, wide);
+    brush_.SetColor(ToColor(color));
+    graphics_->DrawString(wide, n, FontFor(sizePx), Gdiplus::RectF(x, y, w, h), &labelFormat_, &brush_);
+}
+
+void GdiplusRenderer::RenderLabelTexture(TextureId texture, const char* text, float sizePx, uint32_t color) {
+    if (texture < 0 || texture >= static_cast<TextureId>(textures_.size())) {
+        return;
+    }
+    Gdiplus::Bitmap* bmp = textures_[texture].get();
+    wchar_t wide[256];
+    const int n = Widen(text, wide);
+    {
+        Gdiplus::Graphics g(bmp);
+        g.Clear(Gdiplus::Color(0, 0, 0, 0));
+        // ClearType needs an opaque background to blend against.
+        g.SetTextRenderingHint(Gdiplus::TextRenderingHintAntiAliasGridFit);
+        brush_.SetColor(ToColor(color));
+        g.DrawString(wide, n, FontFor(sizePx),
+                     Gdiplus::RectF(0.f, 0.f, static_cast<float>(bmp->GetWidth()), static_cast<float>(bmp->GetHeight())),
+                     &labelFormat_, &brush_);
+    }
+    cached_[texture].reset();
+}
+
+bool LoadImageFile(const wchar_t* path, Image& out) {
+    Gdiplus::Bitmap bmp(path);
+    if (bmp.GetLastStatus() != Gdiplus::Ok) {
+        return false;
+    }
+    const int width = static_cast<int>(bmp.GetWidth());
+    const int height = static_cast<int>(bmp.GetHeight());
+    Gdiplus::Rect rect(0, 0, width, height);
+    Gdiplus::BitmapData data{};
+    if (bmp.LockBits(&rect, Gdiplus::ImageLockModeRead, PixelFormat32bppPARGB, &data) != Gdiplus::Ok) {
+        return false;
+    }
+    out.width = width;
+    out.height = height;
+    out.pixels.resize(static_cast<size_t>(width) * static_cast<size_t>(height));
+    for (int y = 0; y < height; ++y) {
+        std::memcpy(out.pixels.data() + static_cast<size_t>(y) * width,
+                    static_cast<const uint8_t*>(data.Scan0) + static_cast<size_t>(y) * data.Stride,
+                    static_cast<size_t>(width) * 4);
+    }
+    bmp.UnlockBits(&data);
+    return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+// Renderer on top of GDI+, drawing into a PresentSurface back buffer. The
+// Graphics object lives for one BeginFrame/EndFrame pair; brushes, pens and
+// the font are created once and recolored per call.
+//
+// Include after <windows.h> and <gdiplus.h>.
+
+#include "render.h"
+#include "present_surface.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+class GdiplusRenderer : public Renderer {
+public:
+    explicit GdiplusRenderer(PresentSurface& surface);
+    ~GdiplusRenderer() override;
+
+    int Width() const override { return surface_.width; }
+    int Height() const override { return surface_.height; }
+
+    void BeginFrame() override;
+    void EndFrame() override;
+    void EndFrameRects(const IRect* rects, int count) override;
+
+    void SetClipRect(const IRect& rect) override;
+    void ResetClip() override;
+
+    void Clear(uint32_t color) override;
+    void FillRectangle(float x, float y, float w, float h, uint32_t color) override;
+    void FillCircle(float cx, float cy, float radius, uint32_t color) override;
+    void DrawLine(float x0, float y0, float x1, float y1, float width, uint32_t color) override;
+    void DrawParticlesAdditive(const ParticleBatch& batch) override;
+
+    TextureId CreateTexture(const Image& image) override;
+    void DrawSprite(TextureId texture, const SpriteDraw& draw) override;
+    void BlitTexture(TextureId texture, int x, int y) override;
+    void CopyTextureRect(TextureId texture, const IRect& rect) override;
+
+    void DrawLabel(const char* text, float x, float y, float w, float h, float sizePx, uint32_t color) override;
+    void RenderLabelTexture(TextureId texture, const char* text, float sizePx, uint32_t color) override;
+
+private:
+    Gdiplus::Font* FontFor(float sizePx);
+
+    PresentSurface& surface_;
+    Gdiplus::Graphics* graphics_ = nullptr;
+    // Current clip rectangle, clamped to the surface, for the drawing done
+    // straight into the DIB.
+    IRect clip_;
+    bool clipped_ = false;
+    Gdiplus::SolidBrush brush_;
+    Gdiplus::Pen pen_;
+    // One font per label size in use, created on first use.
+    std::vector<std::pair<float, std::unique_ptr<Gdiplus::Font>>> fonts_;
+    Gdiplus::StringFormat labelFormat_;
+    std::vector<std::unique_ptr<Gdiplus::Bitmap>> textures_;
+    // Device-format copies for BlitTexture, made on first use.
+    std::vector<std::unique_ptr<Gdiplus::CachedBitmap>> cached_;
+};
+
+// Loads a PNG/BMP/etc. through GDI+ as premultiplied ARGB.
+bool LoadImageFile(const wchar_t* path, Image& out);
@@ -0,0 +1,713 @@
+#include "render_soft.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// 5x7 glyphs for ASCII 32..126, one byte per column, bit 0 = top row.
+static const uint8_t kFont5x7[95][5] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5F, 0x00, 0x00 }, { 0x00, 0x07, 0x00, 0x07, 0x00 },
+    { 0x14, 0x7F, 0x14, 0x7F, 0x14 }, { 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 },
+    { 0x36, 0x49, 0x55, 0x22, 0x50 }, { 0x00, 0x05, 0x03, 0x00, 0x00 }, { 0x00, 0x1C, 0x22, 0x41, 0x00 },
+    { 0x00, 0x41, 0x22, 0x1C, 0x00 }, { 0x08, 0x2A, 0x1C, 0x2A, 0x08 }, { 0x08, 0x08, 0x3E, 0x08, 0x08 },
+    { 0x00, 0x50, 0x30, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, { 0x00, 0x60, 0x60, 0x00, 0x00 },
+    { 0x20, 0x10, 0x08, 0x04, 0x02 }, { 0x3E, 0x51, 0x49, 0x45, 0x3E }, { 0x00, 0x42, 0x7F, 0x40, 0x00 },
+    { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4B, 0x31 }, { 0x18, 0x14, 0x12, 0x7F, 0x10 },
+    { 0x27, 0x45, 0x45, 0x45, 0x39 }, { 0x3C, 0x4A, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 },
+    { 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1E }, { 0x00, 0x36, 0x36, 0x00, 0x00 },
+    { 0x00, 0x56, 0x36, 0x00, 0x00 }, { 0x08, 0x14, 0x22, 0x41, 0x00 }, { 0x14, 0x14, 0x14, 0x14, 0x14 },
+    { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x51, 0x09, 0x06 }, { 0x32, 0x49, 0x79, 0x41, 0x3E },
+    { 0x7E, 0x11, 0x11, 0x11, 0x7E }, { 0x7F, 0x49, 0x49, 0x49, 0x36 }, { 0x3E, 0x41, 0x41, 0x41, 0x22 },
+    { 0x7F, 0x41, 0x41, 0x22, 0x1C }, { 0x7F, 0x49, 0x49, 0x49, 0x41 }, { 0x7F, 0x09, 0x09, 0x01, 0x01 },
+    { 0x3E, 0x41, 0x41, 0x51, 0x32 }, { 0x7F, 0x08, 0x08, 0x08, 0x7F }, { 0x00, 0x41, 0x7F, 0x41, 0x00 },
+    { 0x20, 0x40, 0x41, 0x3F, 0x01 }, { 0x7F, 0x08, 0x14, 0x22, 0x41 }, { 0x7F, 0x40, 0x40, 0x40, 0x40 },
+    { 0x7F, 0x02, 0x04, 0x02, 0x7F }, { 0x7F, 0x04, 0x08, 0x10, 0x7F }, { 0x3E, 0x41, 0x41, 0x41, 0x3E },
+    { 0x7F, 0x09, 0x09, 0x09, 0x06 }, { 0x3E, 0x41, 0x51, 0x21, 0x5E }, { 0x7F, 0x09, 0x19, 0x29, 0x46 },
+    { 0x46, 0x49, 0x49, 0x49, 0x31 }, { 0x01, 0x01, 0x7F, 0x01, 0x01 }, { 0x3F, 0x40, 0x40, 0x40, 0x3F },
+    { 0x1F, 0x20, 0x40, 0x20, 0x1F }, { 0x7F, 0x20, 0x18, 0x20, 0x7F }, { 0x63, 0x14, 0x08, 0x14, 0x63 },
+    { 0x03, 0x04, 0x78, 0x04, 0x03 }, { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x7F, 0x41, 0x41, 0x00 },
+    { 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x7F, 0x00 }, { 0x04, 0x02, 0x01, 0x02, 0x04 },
+    { 0x40, 0x40, 0x40, 0x40, 0x40 }, { 0x00, 0x01, 0x02, 0x04, 0x00 }, { 0x20, 0x54, 0x54, 0x54, 0x78 },
+    { 0x7F, 0x48, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x20 }, { 0x38, 0x44, 0x44, 0x48, 0x7F },
+    { 0x38, 0x54, 0x54, 0x54, 0x18 }, { 0x08, 0x7E, 0x09, 0x01, 0x02 }, { 0x08, 0x14, 0x54, 0x54, 0x3C },
+    { 0x7F, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7D, 0x40, 0x00 }, { 0x20, 0x40, 0x44, 0x3D, 0x00 },
+    { 0x00, 0x7F, 0x10, 0x28, 0x44 }, { 0x00, 0x41, 0x7F, 0x40, 0x00 }, { 0x7C, 0x04, 0x18, 0x04, 0x78 },
+    { 0x7C, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 }, { 0x7C, 0x14, 0x14, 0x14, 0x08 },
+    { 0x08, 0x14, 0x14, 0x18, 0x7C }, { 0x7C, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x20 },
+    { 0x04, 0x3F, 0x44, 0x40, 0x20 }, { 0x3C, 0x40, 0x40, 0x20, 0x7C }, { 0x1C, 0x20, 0x40, 0x20, 0x1C },
+    { 0x3C, 0x40, 0x30, 0x40, 0x3C }, { 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x0C, 0x50, 0x50, 0x50, 0x3C },
+    { 0x44, 0x64, 0x54, 0x4C, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 }, { 0x00, 0x00, 0x7F, 0x00, 0x00 },
+    { 0x00, 0x41, 0x36, 0x08, 0x00 }, { 0x08, 0x04, 0x08, 0x10, 0x08 },
+};
+
+uint32_t Premultiply(uint32_t color) {
+    uint32_t a = color >> 24;
+    if (a == 255) {
+        return color;
+    }
+    uint32_t r = ((color >> 16) & 0xFF) * a;
+    uint32_t g = ((color >> 8) & 0xFF) * a;
+    uint32_t b = (color & 0xFF) * a;
+    r = (r + 128 + ((r + 128) >> 8)) >> 8;
+    g = (g + 128 + ((g + 128) >> 8)) >> 8;
+    b = (b + 128 + ((b + 128) >> 8)) >> 8;
+    return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+// Premultiplied source-over. Each channel is dst * (255 - a) / 255 rounded,
+// computed two channels at a time; the SSE2 span path uses the same formula.
+static inline uint32_t BlendOver(uint32_t dst, uint32_t src) {
+    const uint32_t a = src >> 24;
+    if (a == 255) {
+        return src;
+    }
+    if (a == 0) {
+        return dst;
+    }
+    const uint32_t inv = 255 - a;
+    uint32_t rb = (dst & 0x00FF00FFu) * inv + 0x00800080u;
+    uint32_t ag = ((dst >> 8) & 0x00FF00FFu) * inv + 0x00800080u;
+    rb = ((rb + ((rb >> 8) & 0x00FF00FFu)) >> 8) & 0x00FF00FFu;
+    ag = (ag + ((ag >> 8) & 0x00FF00FFu)) & 0xFF00FF00u;
+    return src + (rb | ag);
+}
+
+SoftRenderer::SoftRenderer(int width, int height)
+    : width_(width), height_(height), pixels_(static_cast<size_t>(width) * static_cast<size_t>(height), 0xFF000000u) {
+    ResetClip();
+}
+
+void SoftRenderer::SetClipRect(const IRect& rect) {
+    clipX0_ = std::max(rect.x, 0);
+    clipY0_ = std::max(rect.y, 0);
+    clipX1_ = std::max(std::min(rect.x + rect.w, width_), clipX0_);
+    clipY1_ = std::max(std::min(rect.y + rect.h, height_), clipY0_);
+}
+
+void SoftRenderer::ResetClip() {
+    clipX0_ = 0;
+    clipY0_ = 0;
+    clipX1_ = width_;
+    clipY1_ = height_;
+}
+
+void SoftRenderer::Span(int y, int x0, int x1, uint32_t premul) {
+    if (y < clipY0_ || y >= clipY1_) {
+        return;
+    }
+    x0 = std::max(x0, clipX0_);
+    x1 = std::min(x1, clipX1_);
+    if (x0 >= x1) {
+        return;
+    }
+    uint32_t* row = pixels_.data() + static_cast<size_t>(y) * width_;
+    int x = x0;
+    const uint32_t a = premul >> 24;
+
+    if (a == 255) {
+#if defined(CGAME_SIMD_SSE2)
+        const __m128i c = _mm_set1_epi32(static_cast<int>(premul));
+        for (; x + 4 <= x1; x += 4) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(row + x), c);
+        }
+#endif
+        for (; x < x1; ++x) {
+            row[x] = premul;
+        }
+        return;
+    }
+    if (a == 0) {
+        return;
+    }
+
+#if defined(CGAME_SIMD_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i src = _mm_set1_epi32(static_cast<int>(premul));
+    const __m128i inv = _mm_set1_epi16(static_cast<short>(255 - a));
+    const __m128i bias = _mm_set1_epi16(128);
+    for (; x + 4 <= x1; x += 4) {
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inv), bias);
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inv), bias);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row + x), _mm_add_epi8(_mm_packus_epi16(lo, hi), src));
+    }
+#endif
+    for (; x < x1; ++x) {
+        row[x] = BlendOver(row[x], premul);
+    }
+}
+
+// Pixel (px, py) is covered when its center (px + 0.5, py + 0.5) is inside.
+// The cast truncates toward zero, so step up when that rounded down; same as
+// std::ceil without the library call SSE2 builds make for it.
+static int FirstCovered(float edge) {
+    const float v = edge - 0.5f;
+    const int i = static_cast<int>(v);
+    return static_cast<float>(i) < v ? i + 1 : i;
+}
+
+void SoftRenderer::Clear(uint32_t color) {
+    const uint32_t premul = Premultiply(color);
+    for (int y = clipY0_; y < clipY1_; ++y) {
+        uint32_t* row = pixels_.data() + static_cast<size_t>(y) * width_;
+        std::fill(row + clipX0_, row + clipX1_, premul);
+    }
+}
+
+void SoftRenderer::FillRectangle(float x, float y, float w, float h, uint32_t color) {
+    const uint32_t premul = Premultiply(color);
+    const int x0 = FirstCovered(x);
+    const int x1 = FirstCovered(x + w);
+    const int y0 = std::max(FirstCovered(y), clipY0_);
+    const int y1 = std::min(FirstCovered(y + h), clipY1_);
+    for (int py = y0; py < y1; ++py) {
+        Span(py, x0, x1, premul);
+    }
+}
+
+void SoftRenderer::FillCircle(float cx, float cy, float radius, uint32_t color) {
+    const uint32_t premul = Premultiply(color);
+    const float r2 = radius * radius;
+    const int y0 = std::max(FirstCovered(cy - radius), clipY0_);
+    const int y1 = std::min(FirstCovered(cy + radius), clipY1_);
+    for (int py = y0; py < y1; ++py) {
+        const float dy = static_cast<float>(py) + 0.5f - cy;
+        const float d2 = r2 - dy * dy;
+        if (d2 < 0.f) {
+            continue;
+        }
+        const float half = std::sqrt(d2);
+        Span(py, FirstCovered(cx - half), FirstCovered(cx + half), premul);
+    }
+}
+
+void SoftRenderer::DrawLine(float x0, float y0, float x1, float y1, float width, uint32_t color) {
+    const float dx = x1 - x0;
+    const float dy = y1 - y0;
+    const float len = std::sqrt(dx * dx + dy * dy);
+    if (len <= 0.f) {
+        return;
+    }
+    // Butt-capped line as a convex quad, scan-converted one row at a time.
+    const float nx = -dy / len * width * 0.5f;
+    const float ny = dx / len * width * 0.5f;
+    const float qx[4] = { x0 + nx, x1 + nx, x1 - nx, x0 - nx };
+    const float qy[4] = { y0 + ny, y1 + ny, y1 - ny, y0 - ny };
+
+    const uint32_t premul = Premultiply(color);
+    const float minY = std::min(std::min(qy[0], qy[1]), std::min(qy[2], qy[3]));
+    const float maxY = std::max(std::max(qy[0], qy[1]), std::max(qy[2], qy[3]));
+    const int ys = std::max(FirstCovered(minY), clipY0_);
+    const int ye = std::min(FirstCovered(maxY), clipY1_);
+    for (int py = ys; py < ye; ++py) {
+        const float yc = static_cast<float>(py) + 0.5f;
+        float left = 1e30f;
+        float right = -1e30f;
+        for (int e = 0; e < 4; ++e) {
+            const float ax = qx[e];
+            const float ay = qy[e];
+            const float bx = qx[(e + 1) & 3];
+            const float by = qy[(e + 1) & 3];
+            if ((ay <= yc && by > yc) || (by <= yc && ay > yc)) {
+                const float t = (yc - ay) / (by - ay);
+                const float xi = ax + (bx - ax) * t;
+                left = std::min(left, xi);
+                right = std::max(right, xi);
+            }
+        }
+        if (left < right) {
+            Span(py, FirstCovered(left), FirstCovered(right), premul);
+        }
+    }
+}
+
+// row[x0, x1) += add, saturating each channel.
+// Adding zero leaves a pixel as it is, so when the row has room the last
+// partial group of four is done as a whole group with the extra lanes'
+// addend masked to zero. `width` is the row length.
+static void AddSpan(uint32_t* row, int width, int x0, int x1, uint32_t add) {
+    int x = x0;
+#if defined(CGAME_SIMD_SSE2)
+    const __m128i a = _mm_set1_epi32(static_cast<int>(add));
+    for (; x + 4 <= x1; x += 4) {
+        __m128i* p = reinterpret_cast<__m128i*>(row + x);
+        _mm_storeu_si128(p, _mm_adds_epu8(_mm_loadu_si128(p), a));
+    }
+    if (x < x1 && x + 4 <= width) {
+        static const int32_t kLanes[7] = { -1, -1, -1, 0, 0, 0, 0 };
+        const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(kLanes + 3 - (x1 - x)));
+        __m128i* p = reinterpret_cast<__m128i*>(row + x);
+        _mm_storeu_si128(p, _mm_adds_epu8(_mm_loadu_si128(p), _mm_and_si128(a, mask)));
+        return;
+    }
+    for (; x < x1; ++x) {
+        row[x] = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_adds_epu8(_mm_cvtsi32_si128(static_cast<int>(row[x])), a)));
+    }
+#else
+    (void)width;
+    // Two channels at a time; a carry out of a channel saturates it.
+    const uint32_t addRB = add & 0x00FF00FFu;
+    const uint32_t addAG = (add >> 8) & 0x00FF00FFu;
+    for (; x < x1; ++x) {
+        uint32_t rb = (row[x] & 0x00FF00FFu) + addRB;
+        uint32_t ag = ((row[x] >> 8) & 0x00FF00FFu) + addAG;
+        rb = (rb | (((rb >> 8) & 0x00010001u) * 0xFFu)) & 0x00FF00FFu;
+        ag = (ag | (((ag >> 8) & 0x00010001u) * 0xFFu)) & 0x00FF00FFu;
+        row[x] = rb | (ag << 8);
+    }
+#endif
+}
+
+#if defined(CGAME_SIMD_SSE2)
+// FirstCovered for four edges.
+static __m128i FirstCovered4(__m128 edge) {
+    const __m128 v = _mm_sub_ps(edge, _mm_set1_ps(0.5f));
+    const __m128i i = _mm_cvttps_epi32(v);
+    // The compare is all ones, -1, where a step up is needed.
+    return _mm_sub_epi32(i, _mm_castps_si128(_mm_cmplt_ps(_mm_cvtepi32_ps(i), v)));
+}
+
+static __m128i Select(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// Discs at most this many groups of four pixels wide take the path below.
+static const int kSmallDiscGroups = 4;
+
+// Small discs are mostly edge: a row-by-row loop spends its time on the
+// branches of a short, differently sized span per row. This works out the
+// spans of four rows at once and adds every row as the same number of
+// groups, with the lanes outside the span masked to zero, so the only
+// branches left are the same for every row. The spans are the ones the
+// row-by-row loop computes. False if the disc is too wide or too near the
+// right end of the row for whole groups; the caller then draws it row by
+// row.
+static bool AddSmallDisc(uint32_t* pixels, int width, int clipX0, int clipX1, int y0, int y1, float cx, float cy,
+                         float radius, uint32_t add) {
+    const int xs = std::max(FirstCovered(cx - radius), clipX0);
+    const int xe = std::min(FirstCovered(cx + radius), clipX1);
+    if (xs >= xe) {
+        return true;
+    }
+    const int groups = (xe - xs + 3) >> 2;
+    if (groups > kSmallDiscGroups || xs + 4 * groups > width) {
+        return false;
+    }
+    const __m128 vcx = _mm_set1_ps(cx);
+    const __m128 vcy = _mm_set1_ps(cy);
+    const __m128 r2 = _mm_set1_ps(radius * radius);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128i lo = _mm_set1_epi32(clipX0);
+    const __m128i hi = _mm_set1_epi32(clipX1);
+    const __m128i steps = _mm_set_epi32(3, 2, 1, 0);
+    const __m128i a = _mm_set1_epi32(static_cast<int>(add));
+    alignas(16) int32_t x0[4];
+    alignas(16) int32_t x1[4];
+    for (int py = y0; py < y1; py += 4) {
+        const __m128i rows = _mm_add_epi32(_mm_set1_epi32(py), steps);
+        const __m128 dy = _mm_sub_ps(_mm_add_ps(_mm_cvtepi32_ps(rows), _mm_set1_ps(0.5f)), vcy);
+        const __m128 d2 = _mm_sub_ps(r2, _mm_mul_ps(dy, dy));
+        const __m128 half = _mm_sqrt_ps(_mm_max_ps(d2, zero));
+        __m128i left = FirstCovered4(_mm_sub_ps(vcx, half));
+        __m128i right = FirstCovered4(_mm_add_ps(vcx, half));
+        left = Select(_mm_cmplt_epi32(left, lo), lo, left);
+        right = Select(_mm_cmpgt_epi32(right, hi), hi, right);
+        // Rows the disc misses get an empty span.
+        right = Select(_mm_castps_si128(_mm_cmplt_ps(d2, zero)), left, right);
+        _mm_store_si128(reinterpret_cast<__m128i*>(x0), left);
+        _mm_store_si128(reinterpret_cast<__m128i*>(x1), right);
+        const int rowsLeft = std::min(4, y1 - py);
+        for (int k = 0; k < rowsLeft; ++k) {
+            uint32_t* row = pixels + static_cast<size_t>(py + k) * width;
+            const __m128i spanLo = _mm_set1_epi32(x0[k]);
+            const __m128i spanHi = _mm_set1_epi32(x1[k]);
+            for (int g = 0; g < groups; ++g) {
+                const __m128i xs4 = _mm_add_epi32(_mm_set1_epi32(xs + 4 * g), steps);
+                const __m128i inside = _mm_andnot_si128(_mm_cmplt_epi32(xs4, spanLo), _mm_cmplt_epi32(xs4, spanHi));
+                __m128i* p = reinterpret_cast<__m128i*>(row + xs + 4 * g);
+                _mm_storeu_si128(p, _mm_adds_epu8(_mm_loadu_si128(p), _mm_and_si128(a, inside)));
+            }
+        }
+    }
+    return true;
+}
+#endif
+
+void AddParticles(uint32_t* pixels, int width, const IRect& clip, const ParticleBatch& batch) {
+    const uint32_t premul = Premultiply(batch.color);
+    const uint32_t r = (premul >> 16) & 0xFF;
+    const uint32_t g = (premul >> 8) & 0xFF;
+    const uint32_t b = premul & 0xFF;
+    const int clipX1 = clip.x + clip.w;
+    const int clipY1 = clip.y + clip.h;
+    for (size_t i = 0; i < batch.count; ++i) {
+        const float cx = batch.x[i];
+        const float cy = batch.y[i];
+        const float radius = batch.size[i];
+        const int y0 = std::max(FirstCovered(cy - radius), clip.y);
+        const int y1 = std::min(FirstCovered(cy + radius), clipY1);
+        if (y0 >= y1 || cx + radius < static_cast<float>(clip.x) || cx - radius > static_cast<float>(clipX1)) {
+            continue;
+        }
+        // Brightness in 1/256ths; the added alpha stays 0 so the target
+        // keeps its own.
+        const uint32_t scale = static_cast<uint32_t>(std::max(0.f, 1.f - batch.age[i]) * 256.f);
+        const uint32_t add = (((r * scale) >> 8) << 16) | (((g * scale) >> 8) << 8) | ((b * scale) >> 8);
+        if (add == 0) {
+            continue;
+        }
+#if defined(CGAME_SIMD_SSE2)
+        if (AddSmallDisc(pixels, width, clip.x, clipX1, y0, y1, cx, cy, radius, add)) {
+            continue;
+        }
+#endif
+        const float r2 = radius * radius;
+        for (int py = y0; py < y1; ++py) {
+            const float dy = static_cast<float>(py) + 0.5f - cy;
+            const float d2 = r2 - dy * dy;
+            if (d2 < 0.f) {
+                continue;
+            }
+            const float half = std::sqrt(d2);
+            const int x0 = std::max(FirstCovered(cx - half), clip.x);
+            const int x1 = std::min(FirstCovered(cx + half), clipX1);
+            if (x0 < x1) {
+                AddSpan(pixels + static_cast<size_t>(py) * width, width, x0, x1, add);
+            }
+        }
+    }
+}
+
+void SoftRenderer::DrawParticlesAdditive(const ParticleBatch& batch) {
+    AddParticles(pixels_.data(), width_, IRect{ clipX0_, clipY0_, clipX1_ - clipX0_, clipY1_ - clipY0_ }, batch);
+}
+
+TextureId SoftRenderer::CreateTexture(const Image& image) {
+    textures_.push_back(image);
+    return static_cast<TextureId>(textures_.size() - 1);
+}
+
+void SoftRenderer::DrawSprite(TextureId texture, const SpriteDraw& draw) {
+    if (texture < 0 || texture >= static_cast<TextureId>(textures_.size())) {
+        return;
+    }
+    const Image& img = textures_[texture];
+    if (img.width <= 0 || img.height <= 0 || draw.w <= 0.f || draw.h <= 0.f) {
+        return;
+    }
+
+    const float rad = draw.rotationDeg * 3.14159265f / 180.f;
+    const float c = std::cos(rad);
+    const float s = std::sin(rad);
+
+    // Screen-space bounds of the rotated rectangle.
+    const float lx[4] = { draw.x, draw.x + draw.w, draw.x + draw.w, draw.x };
+    const float ly[4] = { draw.y, draw.y, draw.y + draw.h, draw.y + draw.h };
+    float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f;
+    for (int i = 0; i < 4; ++i) {
+        const float sx = draw.originX + lx[i] * c - ly[i] * s;
+        const float sy = draw.originY + lx[i] * s + ly[i] * c;
+        minX = std::min(minX, sx);
+        maxX = std::max(maxX, sx);
+        minY = std::min(minY, sy);
+        maxY = std::max(maxY, sy);
+    }
+    const int x0 = std::max(FirstCovered(minX), clipX0_);
+    const int x1 = std::min(FirstCovered(maxX), clipX1_);
+    const int y0 = std::max(FirstCovered(minY), clipY0_);
+    const int y1 = std::min(FirstCovered(maxY), clipY1_);
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    // Inverse map: local = R(-angle) * (p - origin), then into texel space.
+    // Texel coordinates are affine in screen x, so each row steps u and v.
+    const float su = static_cast<float>(img.width) / draw.w;
+    const float sv = static_cast<float>(img.height) / draw.h;
+    const float duX = c * su;
+    const float dvX = -s * sv;
+    for (int py = y0; py < y1; ++py) {
+        const float px = static_cast<float>(x0) + 0.5f - draw.originX;
+        const float qy = static_cast<float>(py) + 0.5f - draw.originY;
+        float u = ((px * c + qy * s) - draw.x) * su;
+        float v = ((-px * s + qy * c) - draw.y) * sv;
+        uint32_t* row = pixels_.data() + static_cast<size_t>(py) * width_;
+        for (int x = x0; x < x1; ++x, u += duX, v += dvX) {
+            if (u < 0.f || v < 0.f) {
+                continue;
+            }
+            const int tu = static_cast<int>(u);
+            const int tv = static_cast<int>(v);
+            if (tu >= img.width || tv >= img.height) {
+                continue;
+            }
+            row[x] = BlendOver(row[x], img.pixels[static_cast<size_t>(tv) * img.width + tu]);
+        }
+    }
+}
+
+void SoftRenderer::BlitTexture(TextureId texture, int x, int y) {
+    if (texture < 0 || texture >= static_cast<TextureId>(textures_.size())) {
+        return;
+    }
+    const Image& img = textures_[texture];
+    const int x0 = std::max(x, clipX0_);
+    const int x1 = std::min(x + img.width, clipX1_);
+    const int y0 = std::max(y, clipY0_);
+    const int y1 = std::min(y + img.height, clipY1_);
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+#if defined(CGAME_SIMD_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi16(128);
+    const __m128i full = _mm_set1_epi16(255);
+#endif
+    const int n = x1 - x0;
+    for (int py = y0; py < y1; ++py) {
+        uint32_t* dst = pixels_.data() + static_cast<size_t>(py) * width_ + x0;
+        const uint32_t* src = img.pixels.data() + static_cast<size_t>(py - y) * img.width + (x0 - x);
+        int i = 0;
+#if defined(CGAME_SIMD_SSE2)
+        // Same rounding as BlendOver, with alpha broadcast per pixel.
+        for (; i + 4 <= n; i += 4) {
+            const __m128i s4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            const __m128i d4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+            const __m128i slo = _mm_unpacklo_epi8(s4, zero);
+            const __m128i shi = _mm_unpackhi_epi8(s4, zero);
+            const __m128i invLo = _mm_sub_epi16(full, _mm_shufflehi_epi16(_mm_shufflelo_epi16(slo, 0xFF), 0xFF));
+            const __m128i invHi = _mm_sub_epi16(full, _mm_shufflehi_epi16(_mm_shufflelo_epi16(shi, 0xFF), 0xFF));
+            __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d4, zero), invLo), bias);
+            __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d4, zero), invHi), bias);
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_add_epi8(_mm_packus_epi16(lo, hi), s4));
+        }
+#endif
+        for (; i < n; ++i) {
+            dst[i] = BlendOver(dst[i], src[i]);
+        }
+    }
+}
+
+void SoftRenderer::CopyTextureRect(TextureId texture, const IRect& rect) {
+    if (texture < 0 || texture >= static_cast<TextureId>(textures_.size())) {
+        return;
+    }
+    const Image& img = textures_[texture];
+    const int x0 = std::max(rect.x, clipX0_);
+    const int x1 = std::min(std::min(rect.x + rect.w, clipX1_), img.width);
+    const int y0 = std::max(rect.y, clipY0_);
+    const int y1 = std::min(std::min(rect.y + rect.h, clipY1_), img.height);
+    if (x0 >= x1) {
+        return;
+    }
+    for (int py = y0; py < y1; ++py) {
+        const uint32_t* src = img.pixels.data() + static_cast<size_t>(py) * img.width;
+        std::copy(src + x0, src + x1, pixels_.data() + static_cast<size_t>(py) * width_ + x0);
+    }
+}
+
+// Calls span(y, x0, x1) for every horizontal run of lit pixels in the
+// label. Glyph cells are 6x8 font pixels (5x7 plus spacing), scaled by a
+// whole factor so the cell height roughly matches sizePx. Runs never
+// overlap, so drawing them is the same as blending one glyph image.
+template <typename SpanFn>
+static void ForEachLabelSpan(const char* text, float x, float y, float w, float h, float sizePx, SpanFn&& span) {
+    const int scale = std::max(1, static_cast<int>(sizePx / 8.f + 0.5f));
+    const size_t len = std::strlen(text);
+    if (len == 0) {
+        return;
+    }
+    const int textW = static_cast<int>(len) * 6 * scale - scale;
+    const int left = static_cast<int>(std::floor(x + (w - static_cast<float>(textW)) * 0.5f));
+    const int top = static_cast<int>(std::floor(y));
+    const int bottom = static_cast<int>(std::ceil(y + h));
+
+    for (size_t i = 0; i < len; ++i) {
+        unsigned char ch = static_cast<unsigned char>(text[i]);
+        if (ch < 32 || ch > 126) {
+            ch = '?';
+        }
+        const uint8_t* glyph = kFont5x7[ch - 32];
+        const int gx = left + static_cast<int>(i) * 6 * scale;
+        for (int row = 0; row < 7; ++row) {
+            // Horizontal runs of set bits become spans.
+            int col = 0;
+            while (col < 5) {
+                if (!((glyph[col] >> row) & 1)) {
+                    ++col;
+                    continue;
+                }
+                int end = col;
+                while (end < 5 && ((glyph[end] >> row) & 1)) {
+                    ++end;
+                }
+                for (int sy = 0; sy < scale; ++sy) {
+                    const int py = top + row * scale + sy;
+                    if (py < bottom) {
+                        span(py, gx + col * scale, gx + end * scale);
+                    }
+                }
+                col = end;
+            }
+        }
+    }
+}
+
+void SoftRenderer::DrawLabel(const char* text, float x, float y, float w, float h, float sizePx, uint32_t color) {
+    const uint32_t premul = Premultiply(color);
+    ForEachLabelSpan(text, x, y, w, h, sizePx, [&](int py, int x0, int x1) { Span(py, x0, x1, premul); });
+}
+
+void SoftRenderer::RenderLabelTexture(TextureId texture, const char* text, float sizePx, uint32_t color) {
+    if (texture < 0 || texture >= static_cast<TextureId>(textures_.size())) {
+        return;
+    }
+    Image& img = textures_[texture];
+    std::fill(img.pixels.begin(), img.pixels.end(), 0u);
+    // Over a transparent pixel, source-over leaves the source color as is.
+    const uint32_t premul = Premultiply(color);
+    ForEachLabelSpan(text, 0.f, 0.f, static_cast<float>(img.width), static_cast<float>(img.height), sizePx,
+                     [&](int py, int x0, int x1) {
+                         x0 = std::max(x0, 0);
+                         x1 = std::min(x1, img.width);
+                         if (py >= 0 && py < img.height && x0 < x1) {
+                             uint32_t* row = img.pixels.data() + static_cast<size_t>(py) * img.width;
+                             std::fill(row + x0, row + x1, premul);
+                         }
+                     });
+}
+
+static bool WriteAll(FILE* f, const void* data, size_t size) {
+    return std::fwrite(data, 1, size, f) == size;
+}
+
+bool SaveFramePPM(const char* path, const uint32_t* pixels, int width, int height) {
+    FILE* f = std::fopen(path, "wb");
+    if (!f) {
+        return false;
+    }
+    bool ok = std::fprintf(f, "P6\n%d %d\n255\n", width, height) > 0;
+    std::vector<uint8_t> row(static_cast<size_t>(width) * 3);
+    for (int y = 0; y < height && ok; ++y) {
+        const uint32_t* src = pixels + static_cast<size_t>(y) * width;
+        for (int x = 0; x < width; ++x) {
+            row[x * 3 + 0] = static_cast<uint8_t>(src[x] >> 16);
+            row[x * 3 + 1] = static_cast<uint8_t>(src[x] >> 8);
+            row[x * 3 + 2] = static_cast<uint8_t>(src[x]);
+        }
+        ok = WriteAll(f, row.data(), row.size());
+    }
+    return std::fclose(f) == 0 && ok;
+}
+
+static uint32_t Crc32(uint32_t crc, const uint8_t* data, size_t size) {
+    static uint32_t table[256];
+    static bool init = false;
+    if (!init) {
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[n] = c;
+        }
+        init = true;
+    }
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void PutU32BE(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(static_cast<uint8_t>(v >> 24));
+    out.push_back(static_cast<uint8_t>(v >> 16));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+static void PutChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data) {
+    PutU32BE(out, static_cast<uint32_t>(data.size()));
+    const size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    PutU32BE(out, Crc32(0, out.data() + start, out.size() - start));
+}
+
+// PNG with uncompressed (stored) deflate blocks: larger files, but no zlib
+// dependency and trivially fast to write.
+bool SaveFramePNG(const char* path, const uint32_t* pixels, int width, int height) {
+    std::vector<uint8_t> raw;
+    raw.reserve(static_cast<size_t>(height) * (static_cast<size_t>(width) * 3 + 1));
+    for (int y = 0; y < height; ++y) {
+        raw.push_back(0); // filter: none
+        const uint32_t* src = pixels + static_cast<size_t>(y) * width;
+        for (int x = 0; x < width; ++x) {
+            raw.push_back(static_cast<uint8_t>(src[x] >> 16));
+            raw.push_back(static_cast<uint8_t>(src[x] >> 8));
+            raw.push_back(static_cast<uint8_t>(src[x]));
+        }
+    }
+
+    std::vector<uint8_t> z;
+    z.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    z.push_back(0x78);
+    z.push_back(0x01);
+    size_t pos = 0;
+    do {
+        const size_t n = std::min<size_t>(65535, raw.size() - pos);
+        const bool last = pos + n == raw.size();
+        z.push_back(last ? 1 : 0);
+        z.push_back(static_cast<uint8_t>(n));
+        z.push_back(static_cast<uint8_t>(n >> 8));
+        z.push_back(static_cast<uint8_t>(~n));
+        z.push_back(static_cast<uint8_t>(~n >> 8));
+        z.insert(z.end(), raw.begin() + pos, raw.begin() + pos + n);
+        pos += n;
+    } while (pos < raw.size());
+    uint32_t s1 = 1, s2 = 0;
+    for (uint8_t b : raw) {
+        s1 = (s1 + b) % 65521;
+        s2 = (s2 + s1) % 65521;
+    }
+    PutU32BE(z, (s2 << 16) | s1);
+
+    std::vector<uint8_t> ihdr;
+    PutU32BE(ihdr, static_cast<uint32_t>(width));
+    PutU32BE(ihdr, static_cast<uint32_t>(height));
+    ihdr.push_back(8); // bit depth
+    ihdr.push_back(2); // color type: RGB
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+
+    static const uint8_t sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::vector<uint8_t> file(sig, sig + 8);
+    PutChunk(file, "IHDR", ihdr);
+    PutChunk(file, "IDAT", z);
+    PutChunk(file, "IEND", std::vector<uint8_t>());
+
+    FILE* f = std::fopen(path, "wb");
+    if (!f) {
+        return false;
+    }
+    bool ok = WriteAll(f, file.data(), file.size());
+    return std::fclose(f) == 0 && ok;
+}
+
+uint64_t FrameChecksum(const uint32_t* pixels, size_t count) {
+    uint64_t h = 14695981039346656037ull;
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(pixels);
+    for (size_t i = 0; i < count * sizeof(uint32_t); ++i) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
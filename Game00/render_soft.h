@@ -0,0 +1,72 @@
+#pragma once
+
+// CPU rasterizer into a premultiplied 0xAARRGGBB framebuffer (BGRA bytes on
+// little-endian, the same layout as a 32-bit DIB section). Solid spans are
+// filled and blended four pixels at a time with SSE2 when available.
+//
+// Sprites are sampled nearest-neighbour and text uses a built-in 5x7 font,
+// so output is deterministic and can be checked pixel for pixel.
+
+#include "render.h"
+
+#include <cstddef>
+
+class SoftRenderer : public Renderer {
+public:
+    SoftRenderer(int width, int height);
+
+    int Width() const override { return width_; }
+    int Height() const override { return height_; }
+
+    void BeginFrame() override {}
+    void EndFrame() override {}
+    void EndFrameRects(const IRect*, int) override {}
+
+    void SetClipRect(const IRect& rect) override;
+    void ResetClip() override;
+
+    void Clear(uint32_t color) override;
+    void FillRectangle(float x, float y, float w, float h, uint32_t color) override;
+    void FillCircle(float cx, float cy, float radius, uint32_t color) override;
+    void DrawLine(float x0, float y0, float x1, float y1, float width, uint32_t color) override;
+    void DrawParticlesAdditive(const ParticleBatch& batch) override;
+
+    TextureId CreateTexture(const Image& image) override;
+    void DrawSprite(TextureId texture, const SpriteDraw& draw) override;
+    void BlitTexture(TextureId texture, int x, int y) override;
+    void CopyTextureRect(TextureId texture, const IRect& rect) override;
+
+    void DrawLabel(const char* text, float x, float y, float w, float h, float sizePx, uint32_t color) override;
+    void RenderLabelTexture(TextureId texture, const char* text, float sizePx, uint32_t color) override;
+
+    const uint32_t* Pixels() const { return pixels_.data(); }
+    uint32_t* Pixels() { return pixels_.data(); }
+
+private:
+    void Span(int y, int x0, int x1, uint32_t premul);
+
+    int width_;
+    int height_;
+    // Drawing is limited to [clipX0_, clipX1_) x [clipY0_, clipY1_).
+    int clipX0_;
+    int clipY0_;
+    int clipX1_;
+    int clipY1_;
+    std::vector<uint32_t> pixels_;
+    std::vector<Image> textures_;
+};
+
+// Premultiplies a straight-alpha 0xAARRGGBB color.
+uint32_t Premultiply(uint32_t color);
+
+// DrawParticlesAdditive on any framebuffer in the SoftRenderer layout,
+// touching only pixels inside `clip`. GdiplusRenderer runs it on its DIB
+// section, since GDI+ has no additive blending.
+void AddParticles(uint32_t* pixels, int width, const IRect& clip, const ParticleBatch& batch);
+
+// Frame dumps. Alpha is dropped; both write 8-bit RGB.
+bool SaveFramePPM(const char* path, const uint32_t* pixels, int width, int height);
+bool SaveFramePNG(const char* path, const uint32_t* pixels, int width, int height);
+
+// FNV-1a over the pixels, for pixel-exact output checks.
+uint64_t FrameChecksum(const uint32_t* pixels, size_t count);
@@ -0,0 +1,80 @@
+#include "render_state.h"
+
+#include <algorithm>
+
+static void CaptureProjectiles(const ProjectileSoA& p, std::vector<Vec2>& prev, std::vector<Vec2>& pos) {
+    if (prev.capacity() < p.capacity) {
+        prev.reserve(p.capacity);
+        pos.reserve(p.capacity);
+    }
+    prev.resize(p.count);
+    pos.resize(p.count);
+    for (size_t i = 0; i < p.count; ++i) {
+        prev[i] = { p.prevX[i], p.prevY[i] };
+        pos[i] = { p.x[i], p.y[i] };
+    }
+}
+
+void CaptureRenderState(const World& world, RenderState& state) {
+    state.cfg = world.cfg;
+    state.tanks = world.tanks;
+    state.lives = world.lives;
+    state.score = world.score;
+    state.gameOver = world.gameOver;
+    state.helicopters.resize(world.helicopters.size());
+    for (size_t k = 0; k < world.helicopters.size(); ++k) {
+        state.helicopters[k] = HelicopterAt(world, k);
+    }
+    CaptureProjectiles(world.shells, state.shellPrev, state.shellPos);
+    CaptureProjectiles(world.bombs, state.bombPrev, state.bombPos);
+    state.aiStepUs = static_cast<double>(world.ai.stepNs) * 1e-3;
+    state.aiMaxWait = world.ai.maxWait;
+}
+
+void PushImpact(ImpactLog& log, const ImpactEvent& e) {
+    if (log.count == kImpactLogSize) {
+        log.events[log.first] = e;
+        log.first = (log.first + 1) % kImpactLogSize;
+    } else {
+        log.events[(log.first + log.count) % kImpactLogSize] = e;
+        ++log.count;
+    }
+    ++log.total;
+}
+
+void ClearImpactLog(ImpactLog& log) {
+    log.first = 0;
+    log.count = 0;
+    log.total = 0;
+}
+
+const ImpactEvent& ImpactAt(const ImpactLog& log, size_t i) {
+    return log.events[(log.first + i) % kImpactLogSize];
+}
+
+void LogImpacts(ImpactLog& log, const World& world, uint64_t tick) {
+    for (const Impact& impact : world.impacts) {
+        PushImpact(log, { impact, tick });
+    }
+}
+
+void CopyNewImpacts(ImpactLog& to, const ImpactLog& from) {
+    if (to.total > from.total) {
+        ClearImpactLog(to);
+    }
+    const size_t fresh = static_cast<size_t>(std::min<uint64_t>(from.total - to.total, from.count));
+    for (size_t i = from.count - fresh; i < from.count; ++i) {
+        PushImpact(to, ImpactAt(from, i));
+    }
+    to.total = from.total;
+}
+
+Vec2 TurretBase(const RenderState& state, size_t tank) {
+    const Vec2 center = state.tanks[tank].center;
+    return { center.x, center.y - state.cfg.tankHeight };
+}
+
+float TurretAngleAt(const RenderState& state, size_t tank, float alpha) {
+    const Tank& t = state.tanks[tank];
+    return t.prevTurretAngleDeg + (t.turretAngleDeg - t.prevTurretAngleDeg) * alpha;
+}
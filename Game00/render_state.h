@@ -0,0 +1,78 @@
+#pragma once
+
+// Everything the scene needs to draw one simulation step, copied out of the
+// World so another thread can draw it while the simulation moves on.
+// Capturing reuses the buffers of the previous capture, so it does not
+// allocate once they have grown to the pool sizes.
+
+#include "sim.h"
+
+#include <vector>
+
+// A hit and the step (0-based) it happened on.
+struct ImpactEvent {
+    Impact impact;
+    uint64_t tick;
+};
+
+// Hits kept for consumers that may see only some of the published states.
+const size_t kImpactLogSize = 256;
+
+// Ring of the last kImpactLogSize hits, oldest at `first`.
+struct ImpactLog {
+    ImpactEvent events[kImpactLogSize];
+    size_t first = 0;
+    size_t count = 0;
+    // Hits ever logged; a copy compares it with its source to find what
+    // it has not seen yet.
+    uint64_t total = 0;
+};
+
+struct RenderState {
+    SimConfig cfg;
+    std::vector<Tank> tanks;
+    // The tank this view's player drives; the HUD and the aim overlay
+    // follow it.
+    int localTank = 0;
+    int lives = 0;
+    int score = 0;
+    bool gameOver = false;
+
+    std::vector<Helicopter> helicopters;
+    // Previous and current position of every live projectile.
+    std::vector<Vec2> shellPrev;
+    std::vector<Vec2> shellPos;
+    std::vector<Vec2> bombPrev;
+    std::vector<Vec2> bombPos;
+
+    ImpactLog impacts;
+
+    // Steps simulated so far.
+    uint64_t tick = 0;
+    // When the state was published (steady clock, seconds) and how much
+    // simulation time had accumulated past the step then; together they
+    // give the render interpolation factor.
+    double publishSeconds = 0.0;
+    double leftoverSeconds = 0.0;
+    // Average cost of a StepWorld call over the last published batch.
+    double simStepMs = 0.0;
+    // Wall time of the helicopter AI in the last step, and the most steps
+    // any helicopter had gone without deciding.
+    double aiStepUs = 0.0;
+    uint32_t aiMaxWait = 0;
+};
+
+void CaptureRenderState(const World& world, RenderState& state);
+// Appends the hits of the step just run to `log`, dropping the oldest past
+// kImpactLogSize.
+void LogImpacts(ImpactLog& log, const World& world, uint64_t tick);
+void PushImpact(ImpactLog& log, const ImpactEvent& e);
+void ClearImpactLog(ImpactLog& log);
+// The i-th oldest hit, i < log.count.
+const ImpactEvent& ImpactAt(const ImpactLog& log, size_t i);
+// Brings `to`, an earlier copy of `from` or an empty log, up to date by
+// appending only the hits logged since.
+void CopyNewImpacts(ImpactLog& to, const ImpactLog& from);
+
+Vec2 TurretBase(const RenderState& state, size_t tank);
+float TurretAngleAt(const RenderState& state, size_t tank, float alpha);
@@ -0,0 +1,262 @@
+#include "replay.h"
+#include "snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+
+static const char kReplayMagic[4] = { 'C', 'G', 'R', 'P' };
+static const uint32_t kReplayVersion = 3;
+// Longest log that loads, about 13 days at 120 Hz; a corrupt run length
+// must not become a huge allocation.
+static const uint64_t kMaxReplayTicks = uint64_t(1) << 27;
+
+enum ReplayRecordTag : uint8_t {
+    TagInputRun = 'I',
+    TagKeyframe = 'K',
+    TagRestart = 'S',
+};
+
+static_assert(kFirePhases <= (256 >> ReplayFirePhaseShift), "the fire phase must fit its bits");
+
+uint8_t PackInput(const SimInput& input) {
+    // The phase only means something with fire down; dropping it otherwise
+    // keeps runs of held keys long.
+    const int phase = input.fire ? input.firePhase % kFirePhases : 0;
+    return static_cast<uint8_t>((input.left ? ReplayLeft : 0) | (input.right ? ReplayRight : 0) | (input.fire ? ReplayFire : 0) |
+                                (phase << ReplayFirePhaseShift));
+}
+
+SimInput UnpackInput(uint8_t bits) {
+    SimInput input{};
+    input.left = (bits & ReplayLeft) != 0;
+    input.right = (bits & ReplayRight) != 0;
+    input.fire = (bits & ReplayFire) != 0;
+    input.firePhase = static_cast<uint8_t>(bits >> ReplayFirePhaseShift);
+    return input;
+}
+
+// LEB128: seven bits per byte, high bit set on all but the last.
+static void WriteVarint(FILE* f, uint64_t v) {
+    uint8_t buf[10];
+    size_t n = 0;
+    do {
+        uint8_t b = static_cast<uint8_t>(v & 0x7f);
+        v >>= 7;
+        buf[n++] = static_cast<uint8_t>(b | (v ? 0x80 : 0));
+    } while (v);
+    std::fwrite(buf, 1, n, f);
+}
+
+static void FlushRun(ReplayRecorder& rec) {
+    if (rec.runLength == 0) {
+        return;
+    }
+    std::fputc(TagInputRun, rec.file);
+    std::fputc(rec.runInput, rec.file);
+    WriteVarint(rec.file, rec.runLength);
+    rec.runLength = 0;
+}
+
+bool OpenReplayRecorder(ReplayRecorder& rec, const char* path, const World& world, uint32_t seed,
+                        uint32_t keyframeInterval) {
+    rec.file = std::fopen(path, "wb");
+    if (!rec.file) {
+        return false;
+    }
+    rec.keyframeInterval = std::max(keyframeInterval, 1u);
+    rec.tick = 0;
+    rec.runLength = 0;
+    rec.scratch.reserve(MaxSnapshotSize(world.cfg));
+
+    const uint32_t header[4] = { kReplayVersion, seed, rec.keyframeInterval, static_cast<uint32_t>(sizeof(SimConfig)) };
+    std::fwrite(kReplayMagic, 1, sizeof(kReplayMagic), rec.file);
+    std::fwrite(header, sizeof(header), 1, rec.file);
+    std::fwrite(&world.cfg, sizeof(SimConfig), 1, rec.file);
+    return true;
+}
+
+void RecordTick(ReplayRecorder& rec, const World& world, const SimInput& input) {
+    if (!rec.file) {
+        return;
+    }
+    if (rec.tick % rec.keyframeInterval == 0) {
+        FlushRun(rec);
+        SaveSnapshot(world, rec.scratch);
+        const uint64_t checksum = WorldChecksum(world);
+        std::fputc(TagKeyframe, rec.file);
+        WriteVarint(rec.file, rec.tick);
+        std::fwrite(&checksum, sizeof(checksum), 1, rec.file);
+        WriteVarint(rec.file, rec.scratch.size());
+        std::fwrite(rec.scratch.data(), 1, rec.scratch.size(), rec.file);
+        std::fflush(rec.file);
+    }
+    const uint8_t bits = PackInput(input);
+    if (rec.runLength && bits != rec.runInput) {
+        FlushRun(rec);
+    }
+    rec.runInput = bits;
+    ++rec.runLength;
+    ++rec.tick;
+}
+
+void RecordRestart(ReplayRecorder& rec, uint32_t seed) {
+    if (!rec.file) {
+        return;
+    }
+    FlushRun(rec);
+    std::fputc(TagRestart, rec.file);
+    WriteVarint(rec.file, rec.tick);
+    std::fwrite(&seed, sizeof(seed), 1, rec.file);
+}
+
+void CloseReplayRecorder(ReplayRecorder& rec) {
+    if (!rec.file) {
+        return;
+    }
+    FlushRun(rec);
+    std::fclose(rec.file);
+    rec.file = nullptr;
+}
+
+struct ByteReader {
+    const uint8_t* at;
+    const uint8_t* end;
+};
+
+static bool ReadBytes(ByteReader& r, void* out, size_t size) {
+    if (static_cast<size_t>(r.end - r.at) < size) {
+        return false;
+    }
+    std::memcpy(out, r.at, size);
+    r.at += size;
+    return true;
+}
+
+static bool ReadVarint(ByteReader& r, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && r.at < r.end; shift += 7) {
+        const uint8_t b = *r.at++;
+        v |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool LoadReplay(const char* path, ReplayLog& log) {
+    FILE* f = std::fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+    std::vector<uint8_t> bytes;
+    uint8_t chunk[65536];
+    size_t n = 0;
+    while ((n = std::fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        bytes.insert(bytes.end(), chunk, chunk + n);
+    }
+    std::fclose(f);
+
+    ByteReader r{ bytes.data(), bytes.data() + bytes.size() };
+    char magic[4];
+    uint32_t header[4];
+    if (!ReadBytes(r, magic, sizeof(magic)) || std::memcmp(magic, kReplayMagic, sizeof(magic)) != 0 ||
+        !ReadBytes(r, header, sizeof(header)) || header[0] != kReplayVersion || header[3] != sizeof(SimConfig) ||
+        !ReadBytes(r, &log.cfg, sizeof(SimConfig)) || !ValidSimConfig(log.cfg)) {
+        return false;
+    }
+    log.seed = header[1];
+    log.keyframeInterval = header[2];
+    log.inputs.clear();
+    log.keyframes.clear();
+    log.restarts.clear();
+
+    // Stops at the first incomplete record; everything before it is kept.
+    while (r.at < r.end) {
+        const uint8_t tag = *r.at++;
+        if (tag == TagInputRun) {
+            uint8_t bits = 0;
+            uint64_t length = 0;
+            if (!ReadBytes(r, &bits, 1) || !ReadVarint(r, length) || length > kMaxReplayTicks - log.inputs.size()) {
+                break;
+            }
+            log.inputs.insert(log.inputs.end(), static_cast<size_t>(length), bits);
+        } else if (tag == TagKeyframe) {
+            ReplayKeyframe kf;
+            uint64_t size = 0;
+            if (!ReadVarint(r, kf.tick) || !ReadBytes(r, &kf.checksum, sizeof(kf.checksum)) || !ReadVarint(r, size) ||
+                static_cast<uint64_t>(r.end - r.at) < size || kf.tick != log.inputs.size()) {
+                break;
+            }
+            kf.state.assign(r.at, r.at + size);
+            r.at += size;
+            log.keyframes.push_back(std::move(kf));
+        } else if (tag == TagRestart) {
+            ReplayRestart restart;
+            if (!ReadVarint(r, restart.tick) || !ReadBytes(r, &restart.seed, sizeof(restart.seed))) {
+                break;
+            }
+            log.restarts.push_back(restart);
+        } else {
+            break;
+        }
+    }
+    return true;
+}
+
+bool InitReplayPlayer(ReplayPlayer& player, const ReplayLog& log) {
+    player.log = &log;
+    player.tick = 0;
+    player.nextKeyframe = 0;
+    player.nextRestart = 0;
+    player.desyncTick = ~0ull;
+    InitWorld(player.world, log.cfg, log.seed);
+    return true;
+}
+
+bool StepReplay(ReplayPlayer& player) {
+    const ReplayLog& log = *player.log;
+    if (player.tick >= log.inputs.size()) {
+        return false;
+    }
+    World& world = player.world;
+    while (player.nextRestart < log.restarts.size() && log.restarts[player.nextRestart].tick == player.tick) {
+        InitWorld(world, world.cfg, log.restarts[player.nextRestart].seed);
+        ++player.nextRestart;
+    }
+    if (player.nextKeyframe < log.keyframes.size() && log.keyframes[player.nextKeyframe].tick == player.tick) {
+        if (player.desyncTick == ~0ull && WorldChecksum(world) != log.keyframes[player.nextKeyframe].checksum) {
+            player.desyncTick = player.tick;
+        }
+        ++player.nextKeyframe;
+    }
+    StepWorld(world, 1.f / world.cfg.tickRateHz, UnpackInput(log.inputs[static_cast<size_t>(player.tick)]));
+    ++player.tick;
+    return true;
+}
+
+uint64_t SeekReplay(ReplayPlayer& player, uint64_t tick) {
+    const ReplayLog& log = *player.log;
+    tick = std::min<uint64_t>(tick, log.inputs.size());
+
+    auto kf = std::upper_bound(log.keyframes.begin(), log.keyframes.end(), tick,
+                               [](uint64_t t, const ReplayKeyframe& k) { return t < k.tick; });
+    if (kf == log.keyframes.begin() || !LoadSnapshot(player.world, kf[-1].state.data(), kf[-1].state.size())) {
+        InitReplayPlayer(player, log);
+    } else {
+        --kf;
+        player.tick = kf->tick;
+        player.nextKeyframe = static_cast<size_t>(kf - log.keyframes.begin()) + 1;
+        // Restarts at the keyframe's own tick are already in its state.
+        player.nextRestart = static_cast<size_t>(
+            std::upper_bound(log.restarts.begin(), log.restarts.end(), kf->tick,
+                             [](uint64_t t, const ReplayRestart& s) { return t < s.tick; }) -
+            log.restarts.begin());
+    }
+
+    const uint64_t from = player.tick;
+    while (player.tick < tick) {
+        StepReplay(player);
+    }
+    return tick - from;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+// Session recording and playback. A replay log holds the seed and config a
+// session started from, the input of every step, every restart, and a full
+// snapshot (snapshot.h) every keyframeInterval steps. Playing the inputs
+// back through StepWorld reproduces the session bit for bit; the keyframes
+// let a player jump to any step without simulating from the start, and
+// double as desync checks while playing.
+//
+// File layout: a header, then a stream of tagged records in tick order.
+// Inputs are run-length encoded, so a held key costs a few bytes however
+// long it is held. The file is flushed at every keyframe, so a log cut off
+// by a crash still plays up to its last complete record.
+
+#include "sim.h"
+
+#include <cstdio>
+#include <vector>
+#include <cstdint>
+
+// Input bits as stored in the log. The fire phase takes the top five.
+enum ReplayInputBits {
+    ReplayLeft = 1,
+    ReplayRight = 2,
+    ReplayFire = 4,
+    ReplayFirePhaseShift = 3,
+};
+
+uint8_t PackInput(const SimInput& input);
+SimInput UnpackInput(uint8_t bits);
+
+struct ReplayRecorder {
+    FILE* file = nullptr;
+    uint32_t keyframeInterval = 0;
+    // Next step to be recorded.
+    uint64_t tick = 0;
+    // Pending run of identical inputs, written when the input changes.
+    uint8_t runInput = 0;
+    uint64_t runLength = 0;
+    std::vector<uint8_t> scratch;
+};
+
+// `world` must have just been created with InitWorld(world, cfg, seed).
+bool OpenReplayRecorder(ReplayRecorder& rec, const char* path, const World& world, uint32_t seed,
+                        uint32_t keyframeInterval);
+// Call once per step, before StepWorld, with the input the step uses.
+// Writes a keyframe of `world` first when one is due.
+void RecordTick(ReplayRecorder& rec, const World& world, const SimInput& input);
+// Call right after InitWorld(world, world.cfg, seed) restarted the game.
+void RecordRestart(ReplayRecorder& rec, uint32_t seed);
+void CloseReplayRecorder(ReplayRecorder& rec);
+
+struct ReplayKeyframe {
+    // The state before step `tick` ran.
+    uint64_t tick = 0;
+    uint64_t checksum = 0;
+    std::vector<uint8_t> state;
+};
+
+struct ReplayRestart {
+    uint64_t tick = 0;
+    uint32_t seed = 0;
+};
+
+struct ReplayLog {
+    SimConfig cfg;
+    uint32_t seed = 0;
+    uint32_t keyframeInterval = 0;
+    // One packed input (PackInput) per step.
+    std::vector<uint8_t> inputs;
+    std::vector<ReplayKeyframe> keyframes;
+    std::vector<ReplayRestart> restarts;
+};
+
+// False if the file is missing or the header is bad. A truncated or
+// corrupt tail is dropped.
+bool LoadReplay(const char* path, ReplayLog& log);
+
+struct ReplayPlayer {
+    const ReplayLog* log = nullptr;
+    World world;
+    // Next step to run.
+    uint64_t tick = 0;
+    size_t nextKeyframe = 0;
+    size_t nextRestart = 0;
+    // First step whose state did not match its keyframe, or ~0 if none.
+    uint64_t desyncTick = ~0ull;
+};
+
+// Starts at tick 0.
+bool InitReplayPlayer(ReplayPlayer& player, const ReplayLog& log);
+// Runs one logged step; false once the log is exhausted.
+bool StepReplay(ReplayPlayer& player);
+// Restores the nearest keyframe at or before `tick` and steps forward to it.
+// Returns the number of steps that had to be simulated.
+uint64_t SeekReplay(ReplayPlayer& player, uint64_t tick);
@@ -0,0 +1,129 @@
+#include "rewind.h"
+
+#include "delta.h"
+#include "snapshot.h"
+
+#include <cstring>
+
+// A delta has to save at least 1/kMinSaving of the snapshot, or the next
+// kRawStreak frames are stored raw without trying.
+static const size_t kMinSaving = 8;
+static const int kRawStreak = 15;
+
+void InitRewindBuffer(RewindBuffer& rb, const SimConfig& cfg, size_t maxFrames, size_t byteBudget) {
+    rb.maxSnapshot = MaxSnapshotSize(cfg);
+    rb.bytes.assign(byteBudget, 0);
+    rb.frames.assign(maxFrames, RewindFrame{});
+    rb.first = rb.count = rb.writeAt = rb.bytesUsed = 0;
+    rb.rawStreak = 0;
+    rb.current.clear();
+    rb.current.reserve(rb.maxSnapshot);
+    rb.previous.clear();
+    rb.previous.reserve(rb.maxSnapshot);
+    // A delta is at most a few varints longer than the snapshot it codes.
+    rb.delta.clear();
+    rb.delta.reserve(rb.maxSnapshot + 32);
+}
+
+static void DropOldest(RewindBuffer& rb) {
+    rb.bytesUsed -= rb.frames[rb.first].size;
+    rb.first = (rb.first + 1) % rb.frames.size();
+    --rb.count;
+}
+
+static void DropAll(RewindBuffer& rb) {
+    rb.first = rb.count = rb.writeAt = rb.bytesUsed = 0;
+}
+
+static bool Overlaps(const RewindFrame& f, size_t at, size_t size) {
+    return f.offset < at + size && at < f.offset + f.size;
+}
+
+static void PushFrame(RewindBuffer& rb, const uint8_t* data, size_t size, bool delta) {
+    if (rb.frames.empty() || size > rb.bytes.size()) {
+        // Older frames decode against this one, so they go with it.
+        DropAll(rb);
+        return;
+    }
+    // Frames are written front to back, so the ones from the previous lap
+    // ahead of writeAt are the oldest, in order.
+    size_t at = rb.writeAt;
+    if (at + size > rb.bytes.size()) {
+        while (rb.count && rb.frames[rb.first].offset >= at) {
+            DropOldest(rb);
+        }
+        at = 0;
+    }
+    while (rb.count && Overlaps(rb.frames[rb.first], at, size)) {
+        DropOldest(rb);
+    }
+    if (rb.count == rb.frames.size()) {
+        DropOldest(rb);
+    }
+    std::memcpy(rb.bytes.data() + at, data, size);
+    RewindFrame& f = rb.frames[(rb.first + rb.count) % rb.frames.size()];
+    f.offset = at;
+    f.size = size;
+    f.delta = delta;
+    ++rb.count;
+    rb.bytesUsed += size;
+    rb.writeAt = at + size;
+}
+
+void CaptureRewind(RewindBuffer& rb, const World& world) {
+    rb.previous.swap(rb.current);
+    SaveSnapshot(world, rb.current);
+    if (rb.previous.empty()) {
+        return;
+    }
+    const uint8_t* data = rb.previous.data();
+    size_t size = rb.previous.size();
+    bool delta = false;
+    if (rb.compress && rb.rawStreak > 0) {
+        --rb.rawStreak;
+    } else if (rb.compress) {
+        rb.delta.clear();
+        EncodeDelta(rb.current.data(), rb.current.size(), rb.previous.data(), rb.previous.size(), rb.delta);
+        if (rb.delta.size() < size) {
+            data = rb.delta.data();
+            size = rb.delta.size();
+            delta = true;
+        }
+        if (rb.delta.size() > rb.previous.size() - rb.previous.size() / kMinSaving) {
+            rb.rawStreak = kRawStreak;
+        }
+    }
+    PushFrame(rb, data, size, delta);
+}
+
+bool RewindStep(RewindBuffer& rb, World& world) {
+    if (!rb.count) {
+        return false;
+    }
+    const RewindFrame f = rb.frames[(rb.first + rb.count - 1) % rb.frames.size()];
+    const uint8_t* data = rb.bytes.data() + f.offset;
+    bool ok = true;
+    if (f.delta) {
+        ok = DecodeDelta(rb.current.data(), rb.current.size(), data, f.size, rb.maxSnapshot, rb.previous);
+    } else {
+        rb.previous.assign(data, data + f.size);
+    }
+    ok = ok && LoadSnapshot(world, rb.previous.data(), rb.previous.size());
+    if (!ok) {
+        // Only a bug gets here; stay in the present rather than leave the
+        // world half loaded.
+        LoadSnapshot(world, rb.current.data(), rb.current.size());
+        DropAll(rb);
+        return false;
+    }
+    rb.current.swap(rb.previous);
+    --rb.count;
+    rb.bytesUsed -= f.size;
+    rb.writeAt = f.offset;
+    return true;
+}
+
+void ResetRewind(RewindBuffer& rb, const World& world) {
+    DropAll(rb);
+    SaveSnapshot(world, rb.current);
+}
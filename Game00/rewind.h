@@ -0,0 +1,58 @@
+#pragma once
+
+// The last few seconds of play, kept so they can be played backwards.
+//
+// Every step the world is saved as a snapshot (snapshot.h), and the
+// snapshot of the step before is stored, delta-coded (delta.h) against the
+// new one, in a byte ring allocated up front. Neighbouring steps differ in
+// a few bytes, so a frame is a small fraction of a snapshot. Stepping back
+// decodes the newest frame against the current snapshot and loads it,
+// which needs no keyframes: the chain always starts from the present. When
+// the ring is full the oldest frames are dropped.
+
+#include "sim.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct RewindFrame {
+    size_t offset = 0;
+    size_t size = 0;
+    // Stored as a delta against the next newer state, or as the snapshot
+    // itself when the delta came out larger.
+    bool delta = false;
+};
+
+struct RewindBuffer {
+    // Off stores every frame as a full snapshot.
+    bool compress = true;
+    // Captures left before trying a delta again after one saved little;
+    // dense moving projectiles change nearly every byte.
+    int rawStreak = 0;
+    size_t maxSnapshot = 0;
+    std::vector<uint8_t> bytes;
+    // Ring of frames, oldest at `first`.
+    std::vector<RewindFrame> frames;
+    size_t first = 0;
+    size_t count = 0;
+    size_t writeAt = 0;
+    size_t bytesUsed = 0;
+    // The snapshot of the newest state, which the newest frame decodes
+    // against, and scratch for the one before it and its delta.
+    std::vector<uint8_t> current;
+    std::vector<uint8_t> previous;
+    std::vector<uint8_t> delta;
+};
+
+// Room for `maxFrames` steps in `byteBudget` bytes, for worlds made with
+// `cfg`. Nothing is allocated after this.
+void InitRewindBuffer(RewindBuffer& rb, const SimConfig& cfg, size_t maxFrames, size_t byteBudget);
+// Call after every step. The first call only records the starting state.
+void CaptureRewind(RewindBuffer& rb, const World& world);
+// Puts `world` back one step. False, leaving `world` alone, when no
+// frames are left.
+bool RewindStep(RewindBuffer& rb, World& world);
+// Forgets every frame and starts over from `world`; for when the world
+// changed by anything but a step, like loading a save.
+void ResetRewind(RewindBuffer& rb, const World& world);
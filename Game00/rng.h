@@ -0,0 +1,43 @@
+#pragma once
+
+// PCG32 (O'Neill, pcg-random.org) plus the two distributions the simulation
+// needs. The standard library engines and distributions are not specified
+// bit for bit across implementations, and mt19937's 2.5 KB state is too big
+// to put in every replay keyframe; this is 16 bytes and gives the same
+// sequence on every compiler.
+
+#include <cstdint>
+
+struct Pcg32 {
+    uint64_t state = 0x853c49e6748fea9bull;
+    uint64_t inc = 0xda3e39cb94b95bdbull;
+};
+
+inline uint32_t NextU32(Pcg32& rng) {
+    const uint64_t old = rng.state;
+    rng.state = old * 6364136223846793005ull + rng.inc;
+    const uint32_t xorshifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+    const uint32_t rot = static_cast<uint32_t>(old >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((0u - rot) & 31u));
+}
+
+inline void SeedPcg32(Pcg32& rng, uint64_t seed, uint64_t stream = 54u) {
+    rng.state = 0u;
+    rng.inc = (stream << 1u) | 1u;
+    NextU32(rng);
+    rng.state += seed;
+    NextU32(rng);
+}
+
+// Uniform in [lo, hi), from the top 24 bits so every value is exact.
+inline float UniformFloat(Pcg32& rng, float lo, float hi) {
+    const float unit = static_cast<float>(NextU32(rng) >> 8) * (1.f / 16777216.f);
+    return lo + (hi - lo) * unit;
+}
+
+// Uniform in [lo, hi]. The modulo bias is below 2^-24 for the small ranges
+// used here.
+inline int UniformInt(Pcg32& rng, int lo, int hi) {
+    const uint32_t range = static_cast<uint32_t>(hi - lo) + 1u;
+    return lo + static_cast<int>(NextU32(rng) % range);
+}
@@ -0,0 +1,477 @@
+#include "scene.h"
+#include "render_soft.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+static const int kTileSize = 16;
+// Past this many rectangles one full redraw is cheaper than the clipping.
+static const size_t kMaxDirtyRects = 64;
+
+static uint32_t SkyColor() {
+    return Argb(255, 18, 26, 36);
+}
+
+static void DrawBackground(Renderer& r, const RenderState& state) {
+    const SimConfig& cfg = state.cfg;
+    r.Clear(SkyColor());
+    r.FillRectangle(0.f, state.tanks[0].center.y - cfg.tankHeight * 0.5f + 20.f, cfg.screenWidth, cfg.screenHeight, Argb(255, 40, 70, 50));
+}
+
+static void DrawTank(Renderer& r, const RenderState& state, size_t tank, float turretAngleDeg, const SceneAssets& assets) {
+    const SimConfig& cfg = state.cfg;
+    const Vec2 tankCenter = state.tanks[tank].center;
+    const Vec2 turretBase = TurretBase(state, tank);
+    if (assets.tankBody && assets.tankBarrel) {
+        DrawCachedSprite(r, *assets.tankBarrel, 90.f - turretAngleDeg, turretBase.x, turretBase.y);
+        DrawCachedSprite(r, *assets.tankBody, 0.f, tankCenter.x, tankCenter.y);
+    } else {
+        const float turretRad = turretAngleDeg * 3.14159265f / 180.f;
+        const Vec2 turretTip = turretBase + Vec2{ std::cos(turretRad), -std::sin(turretRad) } * cfg.turretLength;
+        r.FillRectangle(tankCenter.x - cfg.tankWidth * 0.5f, tankCenter.y - cfg.tankHeight, cfg.tankWidth, cfg.tankHeight, Argb(255, 70, 120, 60));
+        r.DrawLine(turretBase.x, turretBase.y, turretTip.x, turretTip.y, 10.f, Argb(255, 180, 220, 200));
+    }
+}
+
+static void DrawHelicopter(Renderer& r, const SimConfig& cfg, Vec2 p) {
+    const uint32_t heliColor = Argb(255, 180, 60, 60);
+    r.FillRectangle(p.x, p.y, cfg.helicopterWidth, cfg.helicopterHeight, heliColor);
+    r.FillRectangle(p.x - 15.f, p.y + cfg.helicopterHeight * 0.5f - 5.f, cfg.helicopterWidth + 30.f, 10.f, heliColor);
+}
+
+static void DrawShell(Renderer& r, Vec2 p) {
+    r.FillCircle(p.x, p.y, 6.f, Argb(255, 240, 240, 200));
+}
+
+static void DrawBomb(Renderer& r, const SimConfig& cfg, Vec2 p) {
+    r.FillCircle(p.x, p.y, cfg.bombRadius, Argb(255, 200, 80, 30));
+}
+
+static void DrawSceneLabel(Renderer& r, const SceneLabel& label) {
+    r.DrawLabel(label.text, label.x, label.y, label.w, label.h, label.sizePx, label.color);
+}
+
+void FitTankToSprites(SimConfig& cfg, const Image& body, const Image& barrel) {
+    cfg.tankWidth = static_cast<float>(body.width) * kTankSpriteScale;
+    cfg.tankHeight = static_cast<float>(body.height) * kTankSpriteScale;
+    cfg.turretLength = static_cast<float>(barrel.height) * kTankSpriteScale * 0.85f;
+}
+
+void BuildTankAssets(Renderer& r, const SimConfig& cfg, const Image& body, const Image& barrel,
+                     SpriteCache& bodyFrames, SpriteCache& barrelFrames, SceneAssets& assets) {
+    // One barrel frame per kBarrelStepDeg of turret travel.
+    const float kBarrelStepDeg = 1.f;
+    const float bodyW = static_cast<float>(body.width) * kTankSpriteScale;
+    const float bodyH = static_cast<float>(body.height) * kTankSpriteScale;
+    const float barrelW = static_cast<float>(barrel.width) * kTankSpriteScale;
+    const float barrelH = static_cast<float>(barrel.height) * kTankSpriteScale;
+    BuildSpriteCache(bodyFrames, body, -bodyW * 0.5f, -bodyH, bodyW, bodyH, 0.f, 0.f, 1.f);
+    BuildSpriteCache(barrelFrames, barrel, -barrelW * 0.5f, -barrelH, barrelW, barrelH,
+                     90.f - cfg.turretMaxAngleDeg, 90.f - cfg.turretMinAngleDeg, kBarrelStepDeg);
+    UploadSpriteCache(r, bodyFrames);
+    UploadSpriteCache(r, barrelFrames);
+    assets.tankBody = &bodyFrames;
+    assets.tankBarrel = &barrelFrames;
+}
+
+void DrawScene(Renderer& r, const RenderState& state, float alpha, const SceneAssets& assets, const ParticleSystem* particles) {
+    const SimConfig& cfg = state.cfg;
+    DrawBackground(r, state);
+    for (size_t t = 0; t < state.tanks.size(); ++t) {
+        DrawTank(r, state, t, TurretAngleAt(state, t, alpha), assets);
+    }
+
+    for (const auto& h : state.helicopters) {
+        DrawHelicopter(r, cfg, Lerp(h.prevPos, h.pos, alpha));
+    }
+    for (size_t i = 0; i < state.shellPos.size(); ++i) {
+        DrawShell(r, Lerp(state.shellPrev[i], state.shellPos[i], alpha));
+    }
+    for (size_t i = 0; i < state.bombPos.size(); ++i) {
+        DrawBomb(r, cfg, Lerp(state.bombPrev[i], state.bombPos[i], alpha));
+    }
+    if (particles) {
+        DrawParticles(r, *particles);
+    }
+
+    char hud[128];
+    FormatHud(state, hud, sizeof(hud));
+    DrawSceneLabel(r, HudLayout(cfg, hud));
+}
+
+void DrawAimOverlay(Renderer& r, const RenderState& state, float alpha, const AimAssist& aim) {
+    const SimConfig& cfg = state.cfg;
+    const ShotParams& shot = aim.solver.shot;
+
+    Vec2 arc[96];
+    const int n = SampleTrajectory(shot, TurretAngleAt(state, state.localTank, alpha), 1.f / 30.f, aim.solver.bounds, arc, 96);
+    const uint32_t arcColor = Argb(140, 240, 240, 200);
+    for (int i = 1; i < n; ++i) {
+        r.FillCircle(arc[i].x, arc[i].y, 2.f, arcColor);
+    }
+
+    const uint32_t aimColor = Argb(200, 120, 220, 255);
+    const float lineLength = cfg.turretLength + 40.f;
+    for (size_t k = 0; k < aim.solutions.size(); ++k) {
+        const AimSolution& sol = aim.solutions[k];
+        const AimTarget& target = aim.targets[k];
+        for (int i = 0; i < sol.count; ++i) {
+            const float rad = sol.angleDeg[i] * 3.14159265f / 180.f;
+            const Vec2 end = shot.pivot + Vec2{ std::cos(rad), -std::sin(rad) } * lineLength;
+            r.DrawLine(shot.pivot.x, shot.pivot.y, end.x, end.y, 2.f, aimColor);
+            r.FillCircle(target.x + target.vx * sol.time[i], target.y, 5.f, aimColor);
+        }
+    }
+}
+
+// Pixel bounds of the box (x0, y0)-(x1, y1), padded because GDI+
+// antialiasing reaches a pixel past the geometric edge.
+static IRect PaddedBounds(float x0, float y0, float x1, float y1) {
+    const int pad = 2;
+    IRect b;
+    b.x = static_cast<int>(std::floor(x0)) - pad;
+    b.y = static_cast<int>(std::floor(y0)) - pad;
+    b.w = static_cast<int>(std::ceil(x1)) + pad - b.x;
+    b.h = static_cast<int>(std::ceil(y1)) + pad - b.y;
+    return b;
+}
+
+static bool Overlaps(const IRect& a, const IRect& b) {
+    return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+static IRect FrameBounds(const SpriteCache& cache, float deg, Vec2 pivot) {
+    const SpriteFrame& frame = NearestFrame(cache, deg);
+    const float x = std::floor(pivot.x + 0.5f) + static_cast<float>(frame.offsetX);
+    const float y = std::floor(pivot.y + 0.5f) + static_cast<float>(frame.offsetY);
+    return PaddedBounds(x, y, x + static_cast<float>(frame.image.width), y + static_cast<float>(frame.image.height));
+}
+
+static IRect BarrelBounds(const RenderState& state, size_t tank, float turretAngleDeg, const SceneAssets& assets) {
+    const Vec2 base = TurretBase(state, tank);
+    if (assets.tankBody && assets.tankBarrel && !assets.tankBarrel->frames.empty()) {
+        return FrameBounds(*assets.tankBarrel, 90.f - turretAngleDeg, base);
+    }
+    const float rad = turretAngleDeg * 3.14159265f / 180.f;
+    const Vec2 tip = base + Vec2{ std::cos(rad), -std::sin(rad) } * state.cfg.turretLength;
+    // The barrel line is 10 px wide.
+    return PaddedBounds(std::min(base.x, tip.x) - 5.f, std::min(base.y, tip.y) - 5.f,
+                        std::max(base.x, tip.x) + 5.f, std::max(base.y, tip.y) + 5.f);
+}
+
+static IRect BodyBounds(const RenderState& state, size_t tank, const SceneAssets& assets) {
+    const SimConfig& cfg = state.cfg;
+    const Vec2 c = state.tanks[tank].center;
+    if (assets.tankBody && assets.tankBarrel && !assets.tankBody->frames.empty()) {
+        return FrameBounds(*assets.tankBody, 0.f, c);
+    }
+    return PaddedBounds(c.x - cfg.tankWidth * 0.5f, c.y - cfg.tankHeight, c.x + cfg.tankWidth * 0.5f, c.y);
+}
+
+static IRect LabelBounds(const SceneLabel& label) {
+    return PaddedBounds(label.x, label.y, label.x + label.w, label.y + label.h);
+}
+
+static const int kAimArcPoints = 96;
+
+// How many rectangles AimBounds can produce.
+static size_t AimBoundsCount(const AimAssist& aim) {
+    size_t n = kAimArcPoints - 1;
+    for (const AimSolution& sol : aim.solutions) {
+        n += 2 * static_cast<size_t>(sol.count);
+    }
+    return n;
+}
+
+// Most moving rectangles a frame can have: every helicopter, shell and
+// bomb in the pools, plus the aim overlay with two solutions per
+// helicopter.
+static size_t MaxMovingRects(const SimConfig& cfg) {
+    const size_t helicopters = static_cast<size_t>(std::max(cfg.helicopterCount, 0));
+    return helicopters + static_cast<size_t>(std::max(cfg.maxShells, 0)) + static_cast<size_t>(std::max(cfg.maxBombs, 0)) +
+           kAimArcPoints - 1 + 4 * helicopters;
+}
+
+// Everything DrawAimOverlay draws, piece by piece.
+static void AimBounds(const RenderState& state, float alpha, const AimAssist& aim, FrameArray<IRect>& out) {
+    const ShotParams& shot = aim.solver.shot;
+    Vec2 arc[kAimArcPoints];
+    const int n = SampleTrajectory(shot, TurretAngleAt(state, state.localTank, alpha), 1.f / 30.f, aim.solver.bounds, arc,
+                                   kAimArcPoints);
+    for (int i = 1; i < n; ++i) {
+        out.push_back(PaddedBounds(arc[i].x - 2.f, arc[i].y - 2.f, arc[i].x + 2.f, arc[i].y + 2.f));
+    }
+    const float lineLength = state.cfg.turretLength + 40.f;
+    for (size_t k = 0; k < aim.solutions.size(); ++k) {
+        const AimSolution& sol = aim.solutions[k];
+        const AimTarget& target = aim.targets[k];
+        for (int i = 0; i < sol.count; ++i) {
+            const float rad = sol.angleDeg[i] * 3.14159265f / 180.f;
+            const Vec2 end = shot.pivot + Vec2{ std::cos(rad), -std::sin(rad) } * lineLength;
+            out.push_back(PaddedBounds(std::min(shot.pivot.x, end.x) - 1.f, std::min(shot.pivot.y, end.y) - 1.f,
+                                       std::max(shot.pivot.x, end.x) + 1.f, std::max(shot.pivot.y, end.y) + 1.f));
+            const float x = target.x + target.vx * sol.time[i];
+            out.push_back(PaddedBounds(x - 5.f, target.y - 5.f, x + 5.f, target.y + 5.f));
+        }
+    }
+}
+
+// Marks the tiles under `rect` in a grid laid out like layers.tiles.
+static void MarkTiles(const SceneLayers& layers, std::vector<uint8_t>& tiles, const IRect& rect) {
+    const int x0 = std::max(rect.x, 0) / kTileSize;
+    const int y0 = std::max(rect.y, 0) / kTileSize;
+    const int x1 = std::min(rect.x + rect.w, layers.width);
+    const int y1 = std::min(rect.y + rect.h, layers.height);
+    if (x1 <= 0 || y1 <= 0) {
+        return;
+    }
+    for (int ty = y0; ty <= (y1 - 1) / kTileSize; ++ty) {
+        uint8_t* row = tiles.data() + static_cast<size_t>(ty) * layers.tilesX;
+        for (int tx = x0; tx <= (x1 - 1) / kTileSize; ++tx) {
+            row[tx] = 1;
+        }
+    }
+}
+
+static void MarkDirty(SceneLayers& layers, const IRect& rect) {
+    MarkTiles(layers, layers.tiles, rect);
+}
+
+// Particles are too many to keep a rectangle each: the tiles under them
+// this frame and last are marked instead.
+static void MarkParticles(SceneLayers& layers, const ParticleSystem* particles) {
+    if (layers.particleTiles.size() != layers.tiles.size()) {
+        layers.particleTiles.assign(layers.tiles.size(), 0);
+    }
+    for (size_t t = 0; t < layers.tiles.size(); ++t) {
+        layers.tiles[t] |= layers.particleTiles[t];
+        layers.particleTiles[t] = 0;
+    }
+    if (!particles) {
+        return;
+    }
+    for (const ParticlePool& pool : particles->pools) {
+        for (size_t i = 0; i < pool.count; ++i) {
+            MarkTiles(layers, layers.particleTiles, ParticleBounds(pool, i));
+        }
+    }
+    for (size_t t = 0; t < layers.tiles.size(); ++t) {
+        layers.tiles[t] |= layers.particleTiles[t];
+    }
+}
+
+// Turns the marked tiles into rectangles: runs along each tile row, stacked
+// with the run above when they span the same columns.
+static void CollectDirtyRects(SceneLayers& layers) {
+    layers.dirty.clear();
+    size_t marked = 0;
+    for (uint8_t t : layers.tiles) {
+        marked += t;
+    }
+    if (marked * 2 > layers.tiles.size()) {
+        layers.full = true;
+    }
+    for (int ty = 0; ty < layers.tilesY && !layers.full; ++ty) {
+        const uint8_t* row = layers.tiles.data() + static_cast<size_t>(ty) * layers.tilesX;
+        int tx = 0;
+        while (tx < layers.tilesX) {
+            if (!row[tx]) {
+                ++tx;
+                continue;
+            }
+            const int first = tx;
+            while (tx < layers.tilesX && row[tx]) {
+                ++tx;
+            }
+            IRect run;
+            run.x = first * kTileSize;
+            run.y = ty * kTileSize;
+            run.w = (tx - first) * kTileSize;
+            run.h = kTileSize;
+            bool stacked = false;
+            for (IRect& d : layers.dirty) {
+                if (d.x == run.x && d.w == run.w && d.y + d.h == run.y) {
+                    d.h += kTileSize;
+                    stacked = true;
+                    break;
+                }
+            }
+            if (!stacked) {
+                layers.dirty.push_back(run);
+            }
+        }
+        if (layers.dirty.size() > kMaxDirtyRects) {
+            layers.full = true;
+        }
+    }
+    if (layers.full) {
+        layers.dirty.assign(1, IRect{ 0, 0, layers.width, layers.height });
+    }
+    layers.dirtyPixels = 0;
+    for (IRect& d : layers.dirty) {
+        d.w = std::min(d.x + d.w, layers.width) - d.x;
+        d.h = std::min(d.y + d.h, layers.height) - d.y;
+        layers.dirtyPixels += static_cast<int64_t>(d.w) * d.h;
+    }
+}
+
+// The sky and ground never change, so they are rasterized once and copied
+// back under whatever moved.
+static void BuildBackground(Renderer& r, SceneLayers& layers, const RenderState& state) {
+    SoftRenderer soft(static_cast<int>(state.cfg.screenWidth), static_cast<int>(state.cfg.screenHeight));
+    DrawBackground(soft, state);
+    Image image;
+    image.width = soft.Width();
+    image.height = soft.Height();
+    image.pixels.assign(soft.Pixels(), soft.Pixels() + static_cast<size_t>(image.width) * image.height);
+    layers.background = r.CreateTexture(image);
+}
+
+void DrawSceneDirty(Renderer& r, SceneLayers& layers, FrameArena& frame, const RenderState& state, float alpha,
+                    const SceneAssets& assets, const AimAssist* aim, const ParticleSystem* particles,
+                    const SceneLabel* labels, int labelCount) {
+    const SimConfig& cfg = state.cfg;
+    if (layers.background == kNoTexture) {
+        BuildBackground(r, layers, state);
+        // Reserved once so the lists never grow mid-game.
+        layers.prevMoving.reserve(MaxMovingRects(cfg));
+        layers.moving.reserve(MaxMovingRects(cfg));
+        layers.full = true;
+    }
+    if (layers.width != r.Width() || layers.height != r.Height()) {
+        layers.width = r.Width();
+        layers.height = r.Height();
+        layers.tilesX = (layers.width + kTileSize - 1) / kTileSize;
+        layers.tilesY = (layers.height + kTileSize - 1) / kTileSize;
+        // A row of runs can land on top of the limit before it is checked.
+        layers.dirty.reserve(kMaxDirtyRects + static_cast<size_t>(layers.tilesX));
+        layers.full = true;
+    }
+    layers.tiles.assign(static_cast<size_t>(layers.tilesX) * layers.tilesY, 0);
+
+    // Moving things: restore under where they were and draw where they are.
+    FrameArray<IRect> heliRects = MakeFrameArray<IRect>(frame, state.helicopters.size());
+    FrameArray<IRect> shellRects = MakeFrameArray<IRect>(frame, state.shellPos.size());
+    FrameArray<IRect> bombRects = MakeFrameArray<IRect>(frame, state.bombPos.size());
+    FrameArray<IRect> aimRects = MakeFrameArray<IRect>(frame, aim ? AimBoundsCount(*aim) : 0);
+    for (const auto& h : state.helicopters) {
+        const Vec2 p = Lerp(h.prevPos, h.pos, alpha);
+        heliRects.push_back(PaddedBounds(p.x - 15.f, p.y, p.x + cfg.helicopterWidth + 15.f, p.y + cfg.helicopterHeight));
+    }
+    for (size_t i = 0; i < state.shellPos.size(); ++i) {
+        const Vec2 p = Lerp(state.shellPrev[i], state.shellPos[i], alpha);
+        shellRects.push_back(PaddedBounds(p.x - 6.f, p.y - 6.f, p.x + 6.f, p.y + 6.f));
+    }
+    for (size_t i = 0; i < state.bombPos.size(); ++i) {
+        const Vec2 p = Lerp(state.bombPrev[i], state.bombPos[i], alpha);
+        bombRects.push_back(PaddedBounds(p.x - cfg.bombRadius, p.y - cfg.bombRadius, p.x + cfg.bombRadius, p.y + cfg.bombRadius));
+    }
+    if (aim) {
+        AimBounds(state, alpha, *aim, aimRects);
+    }
+    layers.moving.clear();
+    layers.moving.insert(layers.moving.end(), heliRects.begin(), heliRects.end());
+    layers.moving.insert(layers.moving.end(), shellRects.begin(), shellRects.end());
+    layers.moving.insert(layers.moving.end(), bombRects.begin(), bombRects.end());
+    layers.moving.insert(layers.moving.end(), aimRects.begin(), aimRects.end());
+    for (const IRect& rect : layers.prevMoving) {
+        MarkDirty(layers, rect);
+    }
+    for (const IRect& rect : layers.moving) {
+        MarkDirty(layers, rect);
+    }
+    layers.prevMoving.swap(layers.moving);
+    MarkParticles(layers, particles);
+
+    // Tank bodies never move; only a barrel that turned is redrawn.
+    const size_t tankCount = state.tanks.size();
+    if (layers.barrelRects.size() != tankCount) {
+        layers.barrelRects.assign(tankCount, IRect{});
+        layers.barrelDegs.assign(tankCount, 0.f);
+        layers.bodyRects.assign(tankCount, IRect{});
+        layers.full = true;
+    }
+    for (size_t t = 0; t < tankCount; ++t) {
+        const float turretAngleDeg = TurretAngleAt(state, t, alpha);
+        const IRect barrel = BarrelBounds(state, t, turretAngleDeg, assets);
+        if (turretAngleDeg != layers.barrelDegs[t]) {
+            MarkDirty(layers, layers.barrelRects[t]);
+            MarkDirty(layers, barrel);
+        }
+        layers.barrelRects[t] = barrel;
+        layers.barrelDegs[t] = turretAngleDeg;
+        layers.bodyRects[t] = BodyBounds(state, t, assets);
+    }
+
+    if (UpdateHud(r, layers.hud, state)) {
+        MarkDirty(layers, LabelBounds(layers.hud.label.layout));
+    }
+    if (layers.labels.size() != static_cast<size_t>(labelCount)) {
+        layers.labels.resize(static_cast<size_t>(labelCount));
+        layers.full = true;
+    }
+    for (int i = 0; i < labelCount; ++i) {
+        CachedLabel& cached = layers.labels[i];
+        const IRect before = LabelBounds(cached.layout);
+        if (UpdateCachedLabel(r, cached, labels[i])) {
+            MarkDirty(layers, before);
+            MarkDirty(layers, LabelBounds(cached.layout));
+        }
+    }
+
+    CollectDirtyRects(layers);
+
+    // Redraw each rectangle in DrawScene's order, skipping whatever does
+    // not reach into it.
+    for (const IRect& rect : layers.dirty) {
+        r.SetClipRect(rect);
+        if (layers.full && (layers.width > cfg.screenWidth || layers.height > cfg.screenHeight)) {
+            // The window is larger than the background.
+            r.Clear(SkyColor());
+        }
+        r.CopyTextureRect(layers.background, rect);
+        for (size_t t = 0; t < tankCount; ++t) {
+            if (Overlaps(rect, layers.barrelRects[t]) || Overlaps(rect, layers.bodyRects[t])) {
+                DrawTank(r, state, t, layers.barrelDegs[t], assets);
+            }
+        }
+        for (size_t i = 0; i < state.helicopters.size(); ++i) {
+            if (Overlaps(rect, heliRects[i])) {
+                DrawHelicopter(r, cfg, Lerp(state.helicopters[i].prevPos, state.helicopters[i].pos, alpha));
+            }
+        }
+        for (size_t i = 0; i < state.shellPos.size(); ++i) {
+            if (Overlaps(rect, shellRects[i])) {
+                DrawShell(r, Lerp(state.shellPrev[i], state.shellPos[i], alpha));
+            }
+        }
+        for (size_t i = 0; i < state.bombPos.size(); ++i) {
+            if (Overlaps(rect, bombRects[i])) {
+                DrawBomb(r, cfg, Lerp(state.bombPrev[i], state.bombPos[i], alpha));
+            }
+        }
+        if (particles) {
+            // The renderer skips particles outside the clip rectangle.
+            DrawParticles(r, *particles);
+        }
+        if (Overlaps(rect, LabelBounds(layers.hud.label.layout))) {
+            DrawCachedLabel(r, layers.hud.label);
+        }
+        if (aim) {
+            for (const IRect& a : aimRects) {
+                if (Overlaps(rect, a)) {
+                    DrawAimOverlay(r, state, alpha, *aim);
+                    break;
+                }
+            }
+        }
+        for (const CachedLabel& cached : layers.labels) {
+            if (Overlaps(rect, LabelBounds(cached.layout))) {
+                DrawCachedLabel(r, cached);
+            }
+        }
+    }
+    r.ResetClip();
+    layers.full = false;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+// Draws the main_1 game world through a Renderer, so the window build and
+// the headless software renderer produce the same picture. Drawing reads a
+// RenderState rather than the World, so it can run on another thread.
+
+#include "frame_arena.h"
+#include "hud.h"
+#include "particles.h"
+#include "render.h"
+#include "render_state.h"
+#include "sprite_cache.h"
+#include "trajectory.h"
+
+#include <vector>
+
+// Baked tank sprites, uploaded to the renderer. The body frame's pivot is
+// the bottom center of the tank and the barrel's is TurretBase, keyed by
+// rotation (90 - turret angle). With either missing the tank is drawn as
+// a rectangle with a line for the barrel.
+struct SceneAssets {
+    const SpriteCache* tankBody = nullptr;
+    const SpriteCache* tankBarrel = nullptr;
+};
+
+// Source sprites are drawn at this scale.
+const float kTankSpriteScale = 1.f / 3.f;
+
+// Sizes the tank in `cfg` to match the sprites; call before InitWorld.
+void FitTankToSprites(SimConfig& cfg, const Image& body, const Image& barrel);
+// Bakes the body and barrel frames for the turret range in `cfg`, uploads
+// them and points `assets` at them.
+void BuildTankAssets(Renderer& r, const SimConfig& cfg, const Image& body, const Image& barrel,
+                     SpriteCache& bodyFrames, SpriteCache& barrelFrames, SceneAssets& assets);
+
+// alpha is the interpolation factor from RenderAlpha. Particles, when given,
+// go over the world and under the HUD.
+void DrawScene(Renderer& r, const RenderState& state, float alpha, const SceneAssets& assets, const ParticleSystem* particles);
+
+// Predicted arc for the current turret angle, plus the firing angles and
+// impact points from an up-to-date AimAssist.
+void DrawAimOverlay(Renderer& r, const RenderState& state, float alpha, const AimAssist& aim);
+
+// What DrawSceneDirty keeps between frames: the sky and ground rendered once
+// into a texture, the bounds of everything drawn over them last frame, and a
+// grid of 16 px tiles that collects this frame's damage.
+struct SceneLayers {
+    TextureId background = kNoTexture;
+    // Set to redraw and present the whole target next frame, e.g. after
+    // WM_PAINT or a resize.
+    bool full = true;
+    int width = 0;
+    int height = 0;
+    int tilesX = 0;
+    int tilesY = 0;
+    std::vector<uint8_t> tiles;
+    // Helicopters, shells, bombs and the aim overlay, which are redrawn
+    // every frame, last frame and this one. The per-kind lists only live
+    // for the frame and come from the frame arena.
+    std::vector<IRect> prevMoving;
+    std::vector<IRect> moving;
+    // Tiles under a particle last frame; particles are marked straight
+    // into the tile grid rather than kept as rectangles.
+    std::vector<uint8_t> particleTiles;
+    // The barrels and the labels are only redrawn when they change; the
+    // labels are kept as textures and blitted. One barrel and body per tank.
+    std::vector<IRect> barrelRects;
+    std::vector<float> barrelDegs;
+    std::vector<IRect> bodyRects;
+    Hud hud;
+    std::vector<CachedLabel> labels;
+    // Rectangles redrawn this frame; present these with EndFrameRects.
+    std::vector<IRect> dirty;
+    int64_t dirtyPixels = 0;
+};
+
+// Same picture as DrawScene + DrawAimOverlay (when aim is not null) + the
+// labels, drawn by restoring the background and redrawing the entities only
+// where something moved or changed since the previous call. Falls back to a
+// full redraw when the damage covers most of the screen. Scratch for the
+// frame comes from `frame`, which the caller resets after presenting.
+void DrawSceneDirty(Renderer& r, SceneLayers& layers, FrameArena& frame, const RenderState& state, float alpha,
+                    const SceneAssets& assets, const AimAssist* aim, const ParticleSystem* particles,
+                    const SceneLabel* labels, int labelCount);
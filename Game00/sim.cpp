@@ -0,0 +1,513 @@
+#include "sim.h"
+#include "profile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+static const size_t kGridMinHelicopters = 8;
+
+static void ResetHelicopter(World& world, Helicopter& h, int forceDir) {
+    const SimConfig& cfg = world.cfg;
+    h.dir = forceDir;
+    h.speed = UniformFloat(world.rng, cfg.helicopterMinSpeed, cfg.helicopterMaxSpeed);
+    h.pos.y = UniformFloat(world.rng, cfg.helicopterMinAlt, cfg.helicopterMaxAlt);
+    h.dropCooldown = 0.f;
+    if (h.dir > 0) {
+        h.pos.x = -cfg.helicopterWidth;
+    } else {
+        h.pos.x = cfg.screenWidth + cfg.helicopterWidth;
+    }
+    // Respawn is a teleport; do not interpolate across the screen.
+    h.prevPos = h.pos;
+    h.climb = 0.f;
+    ResetPilot(h, world.ai.step);
+}
+
+// Writes h back into the entity's components.
+static void StoreHelicopter(World& world, Entity e, const Helicopter& h) {
+    EntityStore& es = world.entities;
+    AddComponent(es.positions, e, Position{ h.pos, h.prevPos });
+    AddComponent(es.velocities, e, Velocity{ Vec2{ h.speed * static_cast<float>(h.dir), h.climb } });
+    AddComponent(es.colliders, e, Collider{ world.cfg.helicopterWidth, world.cfg.helicopterHeight });
+    AddComponent(es.dropCooldowns, e, DropCooldown{ h.dropCooldown });
+    AddComponent(es.pilots, e, h.pilot);
+}
+
+Entity SpawnHelicopter(World& world, const Helicopter& h) {
+    const Entity e = CreateEntity(world.entities);
+    StoreHelicopter(world, e, h);
+    world.helicopters.push_back(e);
+    return e;
+}
+
+void DestroyHelicopter(World& world, size_t k) {
+    DestroyEntity(world.entities, world.helicopters[k]);
+    world.helicopters.erase(world.helicopters.begin() + static_cast<std::ptrdiff_t>(k));
+    // Keep the AI's round-robin on the helicopter it was due to visit.
+    if (world.ai.cursor > k) {
+        --world.ai.cursor;
+    }
+}
+
+Helicopter HelicopterAt(const World& world, size_t k) {
+    const EntityStore& es = world.entities;
+    const Entity e = world.helicopters[k];
+    const Position& p = GetComponent(es.positions, e);
+    const Vec2 vel = GetComponent(es.velocities, e).vel;
+    Helicopter h;
+    h.pos = p.pos;
+    h.prevPos = p.prev;
+    h.speed = std::abs(vel.x);
+    h.dir = vel.x < 0.f ? -1 : 1;
+    h.climb = vel.y;
+    h.dropCooldown = GetComponent(es.dropCooldowns, e).seconds;
+    h.pilot = GetComponent(es.pilots, e);
+    return h;
+}
+
+static void RespawnHelicopter(World& world, Entity e, int forceDir) {
+    EntityStore& es = world.entities;
+    Helicopter h;
+    ResetHelicopter(world, h, forceDir);
+    GetComponent(es.positions, e) = Position{ h.pos, h.prevPos };
+    GetComponent(es.velocities, e).vel = Vec2{ h.speed * static_cast<float>(h.dir), h.climb };
+    GetComponent(es.dropCooldowns, e).seconds = h.dropCooldown;
+    GetComponent(es.pilots, e) = h.pilot;
+}
+
+static bool Positive(float v) {
+    return std::isfinite(v) && v > 0.f;
+}
+
+bool ValidSimConfig(const SimConfig& cfg) {
+    return Positive(cfg.tickRateHz) && Positive(cfg.screenWidth) && Positive(cfg.screenHeight) &&
+           Positive(cfg.helicopterWidth) && Positive(cfg.helicopterHeight) &&
+           std::isfinite(cfg.turretMinAngleDeg) && std::isfinite(cfg.turretMaxAngleDeg) &&
+           cfg.turretMinAngleDeg <= cfg.turretStartAngleDeg && cfg.turretStartAngleDeg <= cfg.turretMaxAngleDeg &&
+           cfg.maxShells >= 0 && cfg.maxShells <= kMaxSimPoolSize && cfg.maxBombs >= 0 && cfg.maxBombs <= kMaxSimPoolSize &&
+           cfg.helicopterCount >= 0 && cfg.helicopterCount <= kMaxSimHelicopters &&
+           cfg.tankCount >= 1 && cfg.tankCount <= kMaxSimTanks && cfg.aiBudget >= 0;
+}
+
+void InitWorld(World& world, const SimConfig& cfg, uint32_t seed) {
+    world.cfg = cfg;
+    const int tankCount = std::max(cfg.tankCount, 1);
+    world.tanks.assign(static_cast<size_t>(tankCount), Tank{});
+    for (int i = 0; i < tankCount; ++i) {
+        Tank& tank = world.tanks[i];
+        tank.center = TankHome(cfg, i);
+        tank.turretAngleDeg = cfg.turretStartAngleDeg;
+        tank.prevTurretAngleDeg = tank.turretAngleDeg;
+    }
+    world.impacts.clear();
+    world.lives = cfg.startLives;
+    world.score = 0;
+    world.gameOver = false;
+
+    InitProjectilePool(world.shells, static_cast<size_t>(cfg.maxShells));
+    InitProjectilePool(world.bombs, static_cast<size_t>(cfg.maxBombs));
+    ClearEntities(world.entities);
+    world.helicopters.clear();
+
+    // Helicopters fly from -2 widths to screenWidth + 2 widths; one cell per
+    // helicopter footprint keeps each box in at most 2x2 cells.
+    ConfigureGrid(world.heliGrid, -2.f * cfg.helicopterWidth, 0.f,
+                  cfg.screenWidth + 2.f * cfg.helicopterWidth, cfg.screenHeight,
+                  cfg.helicopterWidth, cfg.helicopterHeight);
+    // Reserve the worst case (every box spanning 2x2 cells) up front so the
+    // per-tick rebuild never has to grow a buffer.
+    const size_t heliCount = static_cast<size_t>(std::max(cfg.helicopterCount, 0));
+    world.helicopters.reserve(heliCount);
+    world.heliBoxes.reserve(heliCount);
+    world.heliHitShell.reserve(heliCount);
+    // A box swept over one step can touch up to 3x2 cells.
+    world.heliGrid.items.reserve(heliCount * 6);
+    world.impacts.clear();
+    world.impacts.reserve(heliCount + static_cast<size_t>(std::max(cfg.maxBombs, 0)));
+    InitAiScheduler(world.ai, cfg);
+
+    SeedPcg32(world.rng, seed);
+    const int flight = std::max(cfg.helicopterFlightSize, 1);
+    for (int i = 0; i < cfg.helicopterCount; ++i) {
+        Helicopter h{};
+        int dir = UniformInt(world.rng, 0, 1) ? 1 : -1;
+        ResetHelicopter(world, h, dir);
+        h.pos.y += i * 30.f;
+        if (i % flight != 0) {
+            // Wingmen start in their slot behind the flight's leader.
+            const Helicopter leader = HelicopterAt(world, static_cast<size_t>(i - i % flight));
+            h.dir = leader.dir;
+            h.speed = leader.speed;
+            h.pos = FormationSlot(cfg, leader, i % flight);
+            h.prevPos = h.pos;
+            ResetPilot(h, world.ai.step);
+        }
+        SpawnHelicopter(world, h);
+    }
+}
+
+Vec2 TankHome(const SimConfig& cfg, int i) {
+    const int tankCount = std::max(cfg.tankCount, 1);
+    return { cfg.screenWidth * static_cast<float>(i + 1) / static_cast<float>(tankCount + 1), cfg.screenHeight - 40.f };
+}
+
+Vec2 TurretBase(const World& world, size_t tank) {
+    const Vec2 center = world.tanks[tank].center;
+    return { center.x, center.y - world.cfg.tankHeight };
+}
+
+static Vec2 AngleDir(float angleDeg) {
+    const float rad = angleDeg * 3.14159265f / 180.f;
+    return { std::cos(rad), -std::sin(rad) };
+}
+
+Vec2 TurretDir(const World& world, size_t tank) {
+    return AngleDir(world.tanks[tank].turretAngleDeg);
+}
+
+Vec2 TurretTip(const World& world, size_t tank) {
+    return TurretBase(world, tank) + TurretDir(world, tank) * world.cfg.turretLength;
+}
+
+float TurretAngleAt(const World& world, size_t tank, float alpha) {
+    const Tank& t = world.tanks[tank];
+    return t.prevTurretAngleDeg + (t.turretAngleDeg - t.prevTurretAngleDeg) * alpha;
+}
+
+float TurnTurret(const SimConfig& cfg, float angleDeg, const SimInput& input, float dt) {
+    if (input.left) {
+        angleDeg = ClampValue(angleDeg + cfg.turretTurnRateDeg * dt, cfg.turretMinAngleDeg, cfg.turretMaxAngleDeg);
+    }
+    if (input.right) {
+        angleDeg = ClampValue(angleDeg - cfg.turretTurnRateDeg * dt, cfg.turretMinAngleDeg, cfg.turretMaxAngleDeg);
+    }
+    return angleDeg;
+}
+
+void UpdateEntities(World& world, float dt) {
+    const SimConfig& cfg = world.cfg;
+    EntityStore& es = world.entities;
+    IntegrateMotion(es, dt);
+    TickCooldowns(es, dt);
+
+    // Helicopters are the entities that drop bombs. Nothing below adds or
+    // removes components, so the pools stay where they are.
+    DropCooldown* cooldowns = es.dropCooldowns.dense.data();
+    const uint32_t* owners = es.dropCooldowns.owner.data();
+    const size_t count = es.dropCooldowns.dense.size();
+    const bool canDrop = !world.gameOver;
+    const Tank* tanks = world.tanks.data();
+    const size_t tankCount = world.tanks.size();
+    const float dropRange = cfg.tankWidth * 0.35f;
+    for (size_t slot = 0; slot < count; ++slot) {
+        const uint32_t index = owners[slot];
+        const Vec2 pos = es.positions.dense[es.positions.sparse[index]].pos;
+        const Collider box = es.colliders.dense[es.colliders.sparse[index]];
+        const float vx = es.velocities.dense[es.velocities.sparse[index]].vel.x;
+
+        // Bombs leave at rest vertically with a fifth of the helicopter's
+        // speed, so drop when the fall carries them onto a tank.
+        float heliCenterX = pos.x + box.w * 0.5f;
+        bool overTank = false;
+        for (size_t t = 0; t < tankCount && !overTank; ++t) {
+            const float fall = tanks[t].center.y - cfg.tankHeight - cfg.bombRadius - (pos.y + box.h);
+            const float fallSeconds = fall > 0.f && cfg.gravity > 0.f ? std::sqrt(2.f * fall / cfg.gravity) : 0.f;
+            const float landX = heliCenterX + vx * 0.2f * fallSeconds;
+            overTank = std::abs(landX - tanks[t].center.x) < dropRange;
+        }
+        if (canDrop && cooldowns[slot].seconds <= 0.f && overTank) {
+            SpawnProjectile(world.bombs, heliCenterX, pos.y + box.h, vx * 0.2f, 0.f);
+            cooldowns[slot].seconds = cfg.bombDropCooldown;
+        }
+
+        if (vx > 0.f && pos.x > cfg.screenWidth + box.w) {
+            RespawnHelicopter(world, Entity{ index, es.generations[index] }, -1);
+        } else if (vx < 0.f && pos.x + box.w < -box.w) {
+            RespawnHelicopter(world, Entity{ index, es.generations[index] }, 1);
+        }
+    }
+}
+
+void StepWorld(World& world, float dt, const SimInput& input) {
+    StepWorld(world, dt, &input, 1);
+}
+
+void StepWorld(World& world, float dt, const SimInput* inputs, size_t inputCount) {
+    CGAME_PROFILE_SCOPE(ZoneStep);
+    const SimConfig& cfg = world.cfg;
+    const float screenWidth = cfg.screenWidth;
+    const float screenHeight = cfg.screenHeight;
+
+    for (Tank& tank : world.tanks) {
+        tank.prevTurretAngleDeg = tank.turretAngleDeg;
+    }
+    SavePositions(world.entities);
+    world.impacts.clear();
+
+    for (size_t t = 0; t < world.tanks.size(); ++t) {
+        Tank& tank = world.tanks[t];
+        const SimInput input = t < inputCount ? inputs[t] : SimInput{};
+        tank.fireCooldown = std::max(0.f, tank.fireCooldown - dt);
+        tank.turretAngleDeg = TurnTurret(cfg, tank.turretAngleDeg, input, dt);
+    }
+
+    const float inf = std::numeric_limits<float>::infinity();
+    {
+        CGAME_PROFILE_SCOPE(ZoneShells);
+        IntegrateBallistic(world.shells, cfg.gravity, dt, CullBounds{ -50.f, screenWidth + 50.f, screenHeight });
+    }
+
+    // New shells leave the muzzle at the press, so they are added after the
+    // pool has moved and fly only the rest of the step, the same way the
+    // integration does. The swept hit test starts from the muzzle.
+    for (size_t t = 0; t < world.tanks.size(); ++t) {
+        Tank& tank = world.tanks[t];
+        const SimInput input = t < inputCount ? inputs[t] : SimInput{};
+        tank.fired = false;
+        if (input.fire && !tank.fireWasDown && tank.fireCooldown <= 0.f && !world.gameOver && !IsFull(world.shells)) {
+            const float pressed = dt * static_cast<float>(std::min<int>(input.firePhase, kFirePhases - 1)) / static_cast<float>(kFirePhases);
+            const Vec2 dir = AngleDir(TurnTurret(cfg, tank.prevTurretAngleDeg, input, pressed));
+            const Vec2 tip = TurretBase(world, t) + dir * cfg.turretLength;
+            const Vec2 vel = dir * cfg.projectileSpeed;
+            SpawnProjectile(world.shells, tip.x, tip.y, vel.x, vel.y);
+            const size_t i = world.shells.count - 1;
+            const float flight = dt - pressed;
+            world.shells.vy[i] += cfg.gravity * flight;
+            world.shells.x[i] += world.shells.vx[i] * flight;
+            world.shells.y[i] += world.shells.vy[i] * flight;
+            tank.fireCooldown = cfg.fireCooldown;
+            tank.fired = true;
+        }
+        tank.fireWasDown = input.fire;
+    }
+    {
+        CGAME_PROFILE_SCOPE(ZoneBombs);
+        IntegrateBallistic(world.bombs, cfg.gravity, dt, CullBounds{ -inf, inf, screenHeight + 50.f });
+    }
+
+    {
+        CGAME_PROFILE_SCOPE(ZoneAi);
+        RunHelicopterAi(world, dt);
+    }
+    {
+        CGAME_PROFILE_SCOPE(ZoneHelicopters);
+        UpdateEntities(world, dt);
+    }
+
+    if (!world.gameOver) {
+        CGAME_PROFILE_SCOPE(ZoneCollision);
+        // Rebuilding the grid has a fixed cost per cell; below a handful of
+        // helicopters the plain loop is cheaper (see bench_collision).
+        if (world.helicopters.size() < kGridMinHelicopters) {
+            CollideShellsBruteForce(world);
+        } else {
+            CollideShellsGrid(world);
+        }
+
+        // Bomb centers hit once the bomb's bottom reaches a tank's top; a
+        // bomb over two tanks hits the lower-numbered one.
+        ProjectileSoA& bombs = world.bombs;
+        for (const Tank& tank : world.tanks) {
+            const AABB tankBox{ tank.center.x - cfg.tankWidth * 0.5f, tank.center.y - cfg.tankHeight - cfg.bombRadius,
+                                tank.center.x + cfg.tankWidth * 0.5f, tank.center.y };
+            for (size_t i = 0; i < bombs.count; ++i) {
+                if (!IsLive(bombs, i)) {
+                    continue;
+                }
+                float toi = 0.f;
+                if (SweepSegmentAABB(bombs.prevX[i], bombs.prevY[i], bombs.x[i], bombs.y[i], tankBox, toi)) {
+                    world.impacts.push_back({ ImpactBombTank, bombs.prevX[i] + (bombs.x[i] - bombs.prevX[i]) * toi,
+                                              bombs.prevY[i] + (bombs.y[i] - bombs.prevY[i]) * toi, toi });
+                    KillProjectile(bombs, i);
+                    world.lives -= 1;
+                    if (world.lives <= 0) {
+                        world.gameOver = true;
+                    }
+                }
+            }
+        }
+    }
+
+    CGAME_PROFILE_SCOPE(ZoneCompaction);
+    CompactProjectiles(world.shells);
+    CompactProjectiles(world.bombs);
+}
+
+// Swept test of shell i against helicopter k over the last step, in the
+// helicopter's frame so its own motion is accounted for.
+static bool ShellHitsHeli(const Position& p, const Collider& c, const ProjectileSoA& shells, size_t i, float& toi) {
+    const AABB box{ 0.f, 0.f, c.w, c.h };
+    return SweepSegmentAABB(shells.prevX[i] - p.prev.x, shells.prevY[i] - p.prev.y,
+                            shells.x[i] - p.pos.x, shells.y[i] - p.pos.y, box, toi);
+}
+
+static void ApplyShellHit(World& world, size_t k, size_t shell, float toi) {
+    ProjectileSoA& shells = world.shells;
+    world.impacts.push_back({ ImpactShellHelicopter, shells.prevX[shell] + (shells.x[shell] - shells.prevX[shell]) * toi,
+                              shells.prevY[shell] + (shells.y[shell] - shells.prevY[shell]) * toi, toi });
+    KillProjectile(shells, shell);
+    world.score += 10;
+    const float vx = GetComponent(world.entities.velocities, world.helicopters[k]).vel.x;
+    RespawnHelicopter(world, world.helicopters[k], vx > 0.f ? -1 : 1);
+}
+
+int CollideShellsBruteForce(World& world) {
+    ProjectileSoA& shells = world.shells;
+    int hits = 0;
+    for (size_t k = 0; k < world.helicopters.size(); ++k) {
+        const Position p = GetComponent(world.entities.positions, world.helicopters[k]);
+        const Collider c = GetComponent(world.entities.colliders, world.helicopters[k]);
+        for (size_t i = 0; i < shells.count; ++i) {
+            float toi = 0.f;
+            if (IsLive(shells, i) && ShellHitsHeli(p, c, shells, i, toi)) {
+                ApplyShellHit(world, k, i, toi);
+                ++hits;
+                break;
+            }
+        }
+    }
+    return hits;
+}
+
+int CollideShellsGrid(World& world) {
+    const EntityStore& es = world.entities;
+    ProjectileSoA& shells = world.shells;
+    if (world.helicopters.empty() || shells.count == 0) {
+        return 0;
+    }
+
+    // Each box covers the helicopter at both ends of the step.
+    world.heliBoxes.resize(world.helicopters.size());
+    for (size_t k = 0; k < world.helicopters.size(); ++k) {
+        const Position& p = GetComponent(es.positions, world.helicopters[k]);
+        const Collider& c = GetComponent(es.colliders, world.helicopters[k]);
+        world.heliBoxes[k] = { std::min(p.pos.x, p.prev.x), std::min(p.pos.y, p.prev.y),
+                               std::max(p.pos.x, p.prev.x) + c.w,
+                               std::max(p.pos.y, p.prev.y) + c.h };
+    }
+    BuildGrid(world.heliGrid, world.heliBoxes.data(), world.heliBoxes.size());
+
+    // Walk the shells in ascending order and give each one to the lowest
+    // free helicopter it hits. Helicopters rank shells by index and shells
+    // rank helicopters by index, so this lands on the same unique stable
+    // matching as the helicopter-major brute-force loop.
+    const UniformGrid& grid = world.heliGrid;
+    const uint32_t none = 0xFFFFFFFFu;
+    world.heliHitShell.assign(world.helicopters.size(), none);
+    size_t freeHelis = world.helicopters.size();
+    for (size_t i = 0; i < shells.count && freeHelis > 0; ++i) {
+        if (!IsLive(shells, i)) {
+            continue;
+        }
+        // Every cell the shell's path passes through is inside this range.
+        const int c0 = GridCol(grid, std::min(shells.prevX[i], shells.x[i]));
+        const int c1 = GridCol(grid, std::max(shells.prevX[i], shells.x[i]));
+        const int r0 = GridRow(grid, std::min(shells.prevY[i], shells.y[i]));
+        const int r1 = GridRow(grid, std::max(shells.prevY[i], shells.y[i]));
+        uint32_t best = none;
+        for (int r = r0; r <= r1; ++r) {
+            for (int c = c0; c <= c1; ++c) {
+                const int cell = r * grid.cols + c;
+                // Cell items are in ascending helicopter order.
+                for (uint32_t j = grid.cellStart[cell]; j < grid.cellStart[cell + 1]; ++j) {
+                    const uint32_t k = grid.items[j];
+                    if (k >= best) {
+                        break;
+                    }
+                    float toi = 0.f;
+                    if (world.heliHitShell[k] == none &&
+                        ShellHitsHeli(GetComponent(es.positions, world.helicopters[k]), GetComponent(es.colliders, world.helicopters[k]), shells, i, toi)) {
+                        best = k;
+                        break;
+                    }
+                }
+            }
+        }
+        if (best != none) {
+            world.heliHitShell[best] = static_cast<uint32_t>(i);
+            --freeHelis;
+        }
+    }
+
+    // Apply hits in helicopter order so respawns draw from the RNG in the
+    // same sequence as the brute-force loop.
+    int hits = 0;
+    for (size_t k = 0; k < world.helicopters.size(); ++k) {
+        const uint32_t shell = world.heliHitShell[k];
+        if (shell == none) {
+            continue;
+        }
+        float toi = 0.f;
+        ShellHitsHeli(GetComponent(es.positions, world.helicopters[k]), GetComponent(es.colliders, world.helicopters[k]), shells, shell, toi);
+        ApplyShellHit(world, k, shell, toi);
+        ++hits;
+    }
+    return hits;
+}
+
+void InitStepper(FixedStepper& stepper, float tickRateHz) {
+    stepper.stepSeconds = 1.0 / static_cast<double>(tickRateHz);
+    stepper.accumulator = 0.0;
+}
+
+int TakeDueSteps(FixedStepper& stepper, double frameSeconds) {
+    stepper.accumulator += ClampValue(frameSeconds, 0.0, kMaxFrameSeconds);
+    const int due = static_cast<int>(stepper.accumulator / stepper.stepSeconds);
+    stepper.accumulator -= due * stepper.stepSeconds;
+    return due;
+}
+
+static uint64_t HashBytes(uint64_t h, const void* data, size_t size) {
+    // FNV-1a
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+static uint64_t HashFloat(uint64_t h, float v) {
+    uint32_t bits = 0;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return HashBytes(h, &bits, sizeof(bits));
+}
+
+uint64_t WorldChecksum(const World& world) {
+    uint64_t h = 14695981039346656037ull;
+    for (const Tank& tank : world.tanks) {
+        h = HashFloat(h, tank.turretAngleDeg);
+        h = HashFloat(h, tank.fireCooldown);
+    }
+    h = HashBytes(h, &world.lives, sizeof(world.lives));
+    h = HashBytes(h, &world.score, sizeof(world.score));
+    for (const ProjectileSoA* p : { &world.shells, &world.bombs }) {
+        for (size_t i = 0; i < p->count; ++i) {
+            h = HashFloat(h, p->x[i]);
+            h = HashFloat(h, p->y[i]);
+            h = HashFloat(h, p->vx[i]);
+            h = HashFloat(h, p->vy[i]);
+        }
+    }
+    for (size_t k = 0; k < world.helicopters.size(); ++k) {
+        const Helicopter heli = HelicopterAt(world, k);
+        h = HashFloat(h, heli.pos.x);
+        h = HashFloat(h, heli.pos.y);
+        h = HashFloat(h, heli.speed);
+        h = HashBytes(h, &heli.dir, sizeof(heli.dir));
+        h = HashFloat(h, heli.climb);
+        h = HashFloat(h, heli.dropCooldown);
+        h = HashFloat(h, heli.pilot.cruiseAlt);
+        h = HashFloat(h, heli.pilot.cruiseSpeed);
+        h = HashFloat(h, heli.pilot.targetAlt);
+        h = HashFloat(h, heli.pilot.targetSpeed);
+        h = HashFloat(h, heli.pilot.threatSeconds);
+        h = HashBytes(h, &heli.pilot.decidedStep, sizeof(heli.pilot.decidedStep));
+    }
+    h = HashBytes(h, &world.ai.step, sizeof(world.ai.step));
+    h = HashBytes(h, &world.ai.cursor, sizeof(world.ai.cursor));
+    h = HashBytes(h, &world.rng.state, sizeof(world.rng.state));
+    return h;
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+// Platform-independent game simulation (no Windows headers).
+// main_1.cpp drives it from the Win32 loop, headless.cpp drives it from the command line.
+
+#include <vector>
+#include <cstdint>
+
+#include "ai.h"
+#include "ecs.h"
+#include "projectiles.h"
+#include "grid.h"
+#include "rng.h"
+#include "vec2.h"
+
+template <typename T>
+inline T ClampValue(T value, T minValue, T maxValue) {
+    if (value < minValue) return minValue;
+    if (value > maxValue) return maxValue;
+    return value;
+}
+
+// Shells and bombs live in ProjectileSoA (projectiles.h); helicopters are
+// entities in World::entities (ecs.h). This is a helicopter flattened out of
+// its components, as the renderer, the aim assist and snapshots see it.
+// prevPos holds the position at the start of the last step so the renderer
+// can interpolate between fixed ticks.
+struct Helicopter {
+    Vec2 pos;
+    Vec2 prevPos;
+    float speed = 0.f;
+    int dir = 1; // +1 = left to right, -1 = right to left
+    float climb = 0.f; // vertical speed, + = down
+    float dropCooldown = 0.f;
+    Pilot pilot;
+};
+
+struct SimConfig {
+    // Physics runs in whole steps of 1 / tickRateHz seconds.
+    float tickRateHz = 120.f;
+
+    // Client area of the 960x720 prototype window.
+    float screenWidth = 944.f;
+    float screenHeight = 681.f;
+
+    // Tank footprint used for bomb hits and drop checks. The Win32 front-end
+    // overrides these with the sprite size once the images are loaded.
+    float tankWidth = 140.f;
+    float tankHeight = 40.f;
+    float turretLength = 150.f;
+
+    float turretMinAngleDeg = 10.f;
+    float turretMaxAngleDeg = 170.f;
+    float turretStartAngleDeg = 55.f;
+    float turretTurnRateDeg = 60.f;
+    float fireCooldown = 0.35f;
+
+    float gravity = 900.f;
+    float projectileSpeed = 800.f;
+    float bombRadius = 12.f;
+    float bombDropCooldown = 2.2f;
+
+    float helicopterWidth = 120.f;
+    float helicopterHeight = 40.f;
+    float helicopterMinAlt = 90.f;
+    float helicopterMaxAlt = 240.f;
+    float helicopterMinSpeed = 90.f;
+    float helicopterMaxSpeed = 160.f;
+    int helicopterCount = 3;
+    // Helicopters fly in flights of this many, spawn order; see ai.h.
+    int helicopterFlightSize = 3;
+    // Work units a step may spend on helicopter decisions (ai.h). A unit
+    // is one shell or grid cell checked against one helicopter, 10 to 20 ns.
+    int aiBudget = 2048;
+
+    // Fixed pool sizes; shots and drops beyond these are skipped.
+    int maxShells = 4096;
+    int maxBombs = 1024;
+
+    int startLives = 3;
+
+    // Tanks sharing the ground in co-op (net.h), spread evenly along it.
+    // Lives and score are shared.
+    int tankCount = 1;
+};
+
+// Steps are split into this many phases for timing a shot within one.
+static const int kFirePhases = 32;
+
+struct SimInput {
+    bool left = false;
+    bool right = false;
+    bool fire = false;
+    // When fire went down within the step, in 1/kFirePhases of it; 0 is the
+    // step's start. Only read on the step fire goes down. A shot leaves at
+    // that point of the step, at the angle the turret had turned to by then.
+    uint8_t firePhase = 0;
+};
+
+struct Tank {
+    Vec2 center;
+    float turretAngleDeg = 0.f;
+    float prevTurretAngleDeg = 0.f;
+    float fireCooldown = 0.f;
+    bool fireWasDown = false;
+    // Whether the last StepWorld fired a shell. Like World::impacts, an
+    // output of the step rather than part of the state.
+    bool fired = false;
+};
+
+enum ImpactKind {
+    ImpactShellHelicopter,
+    ImpactBombTank,
+};
+
+// A hit found by the swept tests. `time` is the fraction of the step at
+// which the projectile touched its target, (x, y) where it was then.
+struct Impact {
+    ImpactKind kind;
+    float x;
+    float y;
+    float time;
+};
+
+struct World {
+    SimConfig cfg;
+
+    // cfg.tankCount of them; tank i is driven by input i.
+    std::vector<Tank> tanks;
+    int lives = 0;
+    int score = 0;
+    bool gameOver = false;
+
+    ProjectileSoA shells;
+    ProjectileSoA bombs;
+    EntityStore entities;
+    // Helicopter entities (Position, Velocity, Collider, DropCooldown,
+    // Pilot) in spawn order, which is the order hits and respawns are
+    // resolved in, and flights are made up in.
+    std::vector<Entity> helicopters;
+    AiScheduler ai;
+
+    Pcg32 rng;
+
+    // Hits from the last StepWorld, in the order they were applied.
+    std::vector<Impact> impacts;
+
+    // Broadphase scratch, rebuilt every tick and kept to reuse its memory.
+    UniformGrid heliGrid;
+    std::vector<AABB> heliBoxes;
+    std::vector<uint32_t> heliHitShell;
+};
+
+// Limits on a config read from outside (save, replay, server). Well above
+// anything the game or the stress modes use.
+static const int kMaxSimPoolSize = 1 << 20;
+static const int kMaxSimHelicopters = 1 << 16;
+static const int kMaxSimTanks = 255;
+// False for a config InitWorld cannot be given: a step rate that is not
+// positive, pools or counts out of range, a negative AI budget, a turret
+// start angle outside its limits, or sizes that are not positive.
+bool ValidSimConfig(const SimConfig& cfg);
+void InitWorld(World& world, const SimConfig& cfg, uint32_t seed);
+// Drives tank 0; any other tanks sit idle.
+void StepWorld(World& world, float dt, const SimInput& input);
+// inputs[i] drives tank i; tanks from inputCount on sit idle.
+void StepWorld(World& world, float dt, const SimInput* inputs, size_t inputCount);
+
+// The entity part of StepWorld: runs the entity systems (motion,
+// cooldowns), then drops bombs from the helicopters that would
+// land them on a tank and respawns the ones that left the screen.
+void UpdateEntities(World& world, float dt);
+
+Entity SpawnHelicopter(World& world, const Helicopter& h);
+// Destroys helicopter k and removes it from world.helicopters; the ones
+// after it move down a place.
+void DestroyHelicopter(World& world, size_t k);
+// Helicopter k of world.helicopters.
+Helicopter HelicopterAt(const World& world, size_t k);
+
+// Shell-vs-helicopter hit resolution. Tests are swept: a shell hits when its
+// path over the last step, taken relative to the helicopter's own motion,
+// crosses the helicopter's box, so fast shells and low tick rates cannot
+// tunnel through. Each helicopter, in index order, takes the lowest-index
+// live shell that hits it and that an earlier helicopter did not take.
+// Both versions give identical results; StepWorld uses the grid once there
+// are enough helicopters to pay for the rebuild. Returns the number of hits
+// and appends them to world.impacts.
+int CollideShellsGrid(World& world);
+int CollideShellsBruteForce(World& world);
+
+// Frame time beyond this is dropped so a long hitch cannot queue up an
+// unbounded number of catch-up steps.
+static const double kMaxFrameSeconds = 0.25;
+
+// Fixed-timestep accumulator. Frame time goes in, whole steps come out, and
+// the remainder is what the renderer interpolates across.
+struct FixedStepper {
+    double stepSeconds = 1.0 / 120.0;
+    double accumulator = 0.0;
+};
+
+void InitStepper(FixedStepper& stepper, float tickRateHz);
+// Adds frameSeconds (clamped to kMaxFrameSeconds) and takes out as many whole
+// steps as it now holds. Returns that count; the caller runs the steps.
+int TakeDueSteps(FixedStepper& stepper, double frameSeconds);
+
+// Where tank i stands: the tanks are spread evenly along the ground.
+Vec2 TankHome(const SimConfig& cfg, int i);
+Vec2 TurretBase(const World& world, size_t tank);
+Vec2 TurretDir(const World& world, size_t tank);
+Vec2 TurretTip(const World& world, size_t tank);
+// Turret angle blended between the last two steps.
+float TurretAngleAt(const World& world, size_t tank, float alpha);
+// One step of turret travel under `input`, clamped to the turret's range.
+// Clients predicting their own turret (net.h) run the same function.
+float TurnTurret(const SimConfig& cfg, float angleDeg, const SimInput& input, float dt);
+
+// Order-sensitive hash of the full world state, for regression checks.
+uint64_t WorldChecksum(const World& world);
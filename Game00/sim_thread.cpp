@@ -0,0 +1,84 @@
+#include "sim_thread.h"
+
+#include <algorithm>
+#include <chrono>
+
+double SteadySeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void Publish(SimThread& sim, uint64_t tick, double now, double leftover, double stepMs) {
+    RenderState& state = sim.states.Back();
+    CaptureRenderState(sim.world, state);
+    CopyNewImpacts(state.impacts, sim.impactLog);
+    state.tick = tick;
+    state.publishSeconds = now;
+    state.leftoverSeconds = leftover;
+    state.simStepMs = stepMs;
+    sim.states.Publish();
+}
+
+static void SimThreadMain(SimThread* simPtr) {
+    SimThread& sim = *simPtr;
+    FixedStepper stepper;
+    InitStepper(stepper, sim.world.cfg.tickRateHz);
+    const double stepSeconds = stepper.stepSeconds;
+    double last = SteadySeconds();
+    uint64_t tick = 0;
+
+    while (!sim.quit.load(std::memory_order_relaxed)) {
+        const double now = SteadySeconds();
+        // Unpaced runs go in batches so publishing does not dominate.
+        int due = 64;
+        if (sim.paced) {
+            due = TakeDueSteps(stepper, now - last);
+        }
+        if (sim.maxTicks) {
+            due = static_cast<int>(std::min<uint64_t>(static_cast<uint64_t>(due), sim.maxTicks - tick));
+        }
+        last = now;
+
+        if (due > 0) {
+            const double t0 = SteadySeconds();
+            // The batch catches the world up to `now` less what is left in
+            // the accumulator.
+            const double batchStart = now - stepper.accumulator - due * stepSeconds;
+            for (int i = 0; i < due; ++i) {
+                sim.step(sim.user, sim.world, tick, batchStart + i * stepSeconds);
+                LogImpacts(sim.impactLog, sim.world, tick);
+                ++tick;
+            }
+            const double stepMs = (SteadySeconds() - t0) * 1e3 / due;
+            Publish(sim, tick, now, stepper.accumulator, stepMs);
+        }
+
+        if (sim.maxTicks && tick >= sim.maxTicks) {
+            break;
+        }
+        if (sim.paced) {
+            const double wait = stepSeconds - stepper.accumulator;
+            std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+        }
+    }
+    sim.finished.store(true, std::memory_order_release);
+}
+
+void StartSimThread(SimThread& sim) {
+    sim.quit.store(false);
+    sim.finished.store(false);
+    Publish(sim, 0, SteadySeconds(), 0.0, 0.0);
+    sim.thread = std::thread(SimThreadMain, &sim);
+}
+
+void StopSimThread(SimThread& sim) {
+    sim.quit.store(true);
+    if (sim.thread.joinable()) {
+        sim.thread.join();
+    }
+}
+
+float RenderAlpha(const RenderState& state, double nowSeconds) {
+    const double stepSeconds = 1.0 / static_cast<double>(state.cfg.tickRateHz);
+    const double alpha = (state.leftoverSeconds + (nowSeconds - state.publishSeconds)) / stepSeconds;
+    return static_cast<float>(std::min(std::max(alpha, 0.0), 1.0));
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+// Runs the simulation on its own thread and publishes a RenderState after
+// every batch of steps through a triple buffer, so input sampling and the
+// physics cadence do not depend on how long a frame takes to draw.
+
+#include "render_state.h"
+#include "triple_buffer.h"
+
+#include <atomic>
+#include <thread>
+
+struct SimThread {
+    World world;
+    // Advances world by one fixed step; called only on the simulation
+    // thread. It takes input itself, once per step. On the paced schedule
+    // the step stands for real time [startSeconds, startSeconds + one
+    // step), which input events are placed against (input.h).
+    void (*step)(void* user, World& world, uint64_t tick, double startSeconds) = nullptr;
+    void* user = nullptr;
+
+    // Real time at the world's tick rate, or as fast as possible in
+    // batches of steps.
+    bool paced = true;
+    // Stop after this many steps; 0 runs until StopSimThread.
+    uint64_t maxTicks = 0;
+
+    // Recent hits, copied into every published state.
+    ImpactLog impactLog;
+    TripleBuffer<RenderState> states;
+
+    std::atomic<bool> quit{ false };
+    std::atomic<bool> finished{ false };
+    std::thread thread;
+};
+
+// `world` must be initialized and `step` set. Publishes the initial state
+// before returning.
+void StartSimThread(SimThread& sim);
+void StopSimThread(SimThread& sim);
+
+// Interpolation factor for drawing `state` at steady-clock time nowSeconds.
+float RenderAlpha(const RenderState& state, double nowSeconds);
+
+double SteadySeconds();
@@ -0,0 +1,17 @@
+#pragma once
+
+// Compile-time SIMD selection shared by the hot loops. Defines
+// CGAME_SIMD_AVX2 when the compiler targets AVX2 (/arch:AVX2, -mavx2),
+// otherwise CGAME_SIMD_SSE2 on any x86-64 build, and neither on other
+// targets. Define CGAME_NO_SIMD to force the scalar paths.
+
+#if !defined(CGAME_NO_SIMD)
+#  if defined(__AVX2__)
+#    define CGAME_SIMD_AVX2 1
+#    define CGAME_SIMD_SSE2 1
+#    include <immintrin.h>
+#  elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define CGAME_SIMD_SSE2 1
+#    include <emmintrin.h>
+#  endif
+#endif
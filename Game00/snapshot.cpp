@@ -0,0 +1,190 @@
+#include "snapshot.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+static const uint32_t kSnapshotVersion = 3;
+
+template <typename T>
+static void Put(std::vector<uint8_t>& out, const T& value) {
+    const size_t at = out.size();
+    out.resize(at + sizeof(T));
+    std::memcpy(out.data() + at, &value, sizeof(T));
+}
+
+static void PutArray(std::vector<uint8_t>& out, const float* values, size_t count) {
+    const size_t at = out.size();
+    out.resize(at + count * sizeof(float));
+    if (count) {
+        std::memcpy(out.data() + at, values, count * sizeof(float));
+    }
+}
+
+struct SnapshotReader {
+    const uint8_t* at;
+    const uint8_t* end;
+    bool ok;
+};
+
+template <typename T>
+static void Get(SnapshotReader& r, T& value) {
+    if (!r.ok || static_cast<size_t>(r.end - r.at) < sizeof(T)) {
+        r.ok = false;
+        return;
+    }
+    std::memcpy(&value, r.at, sizeof(T));
+    r.at += sizeof(T);
+}
+
+static void GetArray(SnapshotReader& r, float* values, size_t count) {
+    if (!r.ok || static_cast<size_t>(r.end - r.at) / sizeof(float) < count) {
+        r.ok = false;
+        return;
+    }
+    if (count) {
+        std::memcpy(values, r.at, count * sizeof(float));
+    }
+    r.at += count * sizeof(float);
+}
+
+static void PutProjectiles(std::vector<uint8_t>& out, const ProjectileSoA& p) {
+    // Dead projectiles are compacted away at the end of every step, so
+    // [0, count) is all live.
+    Put(out, static_cast<uint32_t>(p.count));
+    PutArray(out, p.x.data(), p.count);
+    PutArray(out, p.y.data(), p.count);
+    PutArray(out, p.vx.data(), p.count);
+    PutArray(out, p.vy.data(), p.count);
+    PutArray(out, p.prevX.data(), p.count);
+    PutArray(out, p.prevY.data(), p.count);
+}
+
+static void GetProjectiles(SnapshotReader& r, ProjectileSoA& p) {
+    uint32_t count = 0;
+    Get(r, count);
+    if (!r.ok || count > p.capacity) {
+        r.ok = false;
+        return;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        SpawnProjectile(p, 0.f, 0.f, 0.f, 0.f);
+    }
+    GetArray(r, p.x.data(), count);
+    GetArray(r, p.y.data(), count);
+    GetArray(r, p.vx.data(), count);
+    GetArray(r, p.vy.data(), count);
+    GetArray(r, p.prevX.data(), count);
+    GetArray(r, p.prevY.data(), count);
+}
+
+size_t MaxSnapshotSize(const SimConfig& cfg) {
+    const size_t tank = sizeof(Vec2) + 3 * sizeof(float) + sizeof(uint8_t);
+    const size_t fixed = sizeof(uint32_t) + sizeof(SimConfig) + static_cast<size_t>(std::max(cfg.tankCount, 1)) * tank +
+                         sizeof(uint8_t) + 2 * sizeof(int) + sizeof(Pcg32) + 5 * sizeof(uint32_t);
+    const size_t projectiles = static_cast<size_t>(std::max(cfg.maxShells, 0) + std::max(cfg.maxBombs, 0)) * 6 * sizeof(float);
+    return fixed + static_cast<size_t>(std::max(cfg.helicopterCount, 0)) * sizeof(Helicopter) + projectiles;
+}
+
+void SaveSnapshot(const World& world, std::vector<uint8_t>& out) {
+    out.clear();
+    Put(out, kSnapshotVersion);
+    Put(out, world.cfg);
+    // InitWorld makes cfg.tankCount tanks, so the count is implied.
+    for (const Tank& tank : world.tanks) {
+        Put(out, tank.center);
+        Put(out, tank.turretAngleDeg);
+        Put(out, tank.prevTurretAngleDeg);
+        Put(out, tank.fireCooldown);
+        Put(out, static_cast<uint8_t>(tank.fireWasDown));
+    }
+    Put(out, world.lives);
+    Put(out, world.score);
+    Put(out, static_cast<uint8_t>(world.gameOver));
+    Put(out, world.rng);
+    Put(out, world.ai.step);
+    Put(out, world.ai.cursor);
+    Put(out, static_cast<uint32_t>(world.helicopters.size()));
+    for (size_t k = 0; k < world.helicopters.size(); ++k) {
+        Put(out, HelicopterAt(world, k));
+    }
+    PutProjectiles(out, world.shells);
+    PutProjectiles(out, world.bombs);
+}
+
+bool LoadSnapshot(World& world, const uint8_t* data, size_t size) {
+    SnapshotReader r{ data, data + size, true };
+    uint32_t version = 0;
+    Get(r, version);
+    if (!r.ok || version != kSnapshotVersion) {
+        return false;
+    }
+    SimConfig cfg{};
+    Get(r, cfg);
+    if (!r.ok || !ValidSimConfig(cfg)) {
+        return false;
+    }
+    // Sizes the pools and the broadphase for cfg; everything else is
+    // overwritten below.
+    InitWorld(world, cfg, 0);
+
+    for (Tank& tank : world.tanks) {
+        uint8_t fireWasDown = 0;
+        Get(r, tank.center);
+        Get(r, tank.turretAngleDeg);
+        Get(r, tank.prevTurretAngleDeg);
+        Get(r, tank.fireCooldown);
+        Get(r, fireWasDown);
+        tank.fireWasDown = fireWasDown != 0;
+    }
+    uint8_t gameOver = 0;
+    Get(r, world.lives);
+    Get(r, world.score);
+    Get(r, gameOver);
+    Get(r, world.rng);
+    Get(r, world.ai.step);
+    Get(r, world.ai.cursor);
+    world.gameOver = gameOver != 0;
+
+    uint32_t heliCount = 0;
+    Get(r, heliCount);
+    if (!r.ok || heliCount > static_cast<size_t>(r.end - r.at) / sizeof(Helicopter)) {
+        return false;
+    }
+    ClearEntities(world.entities);
+    world.helicopters.clear();
+    for (uint32_t k = 0; k < heliCount; ++k) {
+        Helicopter h;
+        Get(r, h);
+        SpawnHelicopter(world, h);
+    }
+    GetProjectiles(r, world.shells);
+    GetProjectiles(r, world.bombs);
+    return r.ok && r.at == r.end;
+}
+
+bool SaveSnapshotFile(const char* path, const World& world, std::vector<uint8_t>& scratch) {
+    SaveSnapshot(world, scratch);
+    FILE* f = std::fopen(path, "wb");
+    if (!f) {
+        return false;
+    }
+    const bool ok = std::fwrite(scratch.data(), 1, scratch.size(), f) == scratch.size();
+    return std::fclose(f) == 0 && ok;
+}
+
+bool LoadSnapshotFile(const char* path, World& world, std::vector<uint8_t>& scratch) {
+    FILE* f = std::fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+    scratch.clear();
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) {
+        scratch.insert(scratch.end(), buf, buf + n);
+    }
+    const bool ok = !std::ferror(f);
+    std::fclose(f);
+    return ok && LoadSnapshot(world, scratch.data(), scratch.size());
+}
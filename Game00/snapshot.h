@@ -0,0 +1,33 @@
+#pragma once
+
+// Full simulation state as a flat byte blob. Loading a snapshot and stepping
+// on gives exactly the same results as the world it was taken from. Only
+// state that carries over between steps is stored; broadphase scratch and
+// World::impacts are rebuilt by the next StepWorld. Projectile handles do
+// not survive a round trip.
+//
+// The layout is the host's (little-endian, IEEE floats); it is meant for
+// replays and save slots on the same kind of machine, not as an exchange
+// format.
+
+#include "sim.h"
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Upper bound on the snapshot size for a world created with `cfg`, for
+// reserving buffers up front.
+size_t MaxSnapshotSize(const SimConfig& cfg);
+
+// Replaces the contents of `out`, reusing its capacity.
+void SaveSnapshot(const World& world, std::vector<uint8_t>& out);
+// False (and `world` unspecified) if the blob is truncated or from another
+// version. A config that fails ValidSimConfig is refused before `world` is
+// touched.
+bool LoadSnapshot(World& world, const uint8_t* data, size_t size);
+
+// Save slots: the snapshot as a file. `scratch` holds the blob on the way.
+bool SaveSnapshotFile(const char* path, const World& world, std::vector<uint8_t>& scratch);
+// On failure `world` is unspecified, as with LoadSnapshot.
+bool LoadSnapshotFile(const char* path, World& world, std::vector<uint8_t>& scratch);
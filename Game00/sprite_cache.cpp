@@ -0,0 +1,181 @@
+#include "sprite_cache.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Bilinear fetch of a premultiplied texel at continuous texel coordinates;
+// outside the image is transparent. Returns channels as floats (a, r, g, b).
+static void SampleBilinear(const Image& img, float u, float v, float out[4]) {
+    u -= 0.5f;
+    v -= 0.5f;
+    const float fu = std::floor(u);
+    const float fv = std::floor(v);
+    const int u0 = static_cast<int>(fu);
+    const int v0 = static_cast<int>(fv);
+    const float tu = u - fu;
+    const float tv = v - fv;
+    out[0] = out[1] = out[2] = out[3] = 0.f;
+    for (int j = 0; j < 2; ++j) {
+        const int ty = v0 + j;
+        if (ty < 0 || ty >= img.height) {
+            continue;
+        }
+        const float wy = j ? tv : 1.f - tv;
+        for (int i = 0; i < 2; ++i) {
+            const int tx = u0 + i;
+            if (tx < 0 || tx >= img.width) {
+                continue;
+            }
+            const float wgt = wy * (i ? tu : 1.f - tu);
+            const uint32_t p = img.pixels[static_cast<size_t>(ty) * img.width + tx];
+            out[0] += wgt * static_cast<float>(p >> 24);
+            out[1] += wgt * static_cast<float>((p >> 16) & 0xFF);
+            out[2] += wgt * static_cast<float>((p >> 8) & 0xFF);
+            out[3] += wgt * static_cast<float>(p & 0xFF);
+        }
+    }
+}
+
+static uint32_t ToByte(float v) {
+    return static_cast<uint32_t>(std::min(255.f, std::max(0.f, v + 0.5f)));
+}
+
+static void BakeFrame(SpriteFrame& frame, const Image& src, float x, float y, float w, float h, float deg) {
+    const float rad = deg * 3.14159265f / 180.f;
+    const float c = std::cos(rad);
+    const float s = std::sin(rad);
+
+    // Bounds of the rotated rectangle around a pivot at (0, 0).
+    const float lx[4] = { x, x + w, x + w, x };
+    const float ly[4] = { y, y, y + h, y + h };
+    float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f;
+    for (int i = 0; i < 4; ++i) {
+        const float sx = lx[i] * c - ly[i] * s;
+        const float sy = lx[i] * s + ly[i] * c;
+        minX = std::min(minX, sx);
+        maxX = std::max(maxX, sx);
+        minY = std::min(minY, sy);
+        maxY = std::max(maxY, sy);
+    }
+    const int bx0 = static_cast<int>(std::floor(minX));
+    const int by0 = static_cast<int>(std::floor(minY));
+    const int bw = static_cast<int>(std::ceil(maxX)) - bx0;
+    const int bh = static_cast<int>(std::ceil(maxY)) - by0;
+
+    std::vector<uint32_t> pixels(static_cast<size_t>(bw) * static_cast<size_t>(bh), 0);
+    const float su = static_cast<float>(src.width) / w;
+    const float sv = static_cast<float>(src.height) / h;
+    static const float kSub[2] = { 0.25f, 0.75f };
+    const float margin = su + sv + 1.f;
+    const float srcW = static_cast<float>(src.width);
+    const float srcH = static_cast<float>(src.height);
+    int cropX0 = bw, cropY0 = bh, cropX1 = 0, cropY1 = 0;
+    for (int py = 0; py < bh; ++py) {
+        for (int px = 0; px < bw; ++px) {
+            // Skip pixels whose footprint misses the texture entirely; for
+            // diagonal angles that is most of the bounding box.
+            const float cx = static_cast<float>(bx0 + px) + 0.5f;
+            const float cy = static_cast<float>(by0 + py) + 0.5f;
+            const float cu = (cx * c + cy * s - x) * su;
+            const float cv = (-cx * s + cy * c - y) * sv;
+            if (cu < -margin || cv < -margin || cu > srcW + margin || cv > srcH + margin) {
+                continue;
+            }
+            float acc[4] = { 0.f, 0.f, 0.f, 0.f };
+            for (int sy = 0; sy < 2; ++sy) {
+                for (int sx = 0; sx < 2; ++sx) {
+                    const float qx = static_cast<float>(bx0 + px) + kSub[sx];
+                    const float qy = static_cast<float>(by0 + py) + kSub[sy];
+                    const float u = (qx * c + qy * s - x) * su;
+                    const float v = (-qx * s + qy * c - y) * sv;
+                    float smp[4];
+                    SampleBilinear(src, u, v, smp);
+                    for (int k = 0; k < 4; ++k) {
+                        acc[k] += smp[k];
+                    }
+                }
+            }
+            const uint32_t a = ToByte(acc[0] * 0.25f);
+            if (a == 0) {
+                continue;
+            }
+            const uint32_t r = std::min(a, ToByte(acc[1] * 0.25f));
+            const uint32_t g = std::min(a, ToByte(acc[2] * 0.25f));
+            const uint32_t b = std::min(a, ToByte(acc[3] * 0.25f));
+            pixels[static_cast<size_t>(py) * bw + px] = (a << 24) | (r << 16) | (g << 8) | b;
+            cropX0 = std::min(cropX0, px);
+            cropY0 = std::min(cropY0, py);
+            cropX1 = std::max(cropX1, px + 1);
+            cropY1 = std::max(cropY1, py + 1);
+        }
+    }
+
+    if (cropX0 >= cropX1) {
+        frame.image = Image();
+        frame.offsetX = 0;
+        frame.offsetY = 0;
+        return;
+    }
+    frame.image.width = cropX1 - cropX0;
+    frame.image.height = cropY1 - cropY0;
+    frame.image.pixels.resize(static_cast<size_t>(frame.image.width) * frame.image.height);
+    for (int py = 0; py < frame.image.height; ++py) {
+        const uint32_t* row = pixels.data() + static_cast<size_t>(cropY0 + py) * bw + cropX0;
+        std::copy(row, row + frame.image.width, frame.image.pixels.begin() + static_cast<size_t>(py) * frame.image.width);
+    }
+    frame.offsetX = bx0 + cropX0;
+    frame.offsetY = by0 + cropY0;
+}
+
+void BuildSpriteCache(SpriteCache& cache, const Image& src, float x, float y, float w, float h,
+                      float minDeg, float maxDeg, float stepDeg) {
+    cache.minDeg = minDeg;
+    cache.stepDeg = stepDeg > 0.f ? stepDeg : 1.f;
+    cache.wrap = maxDeg - minDeg >= 360.f - cache.stepDeg * 0.5f;
+    const int count = cache.wrap
+        ? std::max(1, static_cast<int>(std::lround(360.f / cache.stepDeg)))
+        : static_cast<int>(std::floor((maxDeg - minDeg) / cache.stepDeg + 0.5f)) + 1;
+    cache.frames.assign(static_cast<size_t>(std::max(count, 1)), SpriteFrame());
+    if (src.width <= 0 || src.height <= 0 || w <= 0.f || h <= 0.f) {
+        return;
+    }
+    for (size_t i = 0; i < cache.frames.size(); ++i) {
+        BakeFrame(cache.frames[i], src, x, y, w, h, minDeg + static_cast<float>(i) * cache.stepDeg);
+    }
+}
+
+void UploadSpriteCache(Renderer& r, SpriteCache& cache) {
+    for (SpriteFrame& frame : cache.frames) {
+        if (frame.image.width > 0) {
+            frame.texture = r.CreateTexture(frame.image);
+        }
+        std::vector<uint32_t>().swap(frame.image.pixels);
+    }
+}
+
+const SpriteFrame& NearestFrame(const SpriteCache& cache, float deg) {
+    const int count = static_cast<int>(cache.frames.size());
+    int index = static_cast<int>(std::floor((deg - cache.minDeg) / cache.stepDeg + 0.5f));
+    if (cache.wrap) {
+        index %= count;
+        if (index < 0) {
+            index += count;
+        }
+    } else {
+        index = std::min(std::max(index, 0), count - 1);
+    }
+    return cache.frames[static_cast<size_t>(index)];
+}
+
+void DrawCachedSprite(Renderer& r, const SpriteCache& cache, float deg, float pivotX, float pivotY) {
+    if (cache.frames.empty()) {
+        return;
+    }
+    const SpriteFrame& frame = NearestFrame(cache, deg);
+    if (frame.texture == kNoTexture) {
+        return;
+    }
+    r.BlitTexture(frame.texture,
+                  static_cast<int>(std::floor(pivotX + 0.5f)) + frame.offsetX,
+                  static_cast<int>(std::floor(pivotY + 0.5f)) + frame.offsetY);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+// Pre-rotated, pre-scaled sprite frames. Rotating and resampling a bitmap
+// every frame is the most expensive thing the game draws, so the rotations
+// are baked once at load time, quantized to a fixed angle step, and drawing
+// picks the nearest frame and blits it unscaled at an integer position.
+
+#include "render.h"
+
+#include <vector>
+
+struct SpriteFrame {
+    Image image;
+    // Top-left corner of the frame relative to the rotation pivot.
+    int offsetX = 0;
+    int offsetY = 0;
+    TextureId texture = kNoTexture;
+};
+
+struct SpriteCache {
+    float minDeg = 0.f;
+    float stepDeg = 1.f;
+    // Set when the frames cover a full turn; lookups then wrap around
+    // instead of clamping to the ends.
+    bool wrap = false;
+    std::vector<SpriteFrame> frames;
+};
+
+// Bakes `src` drawn into the local rectangle (x, y, w, h) around the pivot,
+// rotated by every multiple of stepDeg from minDeg to maxDeg. Angles follow
+// SpriteDraw::rotationDeg. Frames are filtered with 2x2 supersampled
+// bilinear and cropped to their visible pixels.
+void BuildSpriteCache(SpriteCache& cache, const Image& src, float x, float y, float w, float h,
+                      float minDeg, float maxDeg, float stepDeg);
+
+// Creates a texture per frame and drops the CPU copies of the pixels.
+void UploadSpriteCache(Renderer& r, SpriteCache& cache);
+
+const SpriteFrame& NearestFrame(const SpriteCache& cache, float deg);
+
+// Blits the frame nearest to `deg` with its pivot at (pivotX, pivotY).
+void DrawCachedSprite(Renderer& r, const SpriteCache& cache, float deg, float pivotX, float pivotY);
@@ -0,0 +1,293 @@
+#include "trajectory.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static const float kDegToRad = 3.14159265f / 180.f;
+
+ShotParams ShotParamsFor(const World& world, size_t tank) {
+    ShotParams shot;
+    shot.pivot = TurretBase(world, tank);
+    shot.muzzleLength = world.cfg.turretLength;
+    shot.speed = world.cfg.projectileSpeed;
+    shot.gravity = world.cfg.gravity;
+    shot.stepSeconds = 1.f / world.cfg.tickRateHz;
+    return shot;
+}
+
+Vec2 ShellPositionAt(const ShotParams& shot, float angleDeg, float t) {
+    const float c = std::cos(angleDeg * kDegToRad);
+    const float s = -std::sin(angleDeg * kDegToRad);
+    const float vy = shot.speed * s + shot.gravity * shot.stepSeconds * 0.5f;
+    return { shot.pivot.x + c * (shot.muzzleLength + shot.speed * t),
+             shot.pivot.y + s * shot.muzzleLength + vy * t + 0.5f * shot.gravity * t * t };
+}
+
+int SampleTrajectory(const ShotParams& shot, float angleDeg, float sampleSeconds,
+                     const CullBounds& bounds, Vec2* out, int maxPoints) {
+    int n = 0;
+    for (; n < maxPoints; ++n) {
+        const Vec2 p = ShellPositionAt(shot, angleDeg, static_cast<float>(n) * sampleSeconds);
+        if (p.x < bounds.minX || p.x > bounds.maxX || p.y > bounds.maxY) {
+            break;
+        }
+        out[n] = p;
+    }
+    return n;
+}
+
+void InitAimSolver(AimSolver& solver, const ShotParams& shot, float minDeg, float maxDeg, int samples,
+                   const CullBounds& bounds) {
+    samples = std::max(samples, 2);
+    solver.shot = shot;
+    solver.minDeg = minDeg;
+    solver.stepDeg = (maxDeg - minDeg) / static_cast<float>(samples - 1);
+    solver.samples = samples;
+    solver.bounds = bounds;
+
+    const size_t padded = (static_cast<size_t>(samples) + 7) & ~size_t(7);
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    solver.tipX.assign(padded, nan);
+    solver.tipY.assign(padded, nan);
+    solver.vx.assign(padded, nan);
+    solver.vy.assign(padded, nan);
+    solver.missRise.assign(padded, nan);
+    solver.missFall.assign(padded, nan);
+    for (int i = 0; i < samples; ++i) {
+        const float rad = (minDeg + static_cast<float>(i) * solver.stepDeg) * kDegToRad;
+        const float c = std::cos(rad);
+        const float s = -std::sin(rad);
+        solver.tipX[i] = shot.pivot.x + c * shot.muzzleLength;
+        solver.tipY[i] = shot.pivot.y + s * shot.muzzleLength;
+        solver.vx[i] = c * shot.speed;
+        solver.vy[i] = s * shot.speed + shot.gravity * shot.stepSeconds * 0.5f;
+    }
+}
+
+// Horizontal miss (shell x - target x) when the shell reaches the target's
+// altitude on the rising (fall = false) or falling branch. NaN when the arc
+// never gets that high. `time` receives the time of that crossing.
+static float MissAt(const ShotParams& shot, const AimTarget& target, float angleDeg, bool fall, float& time) {
+    const float rad = angleDeg * kDegToRad;
+    const float c = std::cos(rad);
+    const float s = -std::sin(rad);
+    const float tipX = shot.pivot.x + c * shot.muzzleLength;
+    const float tipY = shot.pivot.y + s * shot.muzzleLength;
+    const float vy = s * shot.speed + shot.gravity * shot.stepSeconds * 0.5f;
+    const float disc = vy * vy - 2.f * shot.gravity * (tipY - target.y);
+    if (!(disc >= 0.f)) {
+        time = 0.f;
+        return std::numeric_limits<float>::quiet_NaN();
+    }
+    const float root = std::sqrt(disc);
+    time = (-vy + (fall ? root : -root)) / shot.gravity;
+    return tipX + (c * shot.speed - target.vx) * time - target.x;
+}
+
+// Fills missRise / missFall for every candidate angle. A lane is NaN when
+// that branch has no crossing at a positive time.
+static void EvaluateMisses(AimSolver& solver, const AimTarget& target) {
+    const size_t n = solver.tipX.size();
+    const float g = solver.shot.gravity;
+    const float invG = 1.f / g;
+    const float* tipX = solver.tipX.data();
+    const float* tipY = solver.tipY.data();
+    const float* vx = solver.vx.data();
+    const float* vy = solver.vy.data();
+    float* rise = solver.missRise.data();
+    float* fall = solver.missFall.data();
+    const float qnan = std::numeric_limits<float>::quiet_NaN();
+    size_t i = 0;
+
+#if defined(CGAME_SIMD_AVX2)
+    const __m256 vG2 = _mm256_set1_ps(2.f * g);
+    const __m256 vInvG = _mm256_set1_ps(invG);
+    const __m256 vTy = _mm256_set1_ps(target.y);
+    const __m256 vTx = _mm256_set1_ps(target.x);
+    const __m256 vTvx = _mm256_set1_ps(target.vx);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 nan = _mm256_set1_ps(qnan);
+    for (; i + 8 <= n; i += 8) {
+        const __m256 ty = _mm256_loadu_ps(tipY + i);
+        const __m256 vyi = _mm256_loadu_ps(vy + i);
+        const __m256 disc = _mm256_sub_ps(_mm256_mul_ps(vyi, vyi), _mm256_mul_ps(vG2, _mm256_sub_ps(ty, vTy)));
+        const __m256 ok = _mm256_cmp_ps(disc, zero, _CMP_GE_OQ);
+        const __m256 root = _mm256_sqrt_ps(_mm256_max_ps(disc, zero));
+        const __m256 nvy = _mm256_sub_ps(zero, vyi);
+        const __m256 t1 = _mm256_mul_ps(_mm256_sub_ps(nvy, root), vInvG);
+        const __m256 t2 = _mm256_mul_ps(_mm256_add_ps(nvy, root), vInvG);
+        const __m256 rel = _mm256_sub_ps(_mm256_loadu_ps(vx + i), vTvx);
+        const __m256 base = _mm256_sub_ps(_mm256_loadu_ps(tipX + i), vTx);
+        const __m256 m1 = _mm256_add_ps(base, _mm256_mul_ps(rel, t1));
+        const __m256 m2 = _mm256_add_ps(base, _mm256_mul_ps(rel, t2));
+        const __m256 ok1 = _mm256_and_ps(ok, _mm256_cmp_ps(t1, zero, _CMP_GT_OQ));
+        const __m256 ok2 = _mm256_and_ps(ok, _mm256_cmp_ps(t2, zero, _CMP_GT_OQ));
+        _mm256_storeu_ps(rise + i, _mm256_blendv_ps(nan, m1, ok1));
+        _mm256_storeu_ps(fall + i, _mm256_blendv_ps(nan, m2, ok2));
+    }
+#elif defined(CGAME_SIMD_SSE2)
+    const __m128 vG2 = _mm_set1_ps(2.f * g);
+    const __m128 vInvG = _mm_set1_ps(invG);
+    const __m128 vTy = _mm_set1_ps(target.y);
+    const __m128 vTx = _mm_set1_ps(target.x);
+    const __m128 vTvx = _mm_set1_ps(target.vx);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 nan = _mm_set1_ps(qnan);
+    for (; i + 4 <= n; i += 4) {
+        const __m128 ty = _mm_loadu_ps(tipY + i);
+        const __m128 vyi = _mm_loadu_ps(vy + i);
+        const __m128 disc = _mm_sub_ps(_mm_mul_ps(vyi, vyi), _mm_mul_ps(vG2, _mm_sub_ps(ty, vTy)));
+        const __m128 ok = _mm_cmpge_ps(disc, zero);
+        const __m128 root = _mm_sqrt_ps(_mm_max_ps(disc, zero));
+        const __m128 nvy = _mm_sub_ps(zero, vyi);
+        const __m128 t1 = _mm_mul_ps(_mm_sub_ps(nvy, root), vInvG);
+        const __m128 t2 = _mm_mul_ps(_mm_add_ps(nvy, root), vInvG);
+        const __m128 rel = _mm_sub_ps(_mm_loadu_ps(vx + i), vTvx);
+        const __m128 base = _mm_sub_ps(_mm_loadu_ps(tipX + i), vTx);
+        const __m128 m1 = _mm_add_ps(base, _mm_mul_ps(rel, t1));
+        const __m128 m2 = _mm_add_ps(base, _mm_mul_ps(rel, t2));
+        const __m128 ok1 = _mm_and_ps(ok, _mm_cmpgt_ps(t1, zero));
+        const __m128 ok2 = _mm_and_ps(ok, _mm_cmpgt_ps(t2, zero));
+        _mm_storeu_ps(rise + i, _mm_or_ps(_mm_and_ps(ok1, m1), _mm_andnot_ps(ok1, nan)));
+        _mm_storeu_ps(fall + i, _mm_or_ps(_mm_and_ps(ok2, m2), _mm_andnot_ps(ok2, nan)));
+    }
+#endif
+    for (; i < n; ++i) {
+        const float disc = vy[i] * vy[i] - 2.f * g * (tipY[i] - target.y);
+        if (!(disc >= 0.f)) {
+            rise[i] = fall[i] = qnan;
+            continue;
+        }
+        const float root = std::sqrt(disc);
+        const float t1 = (-vy[i] - root) * invG;
+        const float t2 = (-vy[i] + root) * invG;
+        const float rel = vx[i] - target.vx;
+        const float base = tipX[i] - target.x;
+        rise[i] = t1 > 0.f ? base + rel * t1 : qnan;
+        fall[i] = t2 > 0.f ? base + rel * t2 : qnan;
+    }
+}
+
+// Regula falsi (Illinois variant) on a bracketed sign change.
+static float RefineAngle(const ShotParams& shot, const AimTarget& target, bool fall,
+                         float a0, float m0, float a1, float m1, float& time) {
+    int side = 0;
+    float a = a0;
+    for (int iter = 0; iter < 12; ++iter) {
+        a = (a0 * m1 - a1 * m0) / (m1 - m0);
+        const float m = MissAt(shot, target, a, fall, time);
+        if (!(m == m) || std::abs(m) < 1e-3f) {
+            break;
+        }
+        if ((m < 0.f) == (m1 < 0.f)) {
+            a1 = a;
+            m1 = m;
+            if (side == -1) {
+                m0 *= 0.5f;
+            }
+            side = -1;
+        } else {
+            a0 = a;
+            m0 = m;
+            if (side == 1) {
+                m1 *= 0.5f;
+            }
+            side = 1;
+        }
+    }
+    return a;
+}
+
+// Refines the sign change between candidates i and i + 1; true when the hit
+// point is inside the solver's bounds.
+static bool TryCrossing(const AimSolver& solver, const AimTarget& target, const float* miss, bool fall, int i,
+                        float& angleDeg, float& time) {
+    const float a0 = solver.minDeg + static_cast<float>(i) * solver.stepDeg;
+    angleDeg = RefineAngle(solver.shot, target, fall, a0, miss[i], a0 + solver.stepDeg, miss[i + 1], time);
+    const float hitX = target.x + target.vx * time;
+    return hitX >= solver.bounds.minX && hitX <= solver.bounds.maxX && target.y <= solver.bounds.maxY;
+}
+
+// First sign change of the branch that yields an in-bounds hit. Most
+// targets have none, so the scan tests four neighbouring pairs at a time.
+static bool FindHit(const AimSolver& solver, const AimTarget& target, const float* miss, bool fall,
+                    float& angleDeg, float& time) {
+    const int last = solver.samples - 1;
+    int i = 0;
+#if defined(CGAME_SIMD_SSE2)
+    for (; i + 4 <= last; i += 4) {
+        const __m128 m0 = _mm_loadu_ps(miss + i);
+        const __m128 m1 = _mm_loadu_ps(miss + i + 1);
+        int mask = _mm_movemask_ps(_mm_and_ps(_mm_cmpord_ps(m0, m1), _mm_xor_ps(m0, m1)));
+        while (mask) {
+            const int j = mask & 1 ? 0 : mask & 2 ? 1 : mask & 4 ? 2 : 3;
+            if (TryCrossing(solver, target, miss, fall, i + j, angleDeg, time)) {
+                return true;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i < last; ++i) {
+        const float m0 = miss[i];
+        const float m1 = miss[i + 1];
+        if (m0 == m0 && m1 == m1 && std::signbit(m0) != std::signbit(m1) &&
+            TryCrossing(solver, target, miss, fall, i, angleDeg, time)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SolveAim(AimSolver& solver, const AimTarget* targets, size_t count, AimSolution* out) {
+    for (size_t k = 0; k < count; ++k) {
+        const AimTarget& target = targets[k];
+        AimSolution& sol = out[k];
+        sol.count = 0;
+        EvaluateMisses(solver, target);
+        float angle = 0.f;
+        float time = 0.f;
+        if (FindHit(solver, target, solver.missRise.data(), false, angle, time)) {
+            sol.angleDeg[sol.count] = angle;
+            sol.time[sol.count] = time;
+            ++sol.count;
+        }
+        if (FindHit(solver, target, solver.missFall.data(), true, angle, time)) {
+            sol.angleDeg[sol.count] = angle;
+            sol.time[sol.count] = time;
+            ++sol.count;
+        }
+        if (sol.count == 2 && sol.time[1] < sol.time[0]) {
+            std::swap(sol.angleDeg[0], sol.angleDeg[1]);
+            std::swap(sol.time[0], sol.time[1]);
+        }
+    }
+}
+
+AimTarget HelicopterAimTarget(const SimConfig& cfg, const Helicopter& h) {
+    AimTarget t;
+    t.x = h.pos.x + cfg.helicopterWidth * 0.5f;
+    t.y = h.pos.y + cfg.helicopterHeight * 0.5f;
+    t.vx = h.speed * static_cast<float>(h.dir);
+    return t;
+}
+
+void InitAimAssist(AimAssist& aim, const World& world, size_t tank) {
+    const SimConfig& cfg = world.cfg;
+    const int samples = static_cast<int>(cfg.turretMaxAngleDeg - cfg.turretMinAngleDeg) + 1;
+    InitAimSolver(aim.solver, ShotParamsFor(world, tank), cfg.turretMinAngleDeg, cfg.turretMaxAngleDeg, samples,
+                  CullBounds{ -50.f, cfg.screenWidth + 50.f, cfg.screenHeight });
+    aim.targets.reserve(world.helicopters.size());
+    aim.solutions.reserve(world.helicopters.size());
+}
+
+void UpdateAimAssist(AimAssist& aim, const SimConfig& cfg, const std::vector<Helicopter>& helicopters) {
+    aim.targets.clear();
+    for (const auto& h : helicopters) {
+        aim.targets.push_back(HelicopterAimTarget(cfg, h));
+    }
+    aim.solutions.resize(aim.targets.size());
+    SolveAim(aim.solver, aim.targets.data(), aim.targets.size(), aim.solutions.data());
+}
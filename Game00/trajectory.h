@@ -0,0 +1,91 @@
+#pragma once
+
+// Closed-form shell trajectories and an aim solver.
+//
+// The positions match StepWorld exactly, not just the continuous parabola:
+// the integrator updates velocity before position, which is the same as a
+// true parabola launched with vy + gravity * dt / 2. After n steps a shell
+// fired at angle a is at
+//
+//   tip(a) + (vx, vy + g*dt/2) * t + (0, g*t^2/2),   t = n * dt
+//
+// Solving for many angles or targets is batched: per-angle constants are
+// precomputed once, and each target is evaluated over all candidate angles
+// four (SSE2) or eight (AVX2) at a time, then refined where the miss
+// distance changes sign.
+
+#include "sim.h"
+
+#include <vector>
+
+struct ShotParams {
+    Vec2 pivot;
+    float muzzleLength = 0.f;
+    float speed = 0.f;
+    float gravity = 0.f;
+    float stepSeconds = 0.f;
+};
+
+ShotParams ShotParamsFor(const World& world, size_t tank);
+
+// Where a shell fired at angleDeg is t seconds later, and its muzzle point.
+Vec2 ShellPositionAt(const ShotParams& shot, float angleDeg, float t);
+
+// Samples the arc every sampleSeconds until it leaves `bounds` (the same
+// culling IntegrateBallistic does) or maxPoints are written. Returns the
+// number of points.
+int SampleTrajectory(const ShotParams& shot, float angleDeg, float sampleSeconds,
+                     const CullBounds& bounds, Vec2* out, int maxPoints);
+
+// A point moving horizontally at constant speed, e.g. a helicopter center.
+struct AimTarget {
+    float x = 0.f;
+    float y = 0.f;
+    float vx = 0.f;
+};
+
+// Up to one rising and one falling hit, earliest first.
+struct AimSolution {
+    int count = 0;
+    float angleDeg[2] = { 0.f, 0.f };
+    float time[2] = { 0.f, 0.f };
+};
+
+struct AimSolver {
+    ShotParams shot;
+    float minDeg = 0.f;
+    float stepDeg = 1.f;
+    int samples = 0;
+    CullBounds bounds{ 0.f, 0.f, 0.f };
+    // Per candidate angle, padded to a multiple of 8 with NaN lanes.
+    std::vector<float> tipX;
+    std::vector<float> tipY;
+    std::vector<float> vx;
+    std::vector<float> vy; // includes the half-step correction
+    // Scratch: miss distance per angle for the rising and falling branch.
+    std::vector<float> missRise;
+    std::vector<float> missFall;
+};
+
+// `samples` candidate angles spread over [minDeg, maxDeg]; finer sampling
+// only matters for telling apart hits that are very close in angle. Hits
+// whose point lies outside `bounds` are rejected.
+void InitAimSolver(AimSolver& solver, const ShotParams& shot, float minDeg, float maxDeg, int samples,
+                   const CullBounds& bounds);
+
+void SolveAim(AimSolver& solver, const AimTarget* targets, size_t count, AimSolution* out);
+
+// Center of helicopter h, as seen from a shell fired this step.
+AimTarget HelicopterAimTarget(const SimConfig& cfg, const Helicopter& h);
+
+// Solutions for every helicopter in a world, refreshed each frame for the
+// aim-assist overlay or AI.
+struct AimAssist {
+    AimSolver solver;
+    std::vector<AimTarget> targets;
+    std::vector<AimSolution> solutions;
+};
+
+// One candidate per degree of turret travel, culled like shells in StepWorld.
+void InitAimAssist(AimAssist& aim, const World& world, size_t tank);
+void UpdateAimAssist(AimAssist& aim, const SimConfig& cfg, const std::vector<Helicopter>& helicopters);
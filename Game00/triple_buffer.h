@@ -0,0 +1,42 @@
+#pragma once
+
+// Lock-free single-producer, single-consumer triple buffer. The producer
+// fills Back() and publishes it; the consumer picks up the newest published
+// value with Acquire() and reads Front(). Neither side ever waits, and
+// values published faster than they are consumed are dropped, not queued.
+//
+// The three slots rotate through one atomic byte holding the index of the
+// middle slot plus a flag saying it has not been consumed yet.
+
+#include <atomic>
+#include <cstdint>
+
+template <typename T>
+class TripleBuffer {
+public:
+    T& Back() { return slots_[back_]; }
+
+    void Publish() {
+        back_ = middle_.exchange(static_cast<uint8_t>(back_ | kFresh), std::memory_order_acq_rel) & kIndex;
+    }
+
+    // True when a newer value was swapped into Front().
+    bool Acquire() {
+        if (!(middle_.load(std::memory_order_relaxed) & kFresh)) {
+            return false;
+        }
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndex;
+        return true;
+    }
+
+    const T& Front() const { return slots_[front_]; }
+
+private:
+    static const uint8_t kIndex = 3;
+    static const uint8_t kFresh = 4;
+
+    T slots_[3];
+    std::atomic<uint8_t> middle_{ 1 };
+    uint8_t back_ = 0;
+    uint8_t front_ = 2;
+};
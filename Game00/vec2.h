@@ -0,0 +1,28 @@
+#pragma once
+
+// 2D vector shared by the simulation, the entity store and the renderer.
+
+struct Vec2 {
+    float x = 0.f;
+    float y = 0.f;
+};
+
+inline Vec2 operator+(const Vec2& a, const Vec2& b) {
+    return { a.x + b.x, a.y + b.y };
+}
+
+inline Vec2 operator-(const Vec2& a, const Vec2& b) {
+    return { a.x - b.x, a.y - b.y };
+}
+
+inline Vec2 operator*(const Vec2& v, float s) {
+    return { v.x * s, v.y * s };
+}
+
+inline Vec2 operator*(float s, const Vec2& v) {
+    return v * s;
+}
+
+inline Vec2 Lerp(const Vec2& a, const Vec2& b, float t) {
+    return { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t };
+}